@@ -0,0 +1,393 @@
+#include "clustering.hpp"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
+static const float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+static const char DENDROGRAM_MAGIC[8] = "VPDGRAM";
+static const uint32_t DENDROGRAM_VERSION = 1;
+static const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+// position of the pair i < j in the condensed upper triangle
+static inline uint64_t CondensedIndex(uint64_t i, uint64_t j, uint64_t n)
+{
+	return i * n - i * (i + 1) / 2 + (j - i - 1);
+}
+
+static inline uint64_t PairIndex(unsigned i, unsigned j, unsigned n)
+{
+	return i < j ? CondensedIndex(i, j, n) : CondensedIndex(j, i, n);
+}
+
+// union find with path halving and union by size
+static unsigned FindRoot(std::vector<unsigned>& parent, unsigned i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+static bool UniteRoots(std::vector<unsigned>& parent, std::vector<unsigned>& size, unsigned a, unsigned b)
+{
+	a = FindRoot(parent, a);
+	b = FindRoot(parent, b);
+	if (a == b) return false;
+	if (size[a] < size[b]) std::swap(a, b);
+	parent[b] = a;
+	size[a] += size[b];
+	return true;
+}
+
+// the merges are found out of order -> stable, so a merge still follows the merges of its clusters if the distances tie
+static void SortMerges(std::vector<LineMerge>& merges)
+{
+	std::stable_sort(merges.begin(), merges.end(), [](const LineMerge& x, const LineMerge& y) { return x.distance < y.distance; });
+}
+
+Dendrogram HierarchicalClustering::Cluster(float* condensed, unsigned numLines, LinkageMethod linkage)
+{
+	if (linkage == LinkageMethod::SingleLinkage)
+	{
+		return SingleLinkage(condensed, numLines);
+	}
+	return NearestNeighborChain(condensed, numLines, linkage);
+}
+
+Dendrogram HierarchicalClustering::SingleLinkage(const float* condensed, unsigned numLines)
+{
+	Dendrogram dendrogram;
+	dendrogram.numLines = numLines;
+	if (numLines < 2) return dendrogram;
+	dendrogram.merges.reserve(numLines - 1);
+
+	// distance of every line outside of the tree to the tree and the tree line it belongs to
+	std::vector<float> distance(numLines, INFINITE_DISTANCE);
+	std::vector<unsigned> nearest(numLines, 0);
+	std::vector<char> inTree(numLines, 0);
+	unsigned added = 0;
+	for (unsigned step = 0; step + 1 < numLines; step++)
+	{
+		inTree[added] = 1;
+		unsigned next = 0;
+		float nextDistance = INFINITE_DISTANCE;
+		bool found = false;
+		for (unsigned line = 0; line < numLines; line++)
+		{
+			if (inTree[line]) continue;
+			const float d = condensed[PairIndex(added, line, numLines)];
+			if (d < distance[line])
+			{
+				distance[line] = d;
+				nearest[line] = added;
+			}
+			if (!found || distance[line] < nextDistance)
+			{
+				next = line;
+				nextDistance = distance[line];
+				found = true;
+			}
+		}
+		dendrogram.merges.push_back({ nearest[next], next, nextDistance });
+		added = next;
+	}
+
+	SortMerges(dendrogram.merges);
+	return dendrogram;
+}
+
+// distance between cluster k and the union of the clusters i and j, d = distance between i and j
+static inline float LanceWilliams(LinkageMethod linkage, double dki, double dkj, double d, double ni, double nj, double nk)
+{
+	switch (linkage)
+	{
+	case LinkageMethod::CompleteLinkage:			return (float)std::max(dki, dkj);
+	case LinkageMethod::AverageLinkage:				return (float)((ni * dki + nj * dkj) / (ni + nj));
+	case LinkageMethod::WeightedAverageLinkage:		return (float)(0.5 * (dki + dkj));
+	case LinkageMethod::WardLinkage:
+	{
+		// the matrix holds distances, Ward updates the squared ones
+		const double squared = ((nk + ni) * dki * dki + (nk + nj) * dkj * dkj - nk * d * d) / (nk + ni + nj);
+		return (float)std::sqrt(std::max(squared, 0.0));
+	}
+	default:										return (float)std::min(dki, dkj);
+	}
+}
+
+Dendrogram HierarchicalClustering::NearestNeighborChain(float* condensed, unsigned numLines, LinkageMethod linkage)
+{
+	Dendrogram dendrogram;
+	dendrogram.numLines = numLines;
+	if (numLines < 2) return dendrogram;
+	dendrogram.merges.reserve(numLines - 1);
+
+	// a cluster lives in the row of one of its lines, size 0 -> merged into another cluster
+	std::vector<unsigned> size(numLines, 1);
+	std::vector<unsigned> chain;
+	chain.reserve(numLines);
+	unsigned firstActive = 0;
+	for (unsigned step = 0; step + 1 < numLines; step++)
+	{
+		if (chain.empty())
+		{
+			while (size[firstActive] == 0) firstActive++;
+			chain.push_back(firstActive);
+		}
+
+		// follow the nearest neighbors until two clusters are the nearest neighbors of each other
+		unsigned x, y;
+		float distance;
+		while (true)
+		{
+			x = chain.back();
+			if (chain.size() > 1)
+			{
+				// prefer the previous cluster of the chain on ties, otherwise the chain could cycle
+				y = chain[chain.size() - 2];
+				distance = condensed[PairIndex(x, y, numLines)];
+			}
+			else
+			{
+				y = x;
+				distance = INFINITE_DISTANCE;
+			}
+
+			for (unsigned i = 0; i < x; i++)
+			{
+				if (size[i] == 0) continue;
+				const float d = condensed[CondensedIndex(i, x, numLines)];
+				if (d < distance || y == x)
+				{
+					distance = d;
+					y = i;
+				}
+			}
+			// the rest of the row is contiguous
+			const float* row = condensed + CondensedIndex(x, std::min(x + 1, numLines - 1), numLines);
+			for (unsigned i = x + 1; i < numLines; i++)
+			{
+				if (size[i] == 0) continue;
+				const float d = row[i - x - 1];
+				if (d < distance || y == x)
+				{
+					distance = d;
+					y = i;
+				}
+			}
+
+			if (chain.size() > 1 && y == chain[chain.size() - 2]) break;
+			chain.push_back(y);
+		}
+		chain.pop_back();
+		chain.pop_back();
+
+		// the union lives on in the row of y
+		dendrogram.merges.push_back({ x, y, distance });
+		const double nx = size[x];
+		const double ny = size[y];
+		size[x] = 0;
+		size[y] += (unsigned)nx;
+		for (unsigned k = 0; k < numLines; k++)
+		{
+			if (size[k] == 0 || k == y) continue;
+			float& dky = condensed[PairIndex(k, y, numLines)];
+			dky = LanceWilliams(linkage, condensed[PairIndex(k, x, numLines)], dky, distance, nx, ny, size[k]);
+		}
+	}
+
+	SortMerges(dendrogram.merges);
+	return dendrogram;
+}
+
+Dendrogram HierarchicalClustering::SingleLinkage(const LineGraphFile& graph)
+{
+	Dendrogram dendrogram;
+	if (!graph.IsOpen()) return dendrogram;
+	const unsigned numLines = (unsigned)graph.GetNumLines();
+	const unsigned k = graph.GetK();
+	dendrogram.numLines = numLines;
+
+	std::vector<LineMerge> edges;
+	edges.reserve((size_t)numLines * k);
+	for (unsigned line = 0; line < numLines; line++)
+	{
+		const uint32_t* neighbors = graph.GetNeighbors(line);
+		const float* distances = graph.GetDistances(line);
+		for (unsigned n = 0; n < k; n++)
+		{
+			if (neighbors[n] == LINEGRAPH_NO_NEIGHBOR || neighbors[n] >= numLines || neighbors[n] == line) continue;
+			edges.push_back({ std::min(line, (unsigned)neighbors[n]), std::max(line, (unsigned)neighbors[n]), distances[n] });
+		}
+	}
+	std::sort(edges.begin(), edges.end(), [](const LineMerge& x, const LineMerge& y)
+		{
+			if (x.distance != y.distance) return x.distance < y.distance;
+			return x.a != y.a ? x.a < y.a : x.b < y.b;
+		});
+
+	std::vector<unsigned> parent(numLines);
+	std::vector<unsigned> size(numLines, 1);
+	std::iota(parent.begin(), parent.end(), 0);
+	dendrogram.merges.reserve(numLines > 0 ? numLines - 1 : 0);
+	for (const LineMerge& edge : edges)
+	{
+		if (UniteRoots(parent, size, edge.a, edge.b))
+		{
+			dendrogram.merges.push_back(edge);
+			if (dendrogram.merges.size() + 1 == numLines) break;
+		}
+	}
+
+	// connect the remaining components to the first one
+	for (unsigned line = 1; line < numLines; line++)
+	{
+		if (UniteRoots(parent, size, 0, line))
+		{
+			dendrogram.merges.push_back({ 0, line, INFINITE_DISTANCE });
+		}
+	}
+	return dendrogram;
+}
+
+std::vector<unsigned> HierarchicalClustering::Cut(const Dendrogram& dendrogram, unsigned clusterSize)
+{
+	DendrogramCut cut;
+	return cut.Cut(dendrogram, clusterSize);
+}
+
+void DendrogramCut::Reset()
+{
+	mParent.clear();
+	mSize.clear();
+	mClusterOfRoot.clear();
+	mClusterMapping.clear();
+	mNumMerges = 0;
+}
+
+const std::vector<unsigned>& DendrogramCut::Cut(const Dendrogram& dendrogram, unsigned clusterSize)
+{
+	const unsigned numLines = dendrogram.numLines;
+	const size_t numMerges = clusterSize < numLines ? std::min(dendrogram.merges.size(), (size_t)(numLines - clusterSize)) : 0;
+
+	// merges can only be added -> start over if the cut needs less of them
+	if (mParent.size() != numLines || numMerges < mNumMerges)
+	{
+		mParent.resize(numLines);
+		mSize.assign(numLines, 1);
+		std::iota(mParent.begin(), mParent.end(), 0);
+		mNumMerges = 0;
+	}
+	for (; mNumMerges < numMerges; mNumMerges++)
+	{
+		UniteRoots(mParent, mSize, dendrogram.merges[mNumMerges].a, dendrogram.merges[mNumMerges].b);
+	}
+
+	const unsigned unassigned = std::numeric_limits<unsigned>::max();
+	mClusterOfRoot.assign(numLines, unassigned);
+	mClusterMapping.resize(numLines);
+	unsigned numClusters = 0;
+	for (unsigned line = 0; line < numLines; line++)
+	{
+		const unsigned root = FindRoot(mParent, line);
+		if (mClusterOfRoot[root] == unassigned)
+		{
+			mClusterOfRoot[root] = numClusters++;
+		}
+		mClusterMapping[line] = mClusterOfRoot[root];
+	}
+	return mClusterMapping;
+}
+
+static inline uint64_t HashRound(uint64_t lane, uint64_t word)
+{
+	lane += word * HASH_PRIME_2;
+	lane = (lane << 31) | (lane >> 33);
+	return lane * HASH_PRIME_1;
+}
+
+uint64_t DendrogramFile::Hash(const void* data, uint64_t size, uint64_t seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint64_t lanes[4] = { seed + HASH_PRIME_1 + HASH_PRIME_2, seed + HASH_PRIME_2, seed, seed - HASH_PRIME_1 };
+	uint64_t offset = 0;
+	for (; offset + 32 <= size; offset += 32)
+	{
+		uint64_t words[4];
+		memcpy(words, bytes + offset, sizeof(words));
+		for (int l = 0; l < 4; l++)
+		{
+			lanes[l] = HashRound(lanes[l], words[l]);
+		}
+	}
+	for (; offset < size; offset++)
+	{
+		lanes[offset & 3] = HashRound(lanes[offset & 3], bytes[offset]);
+	}
+
+	uint64_t hash = size;
+	for (int l = 0; l < 4; l++)
+	{
+		hash = HashRound(hash, lanes[l]);
+	}
+	hash ^= hash >> 29;
+	hash *= HASH_PRIME_1;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+std::string DendrogramFile::GetPath(const std::string& distanceMatrixPath, LinkageMethod linkage)
+{
+	return distanceMatrixPath + ".linkage" + std::to_string((int)linkage) + ".dendrogram";
+}
+
+bool DendrogramFile::Read(const std::string& path, uint64_t matrixHash, LinkageMethod linkage, Dendrogram& dendrogram)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open()) return false;
+
+	DendrogramHeader header;
+	if (!in.read((char*)&header, sizeof(header))) return false;
+	if (memcmp(header.magic, DENDROGRAM_MAGIC, sizeof(DENDROGRAM_MAGIC)) != 0 || header.version != DENDROGRAM_VERSION) return false;
+	if (header.linkage != (uint32_t)linkage || header.matrixHash != matrixHash || header.numLines == 0 || header.numMerges + 1 != header.numLines) return false;
+
+	Dendrogram result;
+	result.numLines = (unsigned)header.numLines;
+	result.merges.resize(header.numMerges);
+	if (!in.read((char*)result.merges.data(), header.numMerges * sizeof(LineMerge))) return false;
+	for (const LineMerge& merge : result.merges)
+	{
+		if (merge.a >= result.numLines || merge.b >= result.numLines) return false;
+	}
+	dendrogram = std::move(result);
+	return true;
+}
+
+bool DendrogramFile::Write(const std::string& path, uint64_t matrixHash, LinkageMethod linkage, const Dendrogram& dendrogram)
+{
+	DendrogramHeader header = {};
+	memcpy(header.magic, DENDROGRAM_MAGIC, sizeof(DENDROGRAM_MAGIC));
+	header.version = DENDROGRAM_VERSION;
+	header.linkage = (uint32_t)linkage;
+	header.numLines = dendrogram.numLines;
+	header.matrixHash = matrixHash;
+	header.numMerges = dendrogram.merges.size();
+
+	// write next to the final file and rename, so an interrupted write never leaves a truncated dendrogram
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) return false;
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)dendrogram.merges.data(), dendrogram.merges.size() * sizeof(LineMerge));
+		if (!out.good()) return false;
+	}
+	std::remove(path.c_str());
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
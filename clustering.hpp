@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "linegraph.hpp"
+
+// same ids as alglib::clusterizersetahcalgo, so the linkage stored by the scene keeps its meaning
+enum LinkageMethod {
+	CompleteLinkage = 0,
+	SingleLinkage = 1,
+	AverageLinkage = 2,				// unweighted (UPGMA)
+	WeightedAverageLinkage = 3,		// weighted (WPGMA)
+	WardLinkage = 4
+};
+
+// merge step of agglomerative clustering, each cluster is named by one of its lines
+struct LineMerge {
+	unsigned a;
+	unsigned b;
+	float distance;
+};
+
+// numLines - 1 merges sorted by distance. The first numLines - k merges give the clustering with k clusters.
+struct Dendrogram {
+	unsigned numLines = 0;
+	std::vector<LineMerge> merges;
+};
+
+// Agglomerative clustering on the condensed upper triangle of a distance matrix (see distancematrix.hpp), O(N^2) time.
+class HierarchicalClustering
+{
+public:
+	// single linkage reads the matrix only, all other methods overwrite it with the distances between the clusters
+	static Dendrogram Cluster(float* condensed, unsigned numLines, LinkageMethod linkage);
+	// minimum spanning tree of the complete graph (Prim), O(N) memory
+	static Dendrogram SingleLinkage(const float* condensed, unsigned numLines);
+	// nearest neighbor chain with Lance-Williams updates in place, needs a reducible linkage (complete, average, Ward)
+	static Dendrogram NearestNeighborChain(float* condensed, unsigned numLines, LinkageMethod linkage);
+	// minimum spanning forest of a line graph (Kruskal), components that the graph does not connect are merged last at an infinite distance
+	static Dendrogram SingleLinkage(const LineGraphFile& graph);
+
+	// cluster id 0 .. clusterSize - 1 of every line, numbered in the order of the first line of each cluster
+	static std::vector<unsigned> Cut(const Dendrogram& dendrogram, unsigned clusterSize);
+};
+
+// Cuts of one dendrogram for a changing cluster count (the cluster count slider).
+// The merges are already in merge order, so a cut is a union find replay of a prefix of them:
+// fewer clusters only apply the additional merges, more clusters replay from the start, O(N) either way.
+class DendrogramCut
+{
+public:
+	// call whenever the dendrogram changes
+	void Reset();
+	// cluster id 0 .. clusterSize - 1 of every line, numbered in the order of the first line of each cluster
+	const std::vector<unsigned>& Cut(const Dendrogram& dendrogram, unsigned clusterSize);
+
+private:
+	std::vector<unsigned> mParent;
+	std::vector<unsigned> mSize;
+	std::vector<unsigned> mClusterOfRoot;
+	std::vector<unsigned> mClusterMapping;
+	size_t mNumMerges = 0;				// merges in the union find
+};
+
+// Dendrograms stored next to their distance matrix, so a matrix is only clustered once per linkage:
+//   DendrogramHeader
+//   LineMerge merges[numMerges]
+// The content hash of the matrix is part of the header -> a recomputed matrix with the same name is clustered again.
+struct DendrogramHeader
+{
+	char magic[8];					// "VPDGRAM"
+	uint32_t version;
+	uint32_t linkage;				// LinkageMethod
+	uint64_t numLines;
+	uint64_t matrixHash;			// DendrogramFile::Hash of the distances
+	uint64_t numMerges;
+};
+
+class DendrogramFile
+{
+public:
+	// 64 bit content hash, four independent lanes so that hashing keeps up with reading the matrix
+	static uint64_t Hash(const void* data, uint64_t size, uint64_t seed = 0);
+	// sidecar path of a distance matrix for the linkage
+	static std::string GetPath(const std::string& distanceMatrixPath, LinkageMethod linkage);
+
+	// false if there is no file or it belongs to another matrix / linkage
+	static bool Read(const std::string& path, uint64_t matrixHash, LinkageMethod linkage, Dendrogram& dendrogram);
+	static bool Write(const std::string& path, uint64_t matrixHash, LinkageMethod linkage, const Dendrogram& dendrogram);
+};
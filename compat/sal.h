@@ -0,0 +1,157 @@
+// Empty SAL annotations for compilers without the Windows SDK (DirectXMath annotates its interface with them).
+// Only used outside of Windows, the include directory is added next to the DirectXMath headers.
+#pragma once
+
+#ifndef _In_
+#define _In_
+#endif
+#ifndef _In_opt_
+#define _In_opt_
+#endif
+#ifndef _In_z_
+#define _In_z_
+#endif
+#ifndef _In_opt_z_
+#define _In_opt_z_
+#endif
+#ifndef _Out_
+#define _Out_
+#endif
+#ifndef _Out_opt_
+#define _Out_opt_
+#endif
+#ifndef _Inout_
+#define _Inout_
+#endif
+#ifndef _Inout_opt_
+#define _Inout_opt_
+#endif
+#ifndef _Outptr_
+#define _Outptr_
+#endif
+#ifndef _Outptr_opt_
+#define _Outptr_opt_
+#endif
+#ifndef _Use_decl_annotations_
+#define _Use_decl_annotations_
+#endif
+#ifndef _Check_return_
+#define _Check_return_
+#endif
+#ifndef _Must_inspect_result_
+#define _Must_inspect_result_
+#endif
+#ifndef _Ret_maybenull_
+#define _Ret_maybenull_
+#endif
+#ifndef _Ret_notnull_
+#define _Ret_notnull_
+#endif
+#ifndef _Notnull_
+#define _Notnull_
+#endif
+#ifndef _Maybenull_
+#define _Maybenull_
+#endif
+#ifndef _Null_terminated_
+#define _Null_terminated_
+#endif
+#ifndef _Printf_format_string_
+#define _Printf_format_string_
+#endif
+#ifndef _Reserved_
+#define _Reserved_
+#endif
+#ifndef _In_reads_
+#define _In_reads_(x)
+#endif
+#ifndef _In_reads_opt_
+#define _In_reads_opt_(x)
+#endif
+#ifndef _In_reads_bytes_
+#define _In_reads_bytes_(x)
+#endif
+#ifndef _In_reads_bytes_opt_
+#define _In_reads_bytes_opt_(x)
+#endif
+#ifndef _Out_writes_
+#define _Out_writes_(x)
+#endif
+#ifndef _Out_writes_opt_
+#define _Out_writes_opt_(x)
+#endif
+#ifndef _Out_writes_all_
+#define _Out_writes_all_(x)
+#endif
+#ifndef _Out_writes_bytes_
+#define _Out_writes_bytes_(x)
+#endif
+#ifndef _Out_writes_bytes_opt_
+#define _Out_writes_bytes_opt_(x)
+#endif
+#ifndef _Out_writes_bytes_all_
+#define _Out_writes_bytes_all_(x)
+#endif
+#ifndef _Inout_updates_
+#define _Inout_updates_(x)
+#endif
+#ifndef _Inout_updates_opt_
+#define _Inout_updates_opt_(x)
+#endif
+#ifndef _Inout_updates_bytes_
+#define _Inout_updates_bytes_(x)
+#endif
+#ifndef _Inout_updates_all_
+#define _Inout_updates_all_(x)
+#endif
+#ifndef _Field_size_
+#define _Field_size_(x)
+#endif
+#ifndef _Field_size_opt_
+#define _Field_size_opt_(x)
+#endif
+#ifndef _Field_size_bytes_
+#define _Field_size_bytes_(x)
+#endif
+#ifndef _Analysis_assume_
+#define _Analysis_assume_(x)
+#endif
+#ifndef _Success_
+#define _Success_(x)
+#endif
+#ifndef _Pre_satisfies_
+#define _Pre_satisfies_(x)
+#endif
+#ifndef _Post_satisfies_
+#define _Post_satisfies_(x)
+#endif
+#ifndef _In_range_
+#define _In_range_(x)
+#endif
+#ifndef _Out_range_
+#define _Out_range_(x)
+#endif
+#ifndef _Deref_in_range_
+#define _Deref_in_range_(x)
+#endif
+#ifndef _Deref_out_range_
+#define _Deref_out_range_(x)
+#endif
+#ifndef _Ret_range_
+#define _Ret_range_(x)
+#endif
+#ifndef _When_
+#define _When_(x, y)
+#endif
+#ifndef _In_reads_to_ptr_
+#define _In_reads_to_ptr_(x, y)
+#endif
+#ifndef _Out_writes_to_
+#define _Out_writes_to_(x, y)
+#endif
+#ifndef _Out_writes_bytes_to_
+#define _Out_writes_bytes_to_(x, y)
+#endif
+#ifndef _Inout_updates_to_
+#define _Inout_updates_to_(x, y)
+#endif
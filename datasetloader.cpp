@@ -0,0 +1,196 @@
+#include "datasetloader.hpp"
+#include <chrono>
+
+DatasetLoader::DatasetLoader(const std::string& cacheDirectory, uint64_t cacheSize) :
+	mCacheDirectory(cacheDirectory),
+	mCacheSize(cacheSize),
+	mStage(Stage::Idle),
+	mCachedReady(false),
+	mFromCache(false),
+	mCachedTaken(false)
+{
+}
+
+DatasetLoader::~DatasetLoader()
+{
+	if (mWorker.joinable()) mWorker.join();
+}
+
+bool DatasetLoader::Start(const Request& request)
+{
+	if (IsLoading())
+	{
+		return false;
+	}
+	return Begin(request, NULL);
+}
+
+bool DatasetLoader::StartClustering(const Request& request, const LineGeometry& lineSet)
+{
+	if (IsLoading())
+	{
+		return false;
+	}
+
+	// copied here, the render thread keeps drawing and changing its own geometry
+	Request clustering = request;
+	clustering.path = lineSet.GetCurrentDataSet();
+	clustering.importance = lineSet.GetCurrentImportance();
+	clustering.scalarColor = lineSet.GetCurrentScalarColor();
+	std::unique_ptr<LineGeometry> geometry(new LineGeometry(clustering.path, clustering.distanceMatrixPath, clustering.method, clustering.totalNumCPs, clustering.clusterSize));
+	geometry->CopyLineSet(lineSet);
+	return Begin(clustering, std::move(geometry));
+}
+
+bool DatasetLoader::Begin(const Request& request, std::unique_ptr<LineGeometry> lineSet)
+{
+	if (mWorker.joinable()) mWorker.join();
+
+	// a result that was not taken is replaced
+	mGeometry.reset();
+	mCached.reset();
+	mCachedReady = false;
+	mFromCache = false;
+	mCachedTaken = false;
+	mStage = lineSet ? Stage::Clustering : Stage::Parsing;
+	mWorker = std::thread(&DatasetLoader::Load, this, request, std::move(lineSet));
+	return true;
+}
+
+float DatasetLoader::GetProgress() const
+{
+	const Stage stage = mStage;
+	if (stage == Stage::Idle) return 0.f;
+	return (float)(stage - Stage::Parsing) / (float)(Stage::Finished - Stage::Parsing);
+}
+
+std::string DatasetLoader::StageToString(Stage stage)
+{
+	switch (stage)
+	{
+	case Stage::Idle:			return "Idle";
+	case Stage::Parsing:		return "Parsing lines";
+	case Stage::Clustering:		return "Clustering";
+	case Stage::Buffers:		return "Building buffers";
+	case Stage::Finished:		return "Finished";
+	}
+	return "";
+}
+
+std::unique_ptr<LineGeometry> DatasetLoader::TakeGeometry(bool& completion)
+{
+	completion = false;
+	if (mCachedReady.exchange(false))
+	{
+		// finished in the meantime -> the cached vertex data is also in the result
+		if (mStage != Stage::Finished)
+		{
+			mCachedTaken = true;
+			return std::move(mCached);
+		}
+		mCached.reset();
+	}
+	if (mStage != Stage::Finished)
+	{
+		return NULL;
+	}
+	mWorker.join();
+	mStage = Stage::Idle;
+	// the buffers of the cached vertex data only fit if the result maps the same file
+	completion = mCachedTaken && mFromCache && mGeometry;
+	mCachedTaken = false;
+	return std::move(mGeometry);
+}
+
+std::unique_ptr<LineGeometry> DatasetLoader::WaitForGeometry(bool& completion)
+{
+	std::unique_ptr<LineGeometry> geometry = TakeGeometry(completion);
+	while (!geometry && IsLoading())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		geometry = TakeGeometry(completion);
+	}
+	// the worker may have finished between the last take and IsLoading
+	return geometry ? std::move(geometry) : TakeGeometry(completion);
+}
+
+// runs on the worker, only touches its own geometry
+void DatasetLoader::Load(const Request request, std::unique_ptr<LineGeometry> lineSet)
+{
+	const bool parse = !lineSet;
+	std::unique_ptr<LineGeometry> geometry = parse ? std::unique_ptr<LineGeometry>(new LineGeometry(request.path, request.distanceMatrixPath, request.method, request.totalNumCPs, request.clusterSize)) : std::move(lineSet);
+	bool fromCache = false;
+	try
+	{
+		if (request.meanLineSamples > 0)
+		{
+			geometry->SetMeanLineSamples(request.meanLineSamples);
+		}
+		const GeometryCacheKey key = { request.path, request.importance, request.scalarColor, request.distanceMatrixPath, request.linkage,
+			request.clusterSize, (int)request.method, request.totalNumCPs, geometry->GetMeanLineSamples() };
+
+		// prepared before -> the cached vertex data is drawn while the line set is loaded
+		bool cached = false;
+		VertexData cachedData = {};
+		if (!mCacheDirectory.empty())
+		{
+			std::unique_ptr<LineGeometry> vertexData(new LineGeometry(request.path, request.distanceMatrixPath, request.method, request.totalNumCPs, request.clusterSize));
+			vertexData->SetMeanLineSamples(geometry->GetMeanLineSamples());
+			if (vertexData->OpenGeometryCache(mCacheDirectory, key))
+			{
+				cached = true;
+				cachedData = vertexData->GetVertexData();
+				mCached = std::move(vertexData);
+				mCachedReady = true;
+			}
+		}
+
+		if (parse)
+		{
+			geometry->ParseLineData(request.path, request.importance, request.scalarColor);
+		}
+		if (geometry->GetTotalLineAmount() > 0)
+		{
+			mStage = Stage::Clustering;
+			if (!request.distanceMatrixPath.empty())
+			{
+				geometry->CalculateClusterReport(request.distanceMatrixPath, request.linkage);
+			}
+
+			// cluster count 0 -> all lines are shown
+			mStage = Stage::Buffers;
+			geometry->CalculateHierarchicalClustering();
+			if (cached && geometry->OpenGeometryCache(mCacheDirectory, key))
+			{
+				// the file may have been replaced in the meantime
+				const VertexData& data = geometry->GetVertexData();
+				fromCache = data.numVertices == cachedData.numVertices && data.numLineVertices == cachedData.numLineVertices
+					&& data.numControlPoints == cachedData.numControlPoints && data.numLines == cachedData.numLines;
+			}
+			else
+			{
+				geometry->LoadLineSet(geometry->GetClusteredObjectData());
+				if (!mCacheDirectory.empty())
+				{
+					if (geometry->WriteGeometryCache(mCacheDirectory, key))
+					{
+						GeometryCacheFile::Evict(mCacheDirectory, mCacheSize);
+					}
+				}
+			}
+		}
+		else
+		{
+			geometry.reset();
+		}
+	}
+	catch (...)
+	{
+		geometry.reset();
+	}
+
+	// unreadable dataset / matrix -> NULL, the current lines stay
+	mFromCache = fromCache && geometry;
+	mGeometry = std::move(geometry);
+	mStage = Stage::Finished;
+}
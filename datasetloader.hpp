@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include "linegeometry.hpp"
+
+// Parses and clusters a dataset on a worker thread while the viewer keeps drawing the current lines.
+// The render thread takes the finished geometry at a frame boundary and creates its gpu buffers (Lines(LineGeometry&&, ...)).
+// Configurations that were prepared before are in the geometry cache: their vertex data is handed out right away,
+// the line set and clustering follow as a completion once they are loaded (Lines::Restore).
+// A new distance matrix or linkage of the shown line set is a clustering-only job: the line set is copied instead of parsed.
+class DatasetLoader
+{
+public:
+	enum Stage {
+		Idle,
+		Parsing,		// line set -> mObject
+		Clustering,		// distance matrix / line graph -> dendrogram
+		Buffers,		// vertex data for the gpu buffers
+		Finished		// waits for TakeGeometry
+	};
+
+	struct Request {
+		std::string path;
+		std::string importance;
+		std::string scalarColor;
+		std::string distanceMatrixPath;		// empty -> no clustering
+		int linkage;
+		RepresentativeMethod method;
+		int totalNumCPs;
+		unsigned meanLineSamples;			// 0 -> default of LineGeometry
+		unsigned clusterSize;				// 0 -> all lines
+	};
+
+	// cacheDirectory: prepared vertex data of every configuration, empty -> no cache
+	// cacheSize: bytes of the cache files, the least recently used configurations are removed above it
+	DatasetLoader(const std::string& cacheDirectory, uint64_t cacheSize);
+	~DatasetLoader();
+	DatasetLoader(const DatasetLoader&) = delete;
+	DatasetLoader& operator=(const DatasetLoader&) = delete;
+
+	// false if the last dataset is still loading
+	bool Start(const Request& request);
+	// clusters the line set of lineSet again, path / importance / scalarColor of the request are taken from it
+	bool StartClustering(const Request& request, const LineGeometry& lineSet);
+	bool IsLoading() const { const Stage stage = mStage; return stage != Stage::Idle && stage != Stage::Finished; }
+	Stage GetStage() const { return mStage; }
+	// finished stages 0 .. 1
+	float GetProgress() const;
+	std::string StageToString(Stage stage);
+	// the loaded geometry once the worker is done, NULL before (or if loading failed).
+	// A cached configuration is handed out twice: first only its vertex data, then with completion = true
+	// -> same vertex data plus the line set, the gpu buffers of the first one can be kept.
+	// If the worker could not map the cache again it prepares the vertex data itself -> completion = false, new buffers.
+	std::unique_ptr<LineGeometry> TakeGeometry(bool& completion);
+	// blocks until TakeGeometry has a result (startup, there is nothing to draw before)
+	std::unique_ptr<LineGeometry> WaitForGeometry(bool& completion);
+
+private:
+	bool Begin(const Request& request, std::unique_ptr<LineGeometry> lineSet);
+	// lineSet: parsed line set of a clustering-only job, NULL -> parse request.path
+	void Load(const Request request, std::unique_ptr<LineGeometry> lineSet);
+
+	std::string mCacheDirectory;
+	uint64_t mCacheSize;
+	std::thread mWorker;
+	std::atomic<Stage> mStage;
+	std::unique_ptr<LineGeometry> mGeometry;	// set by the worker before mStage becomes Finished
+	std::unique_ptr<LineGeometry> mCached;		// set by the worker before mCachedReady becomes true
+	std::atomic<bool> mCachedReady;
+	bool mFromCache;							// set by the worker before mStage becomes Finished: mGeometry maps the same cache file as mCached
+	bool mCachedTaken;							// render thread only
+};
@@ -0,0 +1,59 @@
+#include "distancematrix.hpp"
+#include <cstring>
+#include <utility>
+
+DistanceMatrixFile::DistanceMatrixFile() :
+	mHeader(NULL),
+	mValues(NULL)
+{
+}
+
+DistanceMatrixFile::~DistanceMatrixFile()
+{
+	Close();
+}
+
+DistanceMatrixFile::DistanceMatrixFile(DistanceMatrixFile&& other) :
+	mFile(std::move(other.mFile)),
+	mHeader(other.mHeader),
+	mValues(other.mValues)
+{
+	other.mHeader = NULL;
+	other.mValues = NULL;
+}
+
+DistanceMatrixFile& DistanceMatrixFile::operator=(DistanceMatrixFile&& other)
+{
+	if (this != &other)
+	{
+		mFile = std::move(other.mFile);
+		mHeader = other.mHeader;
+		mValues = other.mValues;
+		other.mHeader = NULL;
+		other.mValues = NULL;
+	}
+	return *this;
+}
+
+bool DistanceMatrixFile::Open(const std::string& path)
+{
+	Close();
+	if (!mFile.Open(path) || mFile.GetSize() < sizeof(DistanceMatrixHeader)) { Close(); return false; }
+
+	// check the header and that the values lie inside of the file
+	const DistanceMatrixHeader* header = (const DistanceMatrixHeader*)mFile.GetData();
+	if (memcmp(header->magic, DISTANCEMATRIX_MAGIC, sizeof(DISTANCEMATRIX_MAGIC)) != 0 || header->version != DISTANCEMATRIX_VERSION || header->numLines == 0) { Close(); return false; }
+	const uint64_t numValues = header->numLines * (header->numLines - 1) / 2;
+	if (header->valuesOffset + numValues * sizeof(float) > mFile.GetSize()) { Close(); return false; }
+
+	mHeader = header;
+	mValues = (const float*)(mFile.GetData() + header->valuesOffset);
+	return true;
+}
+
+void DistanceMatrixFile::Close()
+{
+	mFile.Close();
+	mHeader = NULL;
+	mValues = NULL;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "mappedfile.hpp"
+#include "distancematrixformat.hpp"
+
+// Read-only memory mapping of a condensed distance matrix.
+class DistanceMatrixFile
+{
+public:
+	DistanceMatrixFile();
+	~DistanceMatrixFile();
+	DistanceMatrixFile(const DistanceMatrixFile&) = delete;
+	DistanceMatrixFile& operator=(const DistanceMatrixFile&) = delete;
+	DistanceMatrixFile(DistanceMatrixFile&& other);
+	DistanceMatrixFile& operator=(DistanceMatrixFile&& other);
+
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const { return mHeader != NULL; }
+
+	const DistanceMatrixHeader& GetHeader() const { return *mHeader; }
+	uint64_t GetNumLines() const { return mHeader->numLines; }
+	const float* GetValues() const { return mValues; }
+	// distance of the pair i < j
+	float GetDistance(uint64_t i, uint64_t j) const { return mValues[DistanceMatrixIndex(i, j, mHeader->numLines)]; }
+
+private:
+	MappedFile mFile;
+	const DistanceMatrixHeader* mHeader;
+	const float* mValues;
+};
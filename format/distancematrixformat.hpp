@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary condensed distance matrix (*.distb), written by the Transformer (raw_data/Transformer/DistanceMatrix.hpp)
+// and read by the viewer (distancematrix.hpp). The matrices are symmetric with a zero diagonal,
+// so only the upper triangle (i < j) is stored row by row in float32:
+//   DistanceMatrixHeader
+//   float values[numLines * (numLines - 1) / 2]		starts at valuesOffset (64 byte aligned)
+struct DistanceMatrixHeader
+{
+	char magic[8];					// "VPDISTB"
+	uint32_t version;
+	uint32_t normalized;			// importance / scalarColor were normalized before weighting
+	uint64_t numLines;
+	char metric[16];				// LineDistanceMetrics::ToString
+	float importanceWeight;
+	float scalarColorWeight;
+	uint64_t valuesOffset;			// byte offset from the start of the file
+	float farDistance;				// > 0 -> pairs beyond it store a lower bound instead of the exact distance
+};
+
+static const char DISTANCEMATRIX_MAGIC[8] = "VPDISTB";
+static const uint32_t DISTANCEMATRIX_VERSION = 1;
+
+// position of the pair i < j in the condensed upper triangle
+inline uint64_t DistanceMatrixIndex(const uint64_t i, const uint64_t j, const uint64_t numLines)
+{
+	return i * numLines - i * (i + 1) / 2 + (j - i - 1);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Sparse k-nearest-line graph (*.knn), written by the Transformer (raw_data/Transformer/LineGraph.hpp) and read by the viewer (linegraph.hpp).
+// Instead of all N^2 distances every line only keeps its k closest lines:
+//   LineGraphHeader
+//   uint32_t neighbors[numLines * k]		row i holds the neighbors of line i, closest first, LINEGRAPH_NO_NEIGHBOR for unused slots
+//   float distances[numLines * k]
+// Both blocks are 64 byte aligned.
+struct LineGraphHeader
+{
+	char magic[8];					// "VPKNNG"
+	uint32_t version;
+	uint32_t k;
+	uint64_t numLines;
+	char metric[16];				// LineDistanceMetrics::ToString
+	float importanceWeight;
+	float scalarColorWeight;
+	uint32_t normalized;
+	uint32_t numCandidates;			// lines with the closest centroids that were refined exactly
+	uint64_t neighborsOffset;		// byte offsets from the start of the file
+	uint64_t distancesOffset;
+};
+
+static const char LINEGRAPH_MAGIC[8] = "VPKNNG";
+static const uint32_t LINEGRAPH_VERSION = 1;
+static const uint32_t LINEGRAPH_NO_NEIGHBOR = 0xFFFFFFFF;
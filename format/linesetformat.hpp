@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary line set (*.lines), written by the Transformer (raw_data/Transformer/LineSet.hpp) and read by the viewer (lineset.hpp).
+// One file holds the geometry of all lines and any number of named per vertex properties,
+// so every importance / scalarColor combination of a dataset is read from the same file. All blocks are 64 byte aligned:
+//   LineSetHeader
+//   LineSetProperty[numProperties]
+//   uint64_t lineOffsets[numLines + 1]		first vertex of every line, the last entry is numVertices
+//   float positions[numVertices * 3]
+//   float values[numVertices]				one block per property
+struct LineSetHeader
+{
+	char magic[8];					// "VPLINES"
+	uint32_t version;
+	uint32_t numProperties;
+	uint64_t numLines;
+	uint64_t numVertices;
+	uint64_t lineOffsetsOffset;		// byte offsets from the start of the file
+	uint64_t positionsOffset;
+};
+
+struct LineSetProperty
+{
+	char name[48];					// NUL-terminated
+	uint64_t valuesOffset;
+	float min;
+	float max;
+};
+
+static const char LINESET_MAGIC[8] = "VPLINES";
+static const uint32_t LINESET_VERSION = 1;
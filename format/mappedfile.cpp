@@ -0,0 +1,180 @@
+#include "mappedfile.hpp"
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+	if (this != &other)
+	{
+		Close();
+		mData = other.mData;
+		mSize = other.mSize;
+		other.mData = nullptr;
+		other.mSize = 0;
+#if defined(_WIN32)
+		mFile = other.mFile;
+		mMapping = other.mMapping;
+		other.mFile = nullptr;
+		other.mMapping = nullptr;
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+	return Map(path, false);
+}
+
+bool MappedFile::OpenCopy(const std::string& path)
+{
+	return Map(path, true);
+}
+
+#if defined(_WIN32)
+bool MappedFile::Map(const std::string& path, bool copyOnWrite)
+{
+	Close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = (char*)data;
+	mSize = size.QuadPart;
+	return true;
+}
+
+bool MappedFile::Create(const std::string& path, uint64_t size)
+{
+	Close();
+	if (size == 0) return false;
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	// the mapping grows the file to its size
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = (char*)data;
+	mSize = size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData) UnmapViewOfFile(mData);
+	if (mMapping) CloseHandle(mMapping);
+	if (mFile) CloseHandle(mFile);
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = nullptr;
+	mSize = 0;
+}
+#else
+bool MappedFile::Map(const std::string& path, bool copyOnWrite)
+{
+	Close();
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)info.st_size, copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);	// the mapping keeps its own reference
+	if (data == MAP_FAILED) return false;
+
+	mData = (char*)data;
+	mSize = (uint64_t)info.st_size;
+	return true;
+}
+
+bool MappedFile::Create(const std::string& path, uint64_t size)
+{
+	Close();
+	if (size == 0) return false;
+	int file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0) return false;
+	if (ftruncate(file, (off_t)size) != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	close(file);
+	if (data == MAP_FAILED) return false;
+
+	mData = (char*)data;
+	mSize = size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData) munmap(mData, (size_t)mSize);
+	mData = nullptr;
+	mSize = 0;
+}
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Memory mapping of a whole file, used by the viewer (line sets, distance matrices, graphs, geometry caches)
+// and the Transformer (Amira files, bricked field caches, the files it writes). Untouched pages are read lazily by the os.
+// Moving hands the mapping over, its address stays the same.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+
+	// Maps the file read-only. Returns false if it can not be opened or is empty.
+	bool Open(const std::string& path);
+	// Maps the file copy-on-write: the pages can be written without ever changing the file.
+	bool OpenCopy(const std::string& path);
+	// Creates (or truncates) the file with the given size and maps it shared, the written pages end up in the file.
+	bool Create(const std::string& path, uint64_t size);
+	void Close();
+
+	bool IsOpen() const { return mData != nullptr; }
+	const char* GetData() const { return mData; }
+	char* GetData() { return mData; }
+	uint64_t GetSize() const { return mSize; }
+
+private:
+	bool Map(const std::string& path, bool copyOnWrite);
+
+	char* mData = nullptr;
+	uint64_t mSize = 0;
+#if defined(_WIN32)
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#endif
+};
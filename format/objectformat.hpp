@@ -0,0 +1,227 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include "mappedfile.hpp"
+
+// OBJ line files (v / vt / l records), the two tex coords of a vertex are its importance and scalarColor.
+// Parsed by the viewer (objectfile.cpp) and the Transformer (raw_data/Transformer/ObjectReader.cpp) through this header.
+// The file is mapped and split into chunks at line breaks, the chunks are parsed in parallel and their
+// l records are stitched into one flat store afterwards.
+// Line breaks may be LF or CRLF. Negative indices of l records count back from the last vertex before the record.
+// A v record with an unreadable coordinate still counts as a vertex (the indices after it stay valid), lines skip it;
+// unreadable tokens and invalid indices of l records are skipped.
+
+// All lines of an OBJ file, the vertices of line i are lineOffsets[i] .. lineOffsets[i + 1] - 1
+struct ObjectLines
+{
+	std::vector<float> positions;		// x, y, z per vertex
+	std::vector<float> importance;		// first tex coord, 0 if the vertex has none
+	std::vector<float> scalarColor;		// second tex coord, the importance if it is missing
+	std::vector<uint64_t> lineOffsets;	// numLines + 1 entries, the last one is the vertex count
+};
+
+namespace objectformat
+{
+	static const uint64_t CHUNK_SIZE = 4 << 20;	// bytes per parse task, extended to the next line break
+	// a relative index is stored as RELATIVE_INDEX + its zero based vertex counted from the first vertex of the chunk,
+	// below RELATIVE_LIMIT -> the chunks before are only known when they are stitched together
+	static const int64_t RELATIVE_INDEX = -((int64_t)1 << 62);
+	static const int64_t RELATIVE_LIMIT = -((int64_t)1 << 61);
+	static const int64_t MAX_RELATIVE_INDEX = (int64_t)1 << 60;
+
+	// records of one chunk of the file, the indices are the one based indices of the l records (or relative ones, see RELATIVE_INDEX)
+	struct Chunk
+	{
+		std::vector<float> vertices;		// x, y, z
+		std::vector<float> texCoords;		// importance, scalarColor
+		std::vector<int64_t> indices;
+		std::vector<uint32_t> lineSizes;	// indices per l record
+	};
+
+	inline bool IsBlank(const char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipBlanks(const char* c, const char* end)
+	{
+		while (c < end && IsBlank(*c)) c++;
+		return c;
+	}
+
+	// reads the next number of a record, false at the end of the record or if the next token is no number
+	template <typename T>
+	inline bool ParseNumber(const char*& c, const char* end, T& value)
+	{
+		c = SkipBlanks(c, end);
+		if (c < end && *c == '+') c++;
+		const std::from_chars_result result = std::from_chars(c, end, value);
+		if (result.ec != std::errc()) return false;
+		c = result.ptr;
+		return true;
+	}
+
+	inline void ParseChunk(const char* begin, const char* end, Chunk& chunk)
+	{
+		const char* record = begin;
+		while (record < end)
+		{
+			const char* recordEnd = (const char*)memchr(record, '\n', end - record);
+			if (!recordEnd) recordEnd = end;
+
+			if (recordEnd - record >= 2)
+			{
+				if (record[0] == 'v' && IsBlank(record[1]))	// read in vertex
+				{
+					// nan if unreadable -> the lines drop the vertex
+					const char* c = record + 2;
+					float position[3];
+					for (float& coordinate : position)
+					{
+						if (!ParseNumber(c, recordEnd, coordinate)) coordinate = std::numeric_limits<float>::quiet_NaN();
+					}
+					chunk.vertices.insert(chunk.vertices.end(), position, position + 3);
+				}
+				else if (record[0] == 'v' && record[1] == 't')	// read in tex coords (aka importance and scalarColor)
+				{
+					const char* c = record + 2;
+					float importance = 0.f, scalarColor = 0.f;
+					if (!ParseNumber(c, recordEnd, importance)) importance = 0.f;
+					if (!ParseNumber(c, recordEnd, scalarColor)) scalarColor = importance;	// if no color scalar is given just use the importance instead
+					chunk.texCoords.insert(chunk.texCoords.end(), { importance, scalarColor });
+				}
+				else if (record[0] == 'l' && IsBlank(record[1]))	// read in line indices
+				{
+					const int64_t numVertices = (int64_t)chunk.vertices.size() / 3;
+					uint32_t size = 0;
+					int64_t index;
+					for (const char* c = SkipBlanks(record + 1, recordEnd); c < recordEnd; c = SkipBlanks(c, recordEnd))
+					{
+						if (ParseNumber(c, recordEnd, index))
+						{
+							if (index < 0) index = index < -MAX_RELATIVE_INDEX ? 0 : RELATIVE_INDEX + numVertices + index;
+							chunk.indices.push_back(index);
+							size++;
+						}
+						while (c < recordEnd && !IsBlank(*c)) c++;	// v/vt pairs -> only the vertex is used, the rest of an unreadable token
+					}
+					chunk.lineSizes.push_back(size);
+				}
+			}
+			record = recordEnd + 1;
+		}
+	}
+
+	// parses the whole file content into lines
+	inline void Parse(const char* data, const uint64_t size, ObjectLines& lines)
+	{
+		lines.positions.clear();
+		lines.importance.clear();
+		lines.scalarColor.clear();
+		lines.lineOffsets.assign(1, 0);
+
+		// every chunk starts after a line break -> no record is split between two chunks
+		std::vector<const char*> bounds(1, data);
+		for (uint64_t offset = CHUNK_SIZE; offset < size; offset += CHUNK_SIZE)
+		{
+			if (bounds.back() >= data + offset) continue;	// the last record was longer than a chunk
+			const char* lineBreak = (const char*)memchr(data + offset - 1, '\n', size - offset + 1);
+			if (!lineBreak) break;
+			bounds.push_back(lineBreak + 1);
+		}
+		bounds.push_back(data + size);
+
+		const int numChunks = (int)bounds.size() - 1;
+		std::vector<Chunk> chunks(numChunks);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+		for (int c = 0; c < numChunks; c++)
+		{
+			ParseChunk(bounds[c], bounds[c + 1], chunks[c]);
+		}
+
+		// the indices refer to the vertices of the whole file
+		std::vector<int64_t> vertexBase(numChunks + 1, 0);
+		std::vector<int64_t> texCoordBase(numChunks + 1, 0);
+		size_t numIndices = 0;
+		size_t numLines = 0;
+		for (int c = 0; c < numChunks; c++)
+		{
+			vertexBase[c + 1] = vertexBase[c] + (int64_t)chunks[c].vertices.size() / 3;
+			texCoordBase[c + 1] = texCoordBase[c] + (int64_t)chunks[c].texCoords.size() / 2;
+			numIndices += chunks[c].indices.size();
+			numLines += chunks[c].lineSizes.size();
+		}
+		const int64_t numVertices = vertexBase.back();
+		const int64_t numTexCoords = texCoordBase.back();
+		std::vector<float> vertices(numVertices * 3);
+		std::vector<float> texCoords(numTexCoords * 2);
+#ifndef _DEBUG
+#pragma omp parallel for
+#endif
+		for (int c = 0; c < numChunks; c++)
+		{
+			std::copy(chunks[c].vertices.begin(), chunks[c].vertices.end(), vertices.begin() + vertexBase[c] * 3);
+			std::copy(chunks[c].texCoords.begin(), chunks[c].texCoords.end(), texCoords.begin() + texCoordBase[c] * 2);
+		}
+
+		// stitch the lines of all chunks together, repeated vertices are dropped (also across the end of a line)
+		lines.positions.resize(numIndices * 3);
+		lines.importance.resize(numIndices);
+		lines.scalarColor.resize(numIndices);
+		lines.lineOffsets.reserve(numLines + 1);
+		float last[3] = { 0.f, 0.f, 0.f };
+		uint64_t count = 0;
+		for (int c = 0; c < numChunks; c++)
+		{
+			const int64_t* index = chunks[c].indices.data();
+			for (const uint32_t lineSize : chunks[c].lineSizes)
+			{
+				for (uint32_t i = 0; i < lineSize; i++, index++)
+				{
+					// obj indices are one based
+					const int64_t vertex = *index < RELATIVE_LIMIT ? vertexBase[c] + (*index - RELATIVE_INDEX) : *index - 1;
+					if (vertex < 0 || vertex >= numVertices) continue;
+					const float* position = &vertices[vertex * 3];
+					const float dx = position[0] - last[0], dy = position[1] - last[1], dz = position[2] - last[2];
+					const float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+					// unreadable vertices (nan) are dropped, the first one of the file may also lie in the origin
+					const bool readable = std::isfinite(position[0]) && std::isfinite(position[1]) && std::isfinite(position[2]);
+					if (readable && (count == 0 || (0.0001f < dist && dist < 999999999.f)))
+					{
+						memcpy(last, position, sizeof(last));
+						memcpy(&lines.positions[count * 3], position, sizeof(last));
+						// every vertex needs a value -> 0 if the file has no tex coord for it
+						lines.importance[count] = vertex < numTexCoords ? texCoords[vertex * 2 + 0] : 0.f;
+						lines.scalarColor[count] = vertex < numTexCoords ? texCoords[vertex * 2 + 1] : 0.f;
+						count++;
+					}
+				}
+				lines.lineOffsets.push_back(count);
+			}
+		}
+		lines.positions.resize(count * 3);
+		lines.importance.resize(count);
+		lines.scalarColor.resize(count);
+	}
+}
+
+// Maps the file and parses it.
+// False if the file can not be opened, lines holds all lines that could be read.
+inline bool ReadObjectLines(const char* path, ObjectLines& lines)
+{
+	lines = ObjectLines();
+	lines.lineOffsets.push_back(0);
+
+	MappedFile file;
+	if (!file.Open(path)) return false;
+	objectformat::Parse(file.GetData(), (uint64_t)file.GetSize(), lines);
+	return true;
+}
@@ -0,0 +1,248 @@
+#include "geometrycache.hpp"
+#include "clustering.hpp"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+static const char GEOMETRYCACHE_MAGIC[8] = "VPGEOM";
+static const uint32_t GEOMETRYCACHE_VERSION = 2;
+static const uint64_t GEOMETRYCACHE_ALIGNMENT = 64;
+static const int GEOMETRYCACHE_BLOCKS = 8;
+
+static uint64_t AlignOffset(const uint64_t offset)
+{
+	return (offset + GEOMETRYCACHE_ALIGNMENT - 1) / GEOMETRYCACHE_ALIGNMENT * GEOMETRYCACHE_ALIGNMENT;
+}
+
+// all settings in one hash -> one file per configuration
+static uint64_t HashKey(const GeometryCacheKey& key)
+{
+	const std::string text = key.path + "\n" + key.importance + "\n" + key.scalarColor + "\n" + key.distanceMatrixPath + "\n"
+		+ std::to_string(key.linkage) + " " + std::to_string(key.clusterSize) + " " + std::to_string(key.representativeMethod) + " "
+		+ std::to_string(key.totalNumCPs) + " " + std::to_string(key.meanLineSamples);
+	return DendrogramFile::Hash(text.data(), text.size());
+}
+
+// size and modification time, 0 if the file does not exist
+static void GetFileStamp(const std::string& path, uint64_t& size, int64_t& time)
+{
+	size = 0;
+	time = 0;
+	if (path.empty()) return;
+	std::error_code error;
+	const uintmax_t fileSize = std::filesystem::file_size(path, error);
+	if (error) return;
+	const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(path, error);
+	if (error) return;
+	size = fileSize;
+	time = (int64_t)writeTime.time_since_epoch().count();
+}
+
+// everything of the header except for the sizes of the blocks
+static GeometryCacheHeader CreateHeader(const GeometryCacheKey& key)
+{
+	GeometryCacheHeader header = {};
+	memcpy(header.magic, GEOMETRYCACHE_MAGIC, sizeof(GEOMETRYCACHE_MAGIC));
+	header.version = GEOMETRYCACHE_VERSION;
+	header.representativeMethod = (uint32_t)key.representativeMethod;
+	header.clusterSize = key.clusterSize;
+	header.numControlPoints = (uint32_t)key.totalNumCPs;
+	header.meanLineSamples = key.meanLineSamples;
+	header.linkage = key.linkage;
+	header.keyHash = HashKey(key);
+	GetFileStamp(key.path, header.datasetSize, header.datasetTime);
+
+	// the binary version of a text matrix is read instead of it (LineGeometry::LoadDistanceMatrix)
+	std::string matrixPath = key.distanceMatrixPath;
+	if (!matrixPath.empty())
+	{
+		const std::filesystem::path binary = std::filesystem::path(matrixPath).replace_extension(".distb");
+		std::error_code error;
+		if (std::filesystem::exists(binary, error)) matrixPath = binary.string();
+	}
+	GetFileStamp(matrixPath, header.matrixSize, header.matrixTime);
+	return header;
+}
+
+GeometryCacheFile::GeometryCacheFile() :
+	mVertexData()
+{
+}
+
+GeometryCacheFile::~GeometryCacheFile()
+{
+	Close();
+}
+
+GeometryCacheFile::GeometryCacheFile(GeometryCacheFile&& other) :
+	mFile(std::move(other.mFile)),
+	mVertexData(other.mVertexData)
+{
+	other.mVertexData = VertexData();
+}
+
+GeometryCacheFile& GeometryCacheFile::operator=(GeometryCacheFile&& other)
+{
+	if (this != &other)
+	{
+		mFile = std::move(other.mFile);
+		mVertexData = other.mVertexData;
+		other.mVertexData = VertexData();
+	}
+	return *this;
+}
+
+std::string GeometryCacheFile::GetPath(const std::string& directory, const GeometryCacheKey& key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "-%016llx.geometry", (unsigned long long)HashKey(key));
+	return (std::filesystem::path(directory) / (std::filesystem::path(key.path).stem().string() + name)).string();
+}
+
+bool GeometryCacheFile::Open(const std::string& directory, const GeometryCacheKey& key)
+{
+	Close();
+	const std::string path = GetPath(directory, key);
+	std::error_code error;
+	if (!std::filesystem::exists(path, error)) return false;
+	if (!mFile.Open(path) || mFile.GetSize() < sizeof(GeometryCacheHeader)) return Reject(path);
+
+	// same settings and the same dataset / matrix as when the file was written?
+	const GeometryCacheHeader* header = (const GeometryCacheHeader*)mFile.GetData();
+	const GeometryCacheHeader expected = CreateHeader(key);
+	if (memcmp(header->magic, expected.magic, sizeof(expected.magic)) != 0 || header->version != expected.version) return Reject(path);
+	if (header->representativeMethod != expected.representativeMethod || header->clusterSize != expected.clusterSize || header->numControlPoints != expected.numControlPoints
+		|| header->meanLineSamples != expected.meanLineSamples || header->linkage != expected.linkage || header->keyHash != expected.keyHash) return Reject(path);
+	if (expected.datasetSize == 0 || header->datasetSize != expected.datasetSize || header->datasetTime != expected.datasetTime
+		|| header->matrixSize != expected.matrixSize || header->matrixTime != expected.matrixTime) return Reject(path);
+
+	// check that the blocks lie inside of the file
+	if (header->numVertices == 0 || header->numVertices > 0xFFFFFFFFull || header->numLineVertices > header->numVertices || header->numLines > 0xFFFFFFFFull) return Reject(path);
+	const uint64_t sizes[GEOMETRYCACHE_BLOCKS] = { header->numVertices * 3 * sizeof(float), header->numVertices * sizeof(int), header->numVertices * sizeof(float),
+		header->numVertices * sizeof(float), header->numVertices * sizeof(float), (uint64_t)header->numControlPoints * sizeof(unsigned int),
+		header->numLines * LINE_LOD_LEVELS * sizeof(LineLevel), header->numLines * sizeof(XMFLOAT4) };
+	for (int block = 0; block < GEOMETRYCACHE_BLOCKS; block++)
+	{
+		if (header->offsets[block] < sizeof(GeometryCacheHeader) || header->offsets[block] + sizes[block] > mFile.GetSize()) return Reject(path);
+	}
+
+	const char* data = mFile.GetData();
+	mVertexData.positions = (const float*)(data + header->offsets[0]);
+	mVertexData.id = (const int*)(data + header->offsets[1]);
+	mVertexData.importance = (const float*)(data + header->offsets[2]);
+	mVertexData.color = (const float*)(data + header->offsets[3]);
+	mVertexData.alphaWeights = (const float*)(data + header->offsets[4]);
+	mVertexData.controlPointLineIndices = (const unsigned int*)(data + header->offsets[5]);
+	mVertexData.levels = (const LineLevel*)(data + header->offsets[6]);
+	mVertexData.bounds = (const XMFLOAT4*)(data + header->offsets[7]);
+	mVertexData.numVertices = (unsigned)header->numVertices;
+	mVertexData.numLineVertices = (unsigned)header->numLineVertices;
+	mVertexData.numControlPoints = header->numControlPoints;
+	mVertexData.numLines = (unsigned)header->numLines;
+
+	// the levels are drawn by index -> all of them inside of the vertex buffers
+	for (uint64_t level = 0; level < header->numLines * LINE_LOD_LEVELS; level++)
+	{
+		if ((uint64_t)mVertexData.levels[level].first + mVertexData.levels[level].count > header->numVertices) return Reject(path);
+	}
+
+	// least recently used files are evicted first
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+	return true;
+}
+
+bool GeometryCacheFile::Reject(const std::string& path)
+{
+	// prepared with other settings or from an older dataset -> never opened again, it would only take space
+	Close();
+	std::error_code error;
+	std::filesystem::remove(path, error);
+	return false;
+}
+
+void GeometryCacheFile::Close()
+{
+	mFile.Close();
+	mVertexData = VertexData();
+}
+
+bool GeometryCacheFile::Write(const std::string& directory, const GeometryCacheKey& key, const VertexData& data)
+{
+	if (data.numVertices == 0 || data.numControlPoints != (unsigned)key.totalNumCPs) return false;
+
+	GeometryCacheHeader header = CreateHeader(key);
+	if (header.datasetSize == 0) return false;
+	header.numVertices = data.numVertices;
+	header.numLineVertices = data.numLineVertices;
+	header.numLines = data.numLines;
+	const void* blocks[GEOMETRYCACHE_BLOCKS] = { data.positions, data.id, data.importance, data.color, data.alphaWeights, data.controlPointLineIndices, data.levels, data.bounds };
+	const uint64_t sizes[GEOMETRYCACHE_BLOCKS] = { (uint64_t)data.numVertices * 3 * sizeof(float), (uint64_t)data.numVertices * sizeof(int), (uint64_t)data.numVertices * sizeof(float),
+		(uint64_t)data.numVertices * sizeof(float), (uint64_t)data.numVertices * sizeof(float), (uint64_t)data.numControlPoints * sizeof(unsigned int),
+		(uint64_t)data.numLines * LINE_LOD_LEVELS * sizeof(LineLevel), (uint64_t)data.numLines * sizeof(XMFLOAT4) };
+	uint64_t offset = sizeof(GeometryCacheHeader);
+	for (int block = 0; block < GEOMETRYCACHE_BLOCKS; block++)
+	{
+		header.offsets[block] = AlignOffset(offset);
+		offset = header.offsets[block] + sizes[block];
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	const std::string path = GetPath(directory, key);
+
+	// an interrupted write never leaves a truncated file behind
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) return false;
+		out.write((const char*)&header, sizeof(header));
+		uint64_t written = sizeof(header);
+		const char padding[GEOMETRYCACHE_ALIGNMENT] = {};
+		for (int block = 0; block < GEOMETRYCACHE_BLOCKS; block++)
+		{
+			out.write(padding, header.offsets[block] - written);
+			out.write((const char*)blocks[block], sizes[block]);
+			written = header.offsets[block] + sizes[block];
+		}
+		if (!out.good()) return false;
+	}
+	std::remove(path.c_str());
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+void GeometryCacheFile::Evict(const std::string& directory, uint64_t maxSize)
+{
+	struct CacheEntry
+	{
+		std::filesystem::path path;
+		std::filesystem::file_time_type time;
+		uint64_t size;
+	};
+	std::vector<CacheEntry> entries;
+	uint64_t totalSize = 0;
+	std::error_code error;
+	for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+	{
+		if (it->path().extension() != ".geometry") continue;
+		CacheEntry entry;
+		entry.path = it->path();
+		entry.size = (uint64_t)it->file_size(error);
+		if (error) { error.clear(); continue; }
+		entry.time = it->last_write_time(error);
+		if (error) { error.clear(); continue; }
+		totalSize += entry.size;
+		entries.push_back(entry);
+	}
+
+	// oldest first, a file that can not be removed (still mapped) is skipped
+	std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.time < b.time; });
+	for (size_t i = 0; i + 1 < entries.size() && totalSize > maxSize; i++)
+	{
+		if (std::filesystem::remove(entries[i].path, error)) totalSize -= entries[i].size;
+		error.clear();
+	}
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "mappedfile.hpp"
+#include "linelod.hpp"
+
+// Vertex data of a prepared line set (*.geometry), one file per configuration in the cache directory.
+// Reopening a dataset maps it and fills the gpu buffers without parsing, clustering and distributing the polylines first:
+//   GeometryCacheHeader
+//   float positions[numVertices * 3]
+//   int id[numVertices]
+//   float importance[numVertices]
+//   float color[numVertices]
+//   float alphaWeights[numVertices]
+//   unsigned controlPointLineIndices[numControlPoints]
+//   LineLevel levels[numLines * LINE_LOD_LEVELS]
+//   XMFLOAT4 bounds[numLines]
+// All blocks are 64 byte aligned. The dataset and the distance matrix are identified by their size and modification time,
+// a changed file is prepared again.
+struct GeometryCacheHeader
+{
+	char magic[8];					// "VPGEOM"
+	uint32_t version;
+	uint32_t representativeMethod;
+	uint32_t clusterSize;
+	uint32_t numControlPoints;
+	uint32_t meanLineSamples;
+	int32_t linkage;
+	uint64_t keyHash;				// DendrogramFile::Hash of the paths and property names
+	uint64_t datasetSize;
+	int64_t datasetTime;
+	uint64_t matrixSize;
+	int64_t matrixTime;
+	uint64_t numVertices;			// lines and their levels of detail
+	uint64_t numLineVertices;		// lines, the first vertices
+	uint64_t numLines;
+	uint64_t offsets[8];			// byte offsets of the blocks from the start of the file
+};
+
+// settings that lead to the vertex data of a line set
+struct GeometryCacheKey
+{
+	std::string path;
+	std::string importance;
+	std::string scalarColor;
+	std::string distanceMatrixPath;		// empty -> no clustering
+	int linkage;
+	unsigned clusterSize;
+	int representativeMethod;
+	int totalNumCPs;
+	unsigned meanLineSamples;
+};
+
+// arrays of the gpu buffers, either the staging arrays of a LineGeometry or a mapped cache file
+struct VertexData
+{
+	const float* positions;			// xyz per vertex
+	const int* id;
+	const float* importance;
+	const float* color;
+	const float* alphaWeights;
+	const unsigned int* controlPointLineIndices;
+	const LineLevel* levels;		// LINE_LOD_LEVELS per line
+	const XMFLOAT4* bounds;			// bounding sphere per line
+	unsigned numVertices;
+	unsigned numLineVertices;
+	unsigned numControlPoints;
+	unsigned numLines;
+};
+
+// Read-only memory mapping of the cache file of one configuration.
+class GeometryCacheFile
+{
+public:
+	GeometryCacheFile();
+	~GeometryCacheFile();
+	GeometryCacheFile(const GeometryCacheFile&) = delete;
+	GeometryCacheFile& operator=(const GeometryCacheFile&) = delete;
+	GeometryCacheFile(GeometryCacheFile&& other);
+	GeometryCacheFile& operator=(GeometryCacheFile&& other);
+
+	// file of the configuration in the cache directory
+	static std::string GetPath(const std::string& directory, const GeometryCacheKey& key);
+
+	// false if there is no file or it was prepared with other settings / from an older dataset, such a file is deleted.
+	// An opened file counts as used now (Evict).
+	bool Open(const std::string& directory, const GeometryCacheKey& key);
+	void Close();
+	bool IsOpen() const { return mFile.GetData() != NULL; }
+
+	// points into the mapping, valid while the file is open
+	const VertexData& GetVertexData() const { return mVertexData; }
+
+	// creates the directory, writes next to the final file and renames it
+	static bool Write(const std::string& directory, const GeometryCacheKey& key, const VertexData& data);
+	// removes the least recently written / opened files until the cache files of the directory take at most maxSize bytes,
+	// the newest file always stays
+	static void Evict(const std::string& directory, uint64_t maxSize);
+
+private:
+	// closes and deletes the file, always false
+	bool Reject(const std::string& path);
+
+	MappedFile mFile;
+	VertexData mVertexData;
+};
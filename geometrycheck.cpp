@@ -0,0 +1,804 @@
+#include "datasetloader.hpp"
+#include "linesetformat.hpp"
+#include "distancematrixformat.hpp"
+#include "objectfile.hpp"
+#include "objectformat.hpp"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <chrono>
+
+// Headless check of the cpu side of the lines: a small line set and its distance matrix are written to the temp directory,
+// loaded, clustered and reduced to representatives, and unreadable files have to leave the geometry empty.
+// A second, detailed line set checks the levels of detail (LineLod) and the indices that the geometry shader reads.
+// Dendrograms of a random matrix are stored and read back (DendrogramFile), so is the vertex data of a configuration (GeometryCacheFile).
+// OBJ files with CRLF line breaks, relative indices and unreadable tokens are parsed (objectformat.hpp).
+// The nearest neighbor chain and the minimum spanning tree have to cluster like a naive O(N^3) clustering.
+// Returns non-zero if a check fails.
+
+static const unsigned CHECK_CLUSTERS = 3;
+static const unsigned CHECK_LINES_PER_CLUSTER = 5;
+static const unsigned CHECK_LINES = CHECK_CLUSTERS * CHECK_LINES_PER_CLUSTER;
+static const unsigned CHECK_VERTICES_PER_LINE = 6;
+static const float CHECK_MEMBER_OFFSETS[CHECK_LINES_PER_CLUSTER] = { 0.f, 1.f, 2.f, 4.f, 8.f };	// the third member is the medoid
+static const unsigned CHECK_MEDOID = 2;
+static const unsigned CHECK_MOST_IMPORTANT = 4;
+static const float CHECK_CLUSTER_SPACING = 100.f;
+static const unsigned CHECK_DETAIL_GRID = 8;			// lines per row and column of the detailed line set
+static const unsigned CHECK_DETAIL_VERTICES = 257;
+static const float CHECK_DETAIL_SPACING = 3.f;
+static const float CHECK_DETAIL_STEP = 0.1f;			// distance of the vertices in y
+static const unsigned CHECK_RANDOM_LINES = 24;			// lines of the random distance matrices
+static const unsigned CHECK_OBJECT_VERTICES = 160000;	// vertices of the OBJ file that is parsed in two chunks
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char* what)
+{
+	printf("%s: %s\n", what, condition ? "ok" : "FAILED");
+	if (!condition) g_Failures++;
+}
+
+// lines along y, clusters far apart in x
+static float LineX(unsigned line)
+{
+	return (line / CHECK_LINES_PER_CLUSTER) * CHECK_CLUSTER_SPACING + CHECK_MEMBER_OFFSETS[line % CHECK_LINES_PER_CLUSTER];
+}
+
+static float LineImportance(unsigned line)
+{
+	return line % CHECK_LINES_PER_CLUSTER == CHECK_MOST_IMPORTANT ? 0.9f : 0.1f + 0.01f * line;
+}
+
+static uint64_t Align(uint64_t offset)
+{
+	return (offset + 63) & ~(uint64_t)63;
+}
+
+// lines with an importance and a speed value per vertex, in the layout of the line set
+struct CheckLines {
+	std::vector<XMFLOAT3> positions;
+	std::vector<float> importance;
+	std::vector<float> speed;
+	std::vector<uint64_t> lineOffsets;	// numLines + 1 entries
+};
+
+// the clusters of the representative checks
+static CheckLines ClusterLines()
+{
+	CheckLines lines;
+	lines.lineOffsets.push_back(0);
+	for (unsigned line = 0; line < CHECK_LINES; line++)
+	{
+		for (unsigned i = 0; i < CHECK_VERTICES_PER_LINE; i++)
+		{
+			lines.positions.push_back(XMFLOAT3(LineX(line), (float)i, 0.f));
+			lines.importance.push_back(LineImportance(line));
+			lines.speed.push_back((float)i);
+		}
+		lines.lineOffsets.push_back(lines.positions.size());
+	}
+	return lines;
+}
+
+// wiggling lines along y on a grid in x and z (octaves of sines in x), and one line that is too short for the geometry shader
+static CheckLines DetailLines()
+{
+	CheckLines lines;
+	lines.lineOffsets.push_back(0);
+	for (unsigned line = 0; line < CHECK_DETAIL_GRID * CHECK_DETAIL_GRID; line++)
+	{
+		const float phase = 1.f + 0.1f * line;
+		for (unsigned i = 0; i < CHECK_DETAIL_VERTICES; i++)
+		{
+			const float t = i * CHECK_DETAIL_STEP;
+			float x = (line % CHECK_DETAIL_GRID) * CHECK_DETAIL_SPACING;
+			for (unsigned octave = 0; octave < 8; octave++)
+			{
+				x += std::ldexp(std::sin(std::ldexp(t * phase, octave)), -(int)octave);
+			}
+			lines.positions.push_back(XMFLOAT3(x, t, (line / CHECK_DETAIL_GRID) * CHECK_DETAIL_SPACING));
+			lines.importance.push_back(0.5f);
+			lines.speed.push_back(t);
+		}
+		lines.lineOffsets.push_back(lines.positions.size());
+	}
+	for (unsigned i = 0; i < LINE_LOD_MIN_VERTICES - 1; i++)
+	{
+		lines.positions.push_back(XMFLOAT3(CHECK_DETAIL_GRID * 0.5f * CHECK_DETAIL_SPACING, 10.f + i, CHECK_DETAIL_GRID * 0.5f * CHECK_DETAIL_SPACING));
+		lines.importance.push_back(0.5f);
+		lines.speed.push_back((float)i);
+	}
+	lines.lineOffsets.push_back(lines.positions.size());
+	return lines;
+}
+
+static bool WriteLineSet(const std::string& path, const CheckLines& lines)
+{
+	const uint64_t numVertices = lines.positions.size();
+	LineSetHeader header = {};
+	memcpy(header.magic, LINESET_MAGIC, sizeof(LINESET_MAGIC));
+	header.version = LINESET_VERSION;
+	header.numProperties = 2;
+	header.numLines = lines.lineOffsets.size() - 1;
+	header.numVertices = numVertices;
+	header.lineOffsetsOffset = Align(sizeof(LineSetHeader) + header.numProperties * sizeof(LineSetProperty));
+	header.positionsOffset = Align(header.lineOffsetsOffset + lines.lineOffsets.size() * sizeof(uint64_t));
+
+	LineSetProperty properties[2] = {};
+	strcpy(properties[0].name, "importance");
+	strcpy(properties[1].name, "speed");
+	properties[0].valuesOffset = Align(header.positionsOffset + numVertices * sizeof(XMFLOAT3));
+	properties[1].valuesOffset = Align(properties[0].valuesOffset + numVertices * sizeof(float));
+
+	std::vector<char> data(Align(properties[1].valuesOffset + numVertices * sizeof(float)), 0);
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), properties, sizeof(properties));
+	memcpy(data.data() + header.lineOffsetsOffset, lines.lineOffsets.data(), lines.lineOffsets.size() * sizeof(uint64_t));
+	memcpy(data.data() + header.positionsOffset, lines.positions.data(), numVertices * sizeof(XMFLOAT3));
+	memcpy(data.data() + properties[0].valuesOffset, lines.importance.data(), numVertices * sizeof(float));
+	memcpy(data.data() + properties[1].valuesOffset, lines.speed.data(), numVertices * sizeof(float));
+
+	std::ofstream out(path, std::ios::binary);
+	out.write(data.data(), data.size());
+	return out.good();
+}
+
+// distance of two lines: their offset in x
+static bool WriteDistanceMatrix(const std::string& path)
+{
+	DistanceMatrixHeader header = {};
+	memcpy(header.magic, DISTANCEMATRIX_MAGIC, sizeof(DISTANCEMATRIX_MAGIC));
+	header.version = DISTANCEMATRIX_VERSION;
+	header.numLines = CHECK_LINES;
+	header.valuesOffset = Align(sizeof(DistanceMatrixHeader));
+
+	std::vector<char> data(header.valuesOffset + (size_t)CHECK_LINES * (CHECK_LINES - 1) / 2 * sizeof(float), 0);
+	memcpy(data.data(), &header, sizeof(header));
+	float* values = (float*)(data.data() + header.valuesOffset);
+	for (unsigned i = 0; i < CHECK_LINES; i++)
+	{
+		for (unsigned j = i + 1; j < CHECK_LINES; j++)
+		{
+			values[DistanceMatrixIndex(i, j, CHECK_LINES)] = std::fabs(LineX(i) - LineX(j));
+		}
+	}
+
+	std::ofstream out(path, std::ios::binary);
+	out.write(data.data(), data.size());
+	return out.good();
+}
+
+// the representatives of a method, sorted
+static std::vector<unsigned> Representatives(LineGeometry& geometry, RepresentativeMethod method)
+{
+	geometry.SetRepresentativeMethod(method);
+	geometry.CalculateHierarchicalClustering();
+	std::vector<unsigned> lineIDs = geometry.GetClusteredObjectData().lineIDs;
+	std::sort(lineIDs.begin(), lineIDs.end());
+	return lineIDs;
+}
+
+// the same member of every cluster
+static std::vector<unsigned> Members(unsigned member)
+{
+	std::vector<unsigned> lineIDs;
+	for (unsigned cluster = 0; cluster < CHECK_CLUSTERS; cluster++)
+	{
+		lineIDs.push_back(cluster * CHECK_LINES_PER_CLUSTER + member);
+	}
+	return lineIDs;
+}
+
+static void CheckClustering(const std::string& linesPath, const std::string& matrixPath)
+{
+	LineGeometry geometry(linesPath, matrixPath, RepresentativeMethod::FirstLine, 64, CHECK_CLUSTERS);
+	geometry.ParseLineData(linesPath, "importance", "speed");
+	const ObjectData& object = geometry.GetObjectData();
+	Check(object.GetNumLines() == CHECK_LINES && object.GetNumVertices() == CHECK_LINES * CHECK_VERTICES_PER_LINE, "line set: lines and vertices");
+	Check(object.GetImportance(CHECK_MOST_IMPORTANT)[0] == LineImportance(CHECK_MOST_IMPORTANT) && object.GetScalarColor(1)[3] == 3.f, "line set: selected properties");
+	Check(std::fabs(object.GetLineLength(0) - (CHECK_VERTICES_PER_LINE - 1)) < 1e-5f, "line set: arc length");
+
+	geometry.CalculateClusterReport(matrixPath, LinkageMethod::CompleteLinkage);
+	Check(Representatives(geometry, RepresentativeMethod::FirstLine) == Members(0), "first line representatives");
+	Check(Representatives(geometry, RepresentativeMethod::LeastDistanceCurve) == Members(CHECK_MEDOID), "least distance representatives");
+	Check(Representatives(geometry, RepresentativeMethod::MostImportantCurve) == Members(CHECK_MOST_IMPORTANT), "most important representatives");
+
+	// mean lines are computed: one per cluster, in the middle of its members
+	geometry.SetRepresentativeMethod(RepresentativeMethod::MeanLine);
+	geometry.CalculateHierarchicalClustering();
+	const ObjectData& means = geometry.GetClusteredObjectData().computed;
+	bool meansInside = geometry.GetClusteredObjectData().lineIDs.empty() && means.GetNumLines() == CHECK_CLUSTERS;
+	for (unsigned line = 0; meansInside && line < means.GetNumLines(); line++)
+	{
+		const float x = means.GetLine(line)[0].x;
+		const float clusterX = std::floor(x / CHECK_CLUSTER_SPACING + 0.5f) * CHECK_CLUSTER_SPACING;
+		meansInside = means.GetNumVertices(line) == geometry.GetMeanLineSamples() && x > clusterX && x < clusterX + CHECK_MEMBER_OFFSETS[CHECK_LINES_PER_CLUSTER - 1];
+	}
+	Check(meansInside, "mean line representatives");
+
+	// vertex data of the picked lines
+	geometry.SetRepresentativeMethod(RepresentativeMethod::MostImportantCurve);
+	geometry.CalculateHierarchicalClustering();
+	geometry.LoadLineSet(geometry.GetClusteredObjectData());
+	const VertexData data = geometry.GetVertexData();
+	Check(data.numLines == CHECK_CLUSTERS && data.numLineVertices == CHECK_CLUSTERS * CHECK_VERTICES_PER_LINE && data.numControlPoints == 64, "vertex data of the representatives");
+}
+
+static void CheckFailedLoads(const std::string& directory, const std::string& linesPath)
+{
+	// missing and inconsistent line sets leave the geometry empty
+	LineGeometry missing(directory + "/missing.lines", "", RepresentativeMethod::FirstLine, 64, 0);
+	missing.ParseLineData(directory + "/missing.lines");
+	Check(missing.GetTotalLineAmount() == 0, "missing line set");
+
+	const std::string brokenPath = directory + "/broken.lines";
+	CheckLines brokenLines = ClusterLines();
+	brokenLines.lineOffsets.back()++;
+	WriteLineSet(brokenPath, brokenLines);
+	LineGeometry broken(brokenPath, "", RepresentativeMethod::FirstLine, 64, 0);
+	broken.ParseLineData(brokenPath);
+	Check(broken.GetTotalLineAmount() == 0, "line offsets beyond the vertices");
+
+	// without a matrix all lines are shown
+	LineGeometry unclustered(linesPath, directory + "/missing.distb", RepresentativeMethod::FirstLine, 64, CHECK_CLUSTERS);
+	unclustered.ParseLineData(linesPath);
+	unclustered.CalculateClusterReport(directory + "/missing.distb");
+	unclustered.CalculateHierarchicalClustering();
+	Check(unclustered.GetClusteredObjectData().lineIDs.size() == CHECK_LINES, "missing distance matrix");
+}
+
+static void CheckLoader(const std::string& directory, const std::string& linesPath, const std::string& matrixPath)
+{
+	DatasetLoader loader("", 0);
+	DatasetLoader::Request request = { linesPath, "importance", "speed", matrixPath, LinkageMethod::CompleteLinkage, RepresentativeMethod::MostImportantCurve, 64, 0, CHECK_CLUSTERS };
+	bool completion = true;
+	Check(loader.Start(request), "loader: start");
+	std::unique_ptr<LineGeometry> geometry = loader.WaitForGeometry(completion);
+	Check(geometry && !completion && geometry->GetTotalLineAmount() == CHECK_LINES && geometry->GetVertexData().numLines == CHECK_CLUSTERS, "loader: clustered line set");
+
+	// an unreadable dataset has no result, the current lines stay
+	request.path = directory + "/missing.lines";
+	Check(loader.Start(request), "loader: start missing");
+	geometry = loader.WaitForGeometry(completion);
+	Check(!geometry && !loader.IsLoading(), "loader: missing line set");
+}
+
+// condensed upper triangle of random distances
+static std::vector<float> RandomMatrix(unsigned numLines, unsigned seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> distance(0.1f, 10.f);
+	std::vector<float> condensed((size_t)numLines * (numLines - 1) / 2);
+	for (float& value : condensed)
+	{
+		value = distance(random);
+	}
+	return condensed;
+}
+
+// distances of random points -> a Euclidean matrix, Ward of the reference is defined by the centroids
+static std::vector<float> RandomPointMatrix(unsigned numLines, unsigned seed, std::vector<XMFLOAT3>& points)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+	points.resize(numLines);
+	for (XMFLOAT3& point : points)
+	{
+		point = XMFLOAT3(coordinate(random), coordinate(random), coordinate(random));
+	}
+	std::vector<float> condensed((size_t)numLines * (numLines - 1) / 2);
+	for (unsigned i = 0; i < numLines; i++)
+	{
+		for (unsigned j = i + 1; j < numLines; j++)
+		{
+			const double dx = points[i].x - points[j].x, dy = points[i].y - points[j].y, dz = points[i].z - points[j].z;
+			condensed[DistanceMatrixIndex(i, j, numLines)] = (float)std::sqrt(dx * dx + dy * dy + dz * dz);
+		}
+	}
+	return condensed;
+}
+
+// linkage distance of two clusters from their lines, Ward needs the points
+static double ReferenceLinkage(const std::vector<float>& condensed, unsigned numLines, const std::vector<XMFLOAT3>& points,
+	const std::vector<unsigned>& a, const std::vector<unsigned>& b, LinkageMethod linkage)
+{
+	if (linkage == LinkageMethod::WardLinkage)
+	{
+		double ca[3] = {}, cb[3] = {};
+		for (unsigned line : a) { ca[0] += points[line].x; ca[1] += points[line].y; ca[2] += points[line].z; }
+		for (unsigned line : b) { cb[0] += points[line].x; cb[1] += points[line].y; cb[2] += points[line].z; }
+		double squared = 0.0;
+		for (int c = 0; c < 3; c++)
+		{
+			const double d = ca[c] / a.size() - cb[c] / b.size();
+			squared += d * d;
+		}
+		return std::sqrt(2.0 * a.size() * b.size() / (a.size() + b.size()) * squared);
+	}
+
+	double sum = 0.0, minimum = INFINITY, maximum = 0.0;
+	for (unsigned i : a)
+	{
+		for (unsigned j : b)
+		{
+			const double d = condensed[DistanceMatrixIndex(std::min(i, j), std::max(i, j), numLines)];
+			sum += d;
+			minimum = std::min(minimum, d);
+			maximum = std::max(maximum, d);
+		}
+	}
+	if (linkage == LinkageMethod::SingleLinkage) return minimum;
+	if (linkage == LinkageMethod::CompleteLinkage) return maximum;
+	return sum / ((double)a.size() * b.size());
+}
+
+// cluster id of every line, numbered in the order of the first line of each cluster (like HierarchicalClustering::Cut)
+static std::vector<unsigned> Partition(const std::vector<std::vector<unsigned>>& clusters, unsigned numLines)
+{
+	std::vector<unsigned> cluster(numLines);
+	for (unsigned c = 0; c < clusters.size(); c++)
+	{
+		for (unsigned line : clusters[c]) cluster[line] = c;
+	}
+	std::vector<unsigned> ids(clusters.size(), numLines);
+	std::vector<unsigned> partition(numLines);
+	unsigned numIds = 0;
+	for (unsigned line = 0; line < numLines; line++)
+	{
+		if (ids[cluster[line]] == numLines) ids[cluster[line]] = numIds++;
+		partition[line] = ids[cluster[line]];
+	}
+	return partition;
+}
+
+// merges the closest two clusters until one is left, the linkage computed from the lines every time.
+// partitions[k] is the clustering with k clusters, distances the merge distances in order.
+static void ReferenceClustering(const std::vector<float>& condensed, unsigned numLines, const std::vector<XMFLOAT3>& points, LinkageMethod linkage,
+	std::vector<std::vector<unsigned>>& partitions, std::vector<double>& distances)
+{
+	std::vector<std::vector<unsigned>> clusters(numLines);
+	for (unsigned line = 0; line < numLines; line++) clusters[line].push_back(line);
+	partitions.assign(numLines + 1, std::vector<unsigned>());
+	partitions[numLines] = Partition(clusters, numLines);
+	distances.clear();
+	while (clusters.size() > 1)
+	{
+		size_t a = 0, b = 1;
+		double closest = INFINITY;
+		for (size_t i = 0; i < clusters.size(); i++)
+		{
+			for (size_t j = i + 1; j < clusters.size(); j++)
+			{
+				const double d = ReferenceLinkage(condensed, numLines, points, clusters[i], clusters[j], linkage);
+				if (d < closest)
+				{
+					closest = d;
+					a = i;
+					b = j;
+				}
+			}
+		}
+		clusters[a].insert(clusters[a].end(), clusters[b].begin(), clusters[b].end());
+		clusters.erase(clusters.begin() + b);
+		distances.push_back(closest);
+		partitions[clusters.size()] = Partition(clusters, numLines);
+	}
+}
+
+// every cut and every merge distance of the dendrogram match the reference
+static bool MatchesReference(const Dendrogram& dendrogram, const std::vector<float>& condensed, unsigned numLines, const std::vector<XMFLOAT3>& points, LinkageMethod linkage)
+{
+	std::vector<std::vector<unsigned>> partitions;
+	std::vector<double> distances;
+	ReferenceClustering(condensed, numLines, points, linkage, partitions, distances);
+	if (dendrogram.numLines != numLines || dendrogram.merges.size() != distances.size()) return false;
+	for (size_t merge = 0; merge < distances.size(); merge++)
+	{
+		if (std::fabs(dendrogram.merges[merge].distance - distances[merge]) > 1e-4 * std::max(distances[merge], 1.0)) return false;
+	}
+	for (unsigned clusterSize = 1; clusterSize <= numLines; clusterSize++)
+	{
+		if (HierarchicalClustering::Cut(dendrogram, clusterSize) != partitions[clusterSize]) return false;
+	}
+	return true;
+}
+
+static void CheckLinkage(const std::vector<float>& condensed, const std::vector<XMFLOAT3>& points, LinkageMethod linkage, const char* what)
+{
+	// the nearest neighbor chain overwrites its matrix
+	std::vector<float> matrix = condensed;
+	const Dendrogram dendrogram = linkage == LinkageMethod::SingleLinkage ? HierarchicalClustering::SingleLinkage(matrix.data(), CHECK_RANDOM_LINES)
+		: HierarchicalClustering::NearestNeighborChain(matrix.data(), CHECK_RANDOM_LINES, linkage);
+	Check(MatchesReference(dendrogram, condensed, CHECK_RANDOM_LINES, points, linkage), what);
+}
+
+static void CheckHierarchicalClustering()
+{
+	std::vector<XMFLOAT3> points;
+	const std::vector<float> euclidean = RandomPointMatrix(CHECK_RANDOM_LINES, 15, points);
+	CheckLinkage(euclidean, points, LinkageMethod::SingleLinkage, "minimum spanning tree: single linkage");
+	CheckLinkage(euclidean, points, LinkageMethod::CompleteLinkage, "nearest neighbor chain: complete linkage");
+	CheckLinkage(euclidean, points, LinkageMethod::AverageLinkage, "nearest neighbor chain: average linkage");
+	CheckLinkage(euclidean, points, LinkageMethod::WardLinkage, "nearest neighbor chain: ward linkage");
+
+	// distances that are no metric, Ward is only defined for the Euclidean ones
+	const std::vector<float> random = RandomMatrix(CHECK_RANDOM_LINES, 51);
+	CheckLinkage(random, points, LinkageMethod::SingleLinkage, "minimum spanning tree: single linkage of a random matrix");
+	CheckLinkage(random, points, LinkageMethod::AverageLinkage, "nearest neighbor chain: average linkage of a random matrix");
+}
+
+static bool SameDendrogram(const Dendrogram& a, const Dendrogram& b)
+{
+	if (a.numLines != b.numLines || a.merges.size() != b.merges.size()) return false;
+	for (size_t i = 0; i < a.merges.size(); i++)
+	{
+		if (a.merges[i].a != b.merges[i].a || a.merges[i].b != b.merges[i].b || a.merges[i].distance != b.merges[i].distance) return false;
+	}
+	return true;
+}
+
+static void CheckDendrogramFile(const std::string& directory, const std::string& matrixPath)
+{
+	std::vector<float> distances = RandomMatrix(CHECK_RANDOM_LINES, 17);
+	const uint64_t hash = DendrogramFile::Hash(distances.data(), distances.size() * sizeof(float));
+	std::vector<float> condensed = distances;
+	const Dendrogram dendrogram = HierarchicalClustering::Cluster(condensed.data(), CHECK_RANDOM_LINES, LinkageMethod::AverageLinkage);
+	const std::string path = DendrogramFile::GetPath(directory + "/random.distb", LinkageMethod::AverageLinkage);
+	Check(DendrogramFile::Write(path, hash, LinkageMethod::AverageLinkage, dendrogram), "dendrogram: write");
+
+	Dendrogram read;
+	Check(DendrogramFile::Read(path, hash, LinkageMethod::AverageLinkage, read) && SameDendrogram(read, dendrogram), "dendrogram: read back");
+
+	// a recomputed matrix with the same name has another hash -> clustered again, the dendrogram stays untouched
+	distances[distances.size() / 2] += 1.f;
+	const uint64_t changedHash = DendrogramFile::Hash(distances.data(), distances.size() * sizeof(float));
+	Dendrogram stale;
+	Check(changedHash != hash && !DendrogramFile::Read(path, changedHash, LinkageMethod::AverageLinkage, stale) && stale.merges.empty(), "dendrogram: changed matrix rejected");
+	Check(!DendrogramFile::Read(path, hash, LinkageMethod::WardLinkage, stale), "dendrogram: other linkage rejected");
+
+	// the clustering of the line set left its dendrogram next to the matrix
+	std::error_code error;
+	Check(std::filesystem::exists(DendrogramFile::GetPath(matrixPath, LinkageMethod::CompleteLinkage), error), "dendrogram: stored next to the matrix");
+}
+
+static bool SameValues(const void* a, const void* b, size_t size)
+{
+	return size == 0 || (a && b && memcmp(a, b, size) == 0);
+}
+
+static bool SameVertexData(const VertexData& a, const VertexData& b)
+{
+	return a.numVertices == b.numVertices && a.numLineVertices == b.numLineVertices && a.numControlPoints == b.numControlPoints && a.numLines == b.numLines
+		&& SameValues(a.positions, b.positions, a.numVertices * 3 * sizeof(float)) && SameValues(a.id, b.id, a.numVertices * sizeof(int))
+		&& SameValues(a.importance, b.importance, a.numVertices * sizeof(float)) && SameValues(a.color, b.color, a.numVertices * sizeof(float))
+		&& SameValues(a.alphaWeights, b.alphaWeights, a.numVertices * sizeof(float))
+		&& SameValues(a.controlPointLineIndices, b.controlPointLineIndices, a.numControlPoints * sizeof(unsigned int))
+		&& SameValues(a.levels, b.levels, a.numLines * LINE_LOD_LEVELS * sizeof(LineLevel)) && SameValues(a.bounds, b.bounds, a.numLines * sizeof(XMFLOAT4));
+}
+
+static void CheckGeometryCache(const std::string& directory, const std::string& matrixPath)
+{
+	// own copy of the line set, its modification time changes below
+	const std::string linesPath = directory + "/cached.lines";
+	const std::string cacheDirectory = directory + "/cache";
+	WriteLineSet(linesPath, ClusterLines());
+
+	LineGeometry geometry(linesPath, matrixPath, RepresentativeMethod::MostImportantCurve, 64, CHECK_CLUSTERS);
+	geometry.ParseLineData(linesPath, "importance", "speed");
+	geometry.CalculateClusterReport(matrixPath, LinkageMethod::CompleteLinkage);
+	geometry.CalculateHierarchicalClustering();
+	geometry.LoadLineSet(geometry.GetClusteredObjectData());
+	const GeometryCacheKey key = { linesPath, "importance", "speed", matrixPath, LinkageMethod::CompleteLinkage, CHECK_CLUSTERS,
+		RepresentativeMethod::MostImportantCurve, 64, geometry.GetMeanLineSamples() };
+	Check(geometry.WriteGeometryCache(cacheDirectory, key), "geometry cache: write");
+
+	{
+		LineGeometry cached(linesPath, matrixPath, RepresentativeMethod::MostImportantCurve, 64, CHECK_CLUSTERS);
+		Check(cached.OpenGeometryCache(cacheDirectory, key) && SameVertexData(cached.GetVertexData(), geometry.GetVertexData()), "geometry cache: vertices and levels read back");
+	}
+
+	// other settings are another configuration
+	GeometryCacheKey otherKey = key;
+	otherKey.clusterSize++;
+	GeometryCacheFile file;
+	Check(!file.Open(cacheDirectory, otherKey), "geometry cache: other cluster size");
+
+	// the dataset changed since the file was written -> rejected and deleted
+	std::error_code error;
+	std::filesystem::last_write_time(linesPath, std::filesystem::last_write_time(linesPath) + std::chrono::hours(1), error);
+	Check(!file.Open(cacheDirectory, key) && !std::filesystem::exists(GeometryCacheFile::GetPath(cacheDirectory, key), error), "geometry cache: changed dataset rejected");
+
+	// the least recently used configuration is evicted, the newest one always stays
+	const std::string path = GeometryCacheFile::GetPath(cacheDirectory, key);
+	const std::string otherPath = GeometryCacheFile::GetPath(cacheDirectory, otherKey);
+	GeometryCacheFile::Write(cacheDirectory, key, geometry.GetVertexData());
+	GeometryCacheFile::Write(cacheDirectory, otherKey, geometry.GetVertexData());
+	std::filesystem::last_write_time(path, std::filesystem::last_write_time(otherPath) - std::chrono::hours(1), error);
+	GeometryCacheFile::Evict(cacheDirectory, std::filesystem::file_size(otherPath));
+	Check(!std::filesystem::exists(path, error) && std::filesystem::exists(otherPath, error), "geometry cache: least recently used evicted");
+	GeometryCacheFile::Evict(cacheDirectory, 0);
+	Check(std::filesystem::exists(otherPath, error), "geometry cache: newest kept");
+}
+
+// x of every vertex of the line set, the lines of the OBJ checks are all on the x axis
+static bool SameLines(const ObjectData& object, const std::vector<unsigned>& lineOffsets, const std::vector<float>& x)
+{
+	if (object.lineOffsets != lineOffsets || object.GetNumVertices() != x.size()) return false;
+	for (unsigned i = 0; i < object.GetNumVertices(); i++)
+	{
+		if (object.positions[i].x != x[i] || object.positions[i].y != 0.f || object.positions[i].z != 0.f) return false;
+	}
+	return true;
+}
+
+static void CheckObjectFile(const std::string& directory)
+{
+	// the fourth vertex is unreadable but still counts, "bad" and the comment are skipped, 0 / 99 / -99 point to no vertex
+	const std::string path = directory + "/check.obj";
+	{
+		std::ofstream out(path, std::ios::binary);
+		out << "# line set\r\nv 0 0 0\r\nv 1 0 0\r\nvt 0.5 0.25\r\nvt 0.75\r\nv 2 0 0\r\nv 3 x 0\r\nv 4 0 0\r\n"
+			<< "l 1 2 3\r\nl 1/1 bad 2/2 # comment\r\nl -3 -2 -1\r\nlod 1 2\r\nl 0 99 -99 1\r\nv\t5 0 0\r\nl -1 -2\r\n";
+	}
+	ObjectData object;
+	Check(ObjectFile::Read(path, object), "obj: read");
+	Check(SameLines(object, { 0, 3, 5, 7, 8, 10 }, { 0.f, 1.f, 2.f, 0.f, 1.f, 2.f, 4.f, 0.f, 5.f, 4.f }), "obj: crlf, relative indices and unreadable tokens");
+	Check(object.importance.size() == 10 && object.importance[0] == 0.5f && object.importance[1] == 0.75f && object.importance[2] == 0.f
+		&& object.scalarColor[0] == 0.25f && object.scalarColor[1] == 0.75f && object.scalarColor[7] == 0.25f, "obj: tex coords");
+
+	// relative indices that point into the chunk before
+	const std::string largePath = directory + "/large.obj";
+	{
+		std::ofstream out(largePath, std::ios::binary);
+		char record[64];
+		for (unsigned i = 1; i <= CHECK_OBJECT_VERTICES; i++)
+		{
+			snprintf(record, sizeof(record), "v %u.000000 0.000000 0.000000\r\n", i);
+			out << record;
+		}
+		out << "l -" << CHECK_OBJECT_VERTICES << " -1\r\nl 1 " << CHECK_OBJECT_VERTICES << "\r\n";
+		Check(out.tellp() > (std::streamoff)objectformat::CHUNK_SIZE, "obj: larger than a chunk");
+	}
+	ObjectData large;
+	ObjectFile::Read(largePath, large);
+	const float lastX = (float)CHECK_OBJECT_VERTICES;
+	Check(SameLines(large, { 0, 2, 4 }, { 1.f, lastX, 1.f, lastX }), "obj: relative indices across chunks");
+}
+
+// distance of p to the segment a b
+static float SegmentDistance(const XMFLOAT3& p, const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	const float abx = b.x - a.x, aby = b.y - a.y, abz = b.z - a.z;
+	const float apx = p.x - a.x, apy = p.y - a.y, apz = p.z - a.z;
+	const float lengthSquared = abx * abx + aby * aby + abz * abz;
+	const float t = lengthSquared > 0.f ? std::min(std::max((apx * abx + apy * aby + apz * abz) / lengthSquared, 0.f), 1.f) : 0.f;
+	const float dx = apx - t * abx, dy = apy - t * aby, dz = apz - t * abz;
+	return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+static bool SamePosition(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// camera like the viewer's (Camera::UpdateViewMatrix / UpdateProjMatrix), 1000 pixels high
+static LodView Camera(const XMFLOAT3& eye, const XMFLOAT3& at, float fov)
+{
+	LodView view = {};
+	XMStoreFloat4x4(&view.view, XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&at), XMVectorSet(0.f, 1.f, 0.f, 0.f)));
+	XMStoreFloat4x4(&view.projection, XMMatrixPerspectiveFovLH(fov, 1.f, 0.1f, 10000.f));
+	view.viewportHeight = 1000.f;
+	view.pixelError = 1.f;
+	view.margin = 0.05f;
+	return view;
+}
+
+static XMFLOAT3 ViewPosition(const LodView& view, const XMFLOAT4& position)
+{
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVector3Transform(XMLoadFloat4(&position), XMLoadFloat4x4(&view.view)));
+	return result;
+}
+
+// vertex inside the frustum, with the sides widened by the margin
+static bool Visible(const LodView& view, const XMFLOAT3& vertex)
+{
+	const XMFLOAT3 p = ViewPosition(view, XMFLOAT4(vertex.x, vertex.y, vertex.z, 1.f));
+	const float nearPlane = -view.projection._43 / view.projection._33;
+	const float farPlane = view.projection._43 / (1.f - view.projection._33);
+	const float side = (1.f + view.margin) * p.z;
+	return p.z >= nearPlane && p.z <= farPlane && std::fabs(p.x * view.projection._11) <= side && std::fabs(p.y * view.projection._22) <= side;
+}
+
+// every level is a subsequence of the finer one with the same end points, and the removed vertices stay within its error
+static void CheckLevels(const VertexData& data)
+{
+	const XMFLOAT3* positions = (const XMFLOAT3*)data.positions;
+	bool nested = true, bounded = true, placed = true;
+	unsigned numLevels = 0;
+	for (unsigned i = 0; i < data.numLines; i++)
+	{
+		const LineLevel* levels = data.levels + (size_t)i * LINE_LOD_LEVELS;
+		const XMFLOAT3* line = positions + levels[0].first;
+		placed = placed && levels[0].error == 0.f;
+		for (unsigned level = 1; level < LINE_LOD_LEVELS; level++)
+		{
+			const LineLevel& coarse = levels[level];
+			const LineLevel& fine = levels[level - 1];
+			nested = nested && coarse.error >= fine.error && coarse.count <= fine.count;
+			if (coarse.count == fine.count)
+			{
+				nested = nested && coarse.first == fine.first && coarse.error == fine.error;
+				continue;
+			}
+			numLevels++;
+			placed = placed && coarse.first >= data.numLineVertices && coarse.first + coarse.count <= data.numVertices && coarse.count >= LINE_LOD_MIN_VERTICES;
+			if (!placed) break;
+
+			const XMFLOAT3* kept = positions + coarse.first;
+			nested = nested && SamePosition(kept[0], line[0]) && SamePosition(kept[coarse.count - 1], line[levels[0].count - 1]);
+			unsigned f = 0;
+			for (unsigned k = 0; k < coarse.count; k++)
+			{
+				while (f < fine.count && !SamePosition(positions[fine.first + f], kept[k])) f++;
+				nested = nested && f < fine.count && data.id[coarse.first + k] == (int)i;
+			}
+
+			// removed vertices of the line to the segment between their kept neighbours
+			unsigned k = 0;
+			for (unsigned v = 1; v + 1 < levels[0].count && k + 1 < coarse.count; v++)
+			{
+				if (SamePosition(line[v], kept[k + 1]))
+				{
+					k++;
+					continue;
+				}
+				bounded = bounded && SegmentDistance(line[v], kept[k], kept[k + 1]) <= coarse.error * 1.001f + 1e-5f;
+			}
+		}
+	}
+	Check(placed, "levels: appended behind the lines");
+	Check(nested, "levels: nested with growing errors");
+	Check(bounded, "levels: removed vertices within the error");
+	Check(numLevels >= data.numLines, "levels: lines are simplified");
+}
+
+// the level choice of SelectLevels and the strip of every drawn line
+static void CheckSelection(const VertexData& data, const LodView& view, const LodSelection& selection, const char* name)
+{
+	const XMFLOAT3* positions = (const XMFLOAT3*)data.positions;
+	const float nearPlane = -view.projection._43 / view.projection._33;
+	const float pixelsPerUnit = view.projection._22 * 0.5f * view.viewportHeight;
+	bool culled = true, chosen = true, strips = true;
+	unsigned numVertices = 0;
+	strips = selection.levels.size() == data.numLines && selection.offsets.size() == data.numLines + 1 && selection.offsets[0] == 0
+		&& selection.indices.size() == selection.offsets[data.numLines];
+	for (unsigned i = 0; strips && i < data.numLines; i++)
+	{
+		const LineLevel* levels = data.levels + (size_t)i * LINE_LOD_LEVELS;
+		const unsigned begin = selection.offsets[i], end = selection.offsets[i + 1];
+		if (selection.levels[i] == LINE_LOD_CULLED)
+		{
+			for (unsigned v = 0; v < levels[0].count; v++)
+			{
+				culled = culled && !Visible(view, positions[levels[0].first + v]);
+			}
+			strips = strips && begin == end;
+			continue;
+		}
+
+		// coarsest level whose error is below the pixel error at the closest point of the bounding sphere
+		const unsigned level = selection.levels[i];
+		const float depth = ViewPosition(view, XMFLOAT4(data.bounds[i].x, data.bounds[i].y, data.bounds[i].z, 1.f)).z - data.bounds[i].w;
+		if (depth > nearPlane)
+		{
+			const float maxError = view.pixelError * depth / pixelsPerUnit;
+			chosen = chosen && level < LINE_LOD_LEVELS && levels[level].error <= maxError && (level + 1 == LINE_LOD_LEVELS || levels[level + 1].error > maxError);
+		}
+		else
+		{
+			chosen = chosen && level == 0;
+		}
+
+		// the shader reads i, i + 1 and i + 2 of every index before the strip cut
+		const LineLevel& drawn = levels[level];
+		if (drawn.count < LINE_LOD_MIN_VERTICES)
+		{
+			strips = strips && begin == end;
+			continue;
+		}
+		strips = strips && end - begin == drawn.count - 1 && selection.indices[end - 1] == LINE_LOD_STRIP_CUT;
+		for (unsigned k = 0; strips && k + 1 < end - begin; k++)
+		{
+			const unsigned index = selection.indices[begin + k];
+			strips = index == drawn.first + k && index + 2 < data.numVertices && data.id[index] == (int)i && data.id[index + 2] == (int)i;
+		}
+		numVertices += drawn.count;
+	}
+	strips = strips && numVertices == selection.numVertices;
+
+	std::string what = std::string(name) + ": culled lines outside of the frustum";
+	Check(culled, what.c_str());
+	what = std::string(name) + ": coarsest level within the pixel error";
+	Check(chosen, what.c_str());
+	what = std::string(name) + ": strip indices";
+	Check(strips, what.c_str());
+}
+
+static unsigned NumCulled(const LodSelection& selection)
+{
+	return (unsigned)std::count(selection.levels.begin(), selection.levels.end(), LINE_LOD_CULLED);
+}
+
+static void CheckLod(const std::string& detailPath)
+{
+	LineGeometry geometry(detailPath, "", RepresentativeMethod::FirstLine, 64, 0);
+	geometry.ParseLineData(detailPath, "importance", "speed");
+	geometry.LoadLineSet(geometry.GetObjectData());
+	const VertexData data = geometry.GetVertexData();
+	Check(data.numLines == CHECK_DETAIL_GRID * CHECK_DETAIL_GRID + 1, "levels: detailed line set");
+	if (data.numLines != CHECK_DETAIL_GRID * CHECK_DETAIL_GRID + 1) return;
+	CheckLevels(data);
+
+	// the whole set from the front, from far away, from the inside and looking away from it
+	const float middle = 0.5f * (CHECK_DETAIL_GRID - 1) * CHECK_DETAIL_SPACING;
+	const XMFLOAT3 center(middle, 0.5f * (CHECK_DETAIL_VERTICES - 1) * CHECK_DETAIL_STEP, middle);
+	const float fov = 3.14159265f / 4.f;
+	LodSelection front, distant, inside, away;
+	const LodView frontView = Camera(XMFLOAT3(center.x, center.y, -40.f), center, fov);
+	const LodView farView = Camera(XMFLOAT3(center.x, center.y, -2000.f), center, fov);
+	const LodView insideView = Camera(XMFLOAT3(0.f, center.y, -1.f), XMFLOAT3(0.f, center.y, 1.f), fov);
+	const LodView awayView = Camera(XMFLOAT3(center.x, center.y, -40.f), XMFLOAT3(center.x, center.y, -80.f), fov);
+	LineLod::SelectLevels(data.levels, data.bounds, data.numLines, frontView, front);
+	LineLod::SelectLevels(data.levels, data.bounds, data.numLines, farView, distant);
+	LineLod::SelectLevels(data.levels, data.bounds, data.numLines, insideView, inside);
+	LineLod::SelectLevels(data.levels, data.bounds, data.numLines, awayView, away);
+	CheckSelection(data, frontView, front, "front view");
+	CheckSelection(data, farView, distant, "far view");
+	CheckSelection(data, insideView, inside, "inside view");
+	CheckSelection(data, awayView, away, "away view");
+
+	Check(NumCulled(front) == 0 && front.levels.back() != LINE_LOD_CULLED && front.offsets[data.numLines] == front.offsets[data.numLines - 1], "front view: short line without indices");
+	Check(NumCulled(inside) > 0 && NumCulled(inside) < data.numLines, "inside view: lines beside the camera culled");
+	Check(NumCulled(away) == data.numLines && away.indices.empty() && away.numVertices == 0, "away view: all lines culled");
+
+	bool coarser = distant.numVertices < front.numVertices;
+	for (unsigned i = 0; i < data.numLines; i++)
+	{
+		coarser = coarser && distant.levels[i] >= front.levels[i];
+	}
+	Check(coarser, "far view: coarser levels");
+}
+
+int main(int, char*[])
+{
+	const std::string directory = (std::filesystem::temp_directory_path() / "vc_geometry_check").string();
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	const std::string linesPath = directory + "/check.lines";
+	const std::string matrixPath = directory + "/check.distb";
+	const std::string detailPath = directory + "/detail.lines";
+	if (!WriteLineSet(linesPath, ClusterLines()) || !WriteDistanceMatrix(matrixPath) || !WriteLineSet(detailPath, DetailLines()))
+	{
+		printf("can not write to %s\n", directory.c_str());
+		return 1;
+	}
+
+	CheckClustering(linesPath, matrixPath);
+	CheckFailedLoads(directory, linesPath);
+	CheckLoader(directory, linesPath, matrixPath);
+	CheckDendrogramFile(directory, matrixPath);
+	CheckGeometryCache(directory, matrixPath);
+	CheckObjectFile(directory);
+	CheckHierarchicalClustering();
+	CheckLod(detailPath);
+
+	std::filesystem::remove_all(directory);
+	printf("%d failed\n", g_Failures);
+	return g_Failures == 0 ? 0 : 1;
+}
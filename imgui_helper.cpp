@@ -43,7 +43,7 @@ void ImguiHelper::Create(HWND& hWnd, ID3D11Device* device, ID3D11DeviceContext*
 	ImGui_ImplDX11_Init(device, immediateContext);
 }
 
-void ImguiHelper::Draw(ID3D11DeviceContext* immediateContext, ID3D11RenderTargetView* renderTarget, Renderer* g_Renderer, D3D* g_D3D, Colormap* g_Colormap, Camera* g_Camera, Lines* Geometry, Scene* g_Scene)
+void ImguiHelper::Draw(ID3D11DeviceContext* immediateContext, ID3D11RenderTargetView* renderTarget, Renderer* g_Renderer, D3D* g_D3D, Colormap* g_Colormap, Camera* g_Camera, Lines* Geometry, Scene* g_Scene, DatasetLoader* Loader)
 {
 	ImGui_ImplDX11_NewFrame();
 	ImGui_ImplWin32_NewFrame();
@@ -54,7 +54,7 @@ void ImguiHelper::Draw(ID3D11DeviceContext* immediateContext, ID3D11RenderTarget
 		ImGui::ShowDemoWindow(&show_demo_window);
 	}
 
-	SceneWindow(immediateContext, g_D3D, Geometry, g_Scene);
+	SceneWindow(immediateContext, g_D3D, Geometry, g_Scene, Loader);
 	CameraWindow(g_Camera);
 	RenderParameterWindow(immediateContext, g_Renderer);
 	ColormapWindow(immediateContext, g_Renderer, g_D3D, g_Colormap);
@@ -262,7 +262,20 @@ void ImguiHelper::RenderParameterWindow(ID3D11DeviceContext* immediateContext, R
 	ImGui::End();
 }
 
-void ImguiHelper::SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D, Lines* Geometry, Scene* g_Scene)
+// clusters the shown line set again with the settings of the scene on the loader thread, swapped in like a loaded dataset
+static void StartClustering(DatasetLoader* Loader, Lines* Geometry, Scene* g_Scene, DistanceMatrixDescription& distanceMatrix)
+{
+	DatasetLoader::Request request;
+	request.distanceMatrixPath = g_Scene->ConstructDistanceMatrixPath(distanceMatrix);
+	request.linkage = g_Scene->GetLinkageMode();
+	request.method = Geometry->GetRepresentativeMethod();
+	request.totalNumCPs = Geometry->GetTotalNumberOfControlPoints();
+	request.meanLineSamples = Geometry->GetMeanLineSamples();
+	request.clusterSize = Geometry->GetClusterSize();
+	Loader->StartClustering(request, *Geometry);
+}
+
+void ImguiHelper::SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D, Lines* Geometry, Scene* g_Scene, DatasetLoader* Loader)
 {
 	ImGui::Begin("Scene");
 
@@ -348,36 +361,45 @@ void ImguiHelper::SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D,
 		}
 	}
 
-	if (ImGui::Button("Set Dataset", ImVec2(100.f, 20.f)))
+	// the dataset is parsed and clustered in the background, the current lines are drawn until it is swapped in (main.cpp)
+	if (Loader->IsLoading())
+	{
+		const DatasetLoader::Stage stage = Loader->GetStage();
+		ImGui::ProgressBar(Loader->GetProgress(), ImVec2(200.f, 20.f), Loader->StageToString(stage).c_str());
+	}
+	else if (ImGui::Button("Set Dataset", ImVec2(100.f, 20.f)))
 	{
-		std::string path = g_Scene->ConstructDatasetPath(currentItem);
-		Geometry->SetCurrentDataSet(path);
-		Geometry->Release();
-		Geometry->ReleaseObject(Geometry->GetObjectData());
-		Geometry->ReleaseObject(Geometry->GetClusteredObjectData());
-		Geometry->SetClusterSize(0);
-		Geometry->ParseLineData(path);
-		Geometry->LoadLineSet(Geometry->GetObjectData());
-		Geometry->Create(g_D3D->GetDevice());
-
 		g_Scene->SetCurrentDistanceMatrix(g_Scene->GetFirstMatchingDistanceMatrix(currentItem.name));
 		g_Scene->RefreshCurrentDistanceMatrixMetrics();
 		DistanceMatrixDescription& changedDistanceMatrix = g_Scene->GetCurrentDistanceMatrix();
-		if (changedDistanceMatrix.name != "Unknown") 
-		{
-			Geometry->CalculateClusterReport(g_Scene->ConstructDistanceMatrixPath(changedDistanceMatrix), g_Scene->GetLinkageMode());
-		}
+
+		DatasetLoader::Request request;
+		request.path = g_Scene->ConstructDatasetPath(currentItem);
+		request.importance = currentItem.importance;
+		request.scalarColor = currentItem.scalarColor;
+		request.distanceMatrixPath = changedDistanceMatrix.name != "Unknown" ? g_Scene->ConstructDistanceMatrixPath(changedDistanceMatrix) : "";
+		request.linkage = g_Scene->GetLinkageMode();
+		request.method = Geometry->GetRepresentativeMethod();
+		request.totalNumCPs = Geometry->GetTotalNumberOfControlPoints();
+		request.meanLineSamples = Geometry->GetMeanLineSamples();
+		request.clusterSize = 0;
+		Loader->Start(request);
 	}
 
 	int linkageMode = g_Scene->GetLinkageMode();
-	ImGui::RadioButton("Complete Linkage", &linkageMode, 0); ImGui::SameLine();
-	ImGui::RadioButton("Single Linkage", &linkageMode, 1);
+	ImGui::RadioButton("Complete Linkage", &linkageMode, LinkageMethod::CompleteLinkage); ImGui::SameLine();
+	ImGui::RadioButton("Single Linkage", &linkageMode, LinkageMethod::SingleLinkage);
+	ImGui::RadioButton("Average Linkage", &linkageMode, LinkageMethod::AverageLinkage); ImGui::SameLine();
+	ImGui::RadioButton("Ward Linkage", &linkageMode, LinkageMethod::WardLinkage);
 
 	if (linkageMode != g_Scene->GetLinkageMode())
 	{
 		g_Scene->SetLinkageMode(linkageMode);
 	}
 
+	// the clustering of the shown lines stays as it is while a dataset is loading,
+	// lines drawn from the geometry cache get their line set only when loading is finished
+	ImGui::BeginDisabled(Loader->IsLoading());
 	{
 		// fourth combo -> distance matrix selector
 		std::vector<std::string> distanceMetrics = g_Scene->GetCurrentDistanceMetrics();
@@ -424,27 +446,26 @@ void ImguiHelper::SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D,
 			Geometry->SetRepresentativeMethod(currentMethod);
 			if (currentDistanceMatrix.name != "Unknown")
 			{
-				Geometry->Release();
 				Geometry->ReleaseObject(Geometry->GetClusteredObjectData());
 				Geometry->CalculateHierarchicalClustering();
 				Geometry->LoadLineSet(Geometry->GetClusteredObjectData());
-				Geometry->Create(g_D3D->GetDevice());
+				Geometry->UpdateBuffers(g_D3D->GetDevice(), immediateContext);
 			}
 		}
 
 		std::string distanceMetric(currentDistanceMetric);
 		if (distanceMetric != currentDistanceMatrix.metric)
 		{
-			currentDistanceMatrix.metric = distanceMetric;
+			currentDistanceMatrix = g_Scene->GetFirstMatchingDistanceMatrix(currentDistanceMatrix.name, distanceMetric);
 			g_Scene->SetCurrentDistanceMatrix(currentDistanceMatrix);
 			if (currentDistanceMatrix.name != "Unknown")
 			{
-				Geometry->CalculateClusterReport(g_Scene->ConstructDistanceMatrixPath(currentDistanceMatrix), g_Scene->GetLinkageMode());
+				StartClustering(Loader, Geometry, g_Scene, currentDistanceMatrix);
 			}
 		}
 	}
 
-	// select cluster size
+	// select cluster size, the representatives of the cut are uploaded into the existing gpu buffers
 	int clusterSize = Geometry->GetClusterSize();
 	int lineAmount = Geometry->GetTotalLineAmount();
 	ImGui::SliderInt("Cluster Count", &clusterSize, 0, lineAmount);
@@ -454,24 +475,54 @@ void ImguiHelper::SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D,
 		Geometry->SetClusterSize(clusterSize);
 		if (currentDistanceMatrix.name != "Unknown")
 		{
-			Geometry->Release();
 			Geometry->ReleaseObject(Geometry->GetClusteredObjectData());
 			Geometry->CalculateHierarchicalClustering();
 			Geometry->LoadLineSet(Geometry->GetClusteredObjectData());
-			Geometry->Create(g_D3D->GetDevice());
+			Geometry->UpdateBuffers(g_D3D->GetDevice(), immediateContext);
 		}
 	}
 
-	if (ImGui::Button("Set Cluster size", ImVec2(200.f, 20.f)))
+	// resolution of the mean lines
+	int meanLineSamples = Geometry->GetMeanLineSamples();
+	ImGui::SliderInt("Mean Line Samples", &meanLineSamples, 2, 1024);
+
+	if (meanLineSamples != Geometry->GetMeanLineSamples())
 	{
-		if (currentDistanceMatrix.name != "Unknown")
+		Geometry->SetMeanLineSamples(meanLineSamples);
+		if (currentDistanceMatrix.name != "Unknown" && Geometry->GetRepresentativeMethod() == RepresentativeMethod::MeanLine)
 		{
-			Geometry->Release();
 			Geometry->ReleaseObject(Geometry->GetClusteredObjectData());
-			Geometry->CalculateClusterReport(g_Scene->ConstructDistanceMatrixPath(currentDistanceMatrix), g_Scene->GetLinkageMode());
 			Geometry->CalculateHierarchicalClustering();
 			Geometry->LoadLineSet(Geometry->GetClusteredObjectData());
-			Geometry->Create(g_D3D->GetDevice());
+			Geometry->UpdateBuffers(g_D3D->GetDevice(), immediateContext);
+		}
+	}
+
+	if (ImGui::Button("Set Cluster size", ImVec2(200.f, 20.f)))
+	{
+		if (currentDistanceMatrix.name != "Unknown")
+		{
+			StartClustering(Loader, Geometry, g_Scene, currentDistanceMatrix);
+		}
+	}
+	ImGui::EndDisabled();
+
+	bool levelOfDetail = Geometry->GetLevelOfDetail();
+	ImGui::Checkbox("Level of Detail", &levelOfDetail);
+	if (levelOfDetail != Geometry->GetLevelOfDetail()) Geometry->SetLevelOfDetail(levelOfDetail);
+
+	float lodPixelError = Geometry->GetLodPixelError();
+	ImGui::SliderFloat("LOD Pixel Error", &lodPixelError, 0.1f, 8.f);
+	if (lodPixelError != Geometry->GetLodPixelError()) Geometry->SetLodPixelError(lodPixelError);
+	ImGui::Text("Drawn vertices: %u of %d", Geometry->GetLodVertices(), Geometry->GetNumberOfLineVertices());
+
+	// time of the last representative pick per method
+	for (int method = RepresentativeMethod::START + 1; method < RepresentativeMethod::END; method++)
+	{
+		const float time = Geometry->GetRepresentativeTime((RepresentativeMethod)method);
+		if (time >= 0.f)
+		{
+			ImGui::Text("%s: %.2f ms", Geometry->RepresentativeToString((RepresentativeMethod)method).c_str(), time);
 		}
 	}
 
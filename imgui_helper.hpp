@@ -6,6 +6,7 @@
 #include <backends/imgui_impl_dx11.h>
 #include "renderer.hpp"
 #include "scene.hpp"
+#include "datasetloader.hpp"
 #include <iostream>
 
 
@@ -16,13 +17,13 @@ public:
 	~ImguiHelper();
 
 	void Create(HWND& hWnd, ID3D11Device* device, ID3D11DeviceContext* immediateContext);
-	void Draw(ID3D11DeviceContext* immediateContext, ID3D11RenderTargetView* renderTarget, Renderer* g_Renderer, D3D* g_D3D, Colormap* g_Colormap, Camera* g_Camera, Lines* Geometry, Scene* g_Scene);
+	void Draw(ID3D11DeviceContext* immediateContext, ID3D11RenderTargetView* renderTarget, Renderer* g_Renderer, D3D* g_D3D, Colormap* g_Colormap, Camera* g_Camera, Lines* Geometry, Scene* g_Scene, DatasetLoader* Loader);
 	void HistogramEqualizationWindow(ID3D11DeviceContext* immediateContext, Renderer* g_Renderer, D3D* g_D3D, Colormap* g_Colormap);
 	void HistogramDampingWindow(ID3D11DeviceContext* immediateContext, Renderer* g_Renderer, D3D* g_D3D);
 	void ColormapWindow(ID3D11DeviceContext* immediateContext, Renderer* g_Renderer, D3D* g_D3D, Colormap* g_Colormap);
 	void CameraWindow(Camera* g_Camera);
 	void RenderParameterWindow(ID3D11DeviceContext* immediateContext, Renderer* g_Renderer);
-	void SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D, Lines* Geometry, Scene* g_Scene);
+	void SceneWindow(ID3D11DeviceContext* immediateContext, D3D* g_D3D, Lines* Geometry, Scene* g_Scene, DatasetLoader* Loader);
 
 	void PlotHistogram(ID3D11DeviceContext* immediateContext, vislab::RenderTarget2dD3D11& Histogram, const char* text);
 	void PlotCDF(ID3D11DeviceContext* immediateContext, vislab::BufferD3D11& CDF, const char* text);
@@ -0,0 +1,934 @@
+#include "linegeometry.hpp"
+#include "lineset.hpp"
+#include "objectfile.hpp"
+#include "linelod.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <cassert>
+#include <cstring>
+#include <cfloat>
+
+static const size_t REPRESENTATIVE_CACHE_SIZE = 16;
+static const size_t REPRESENTATIVE_CACHE_VERTICES = 4;	// cached vertices in multiples of the line set
+static const unsigned MEAN_LINE_SAMPLES = 128;
+static const float LINE_LOD_REDUCTION = 2.f / 3.f;		// vertices of a level of detail compared to the next finer one, at most
+
+LineGeometry::LineGeometry(const std::string& path, const std::string& distanceMatrixPath, const RepresentativeMethod repMethod, const int totalNumCPs, const unsigned clusterSize) :
+	_TotalNumberOfControlPoints(totalNumCPs),
+	mClusterSize(clusterSize),
+	mCurrentDataset(path),
+	mCurrentDistanceMatrixPath(distanceMatrixPath),
+	mRepresentativeMethod(repMethod),
+	mMeanLineSamples(MEAN_LINE_SAMPLES)
+{
+	mRepresentativeTimes.fill(-1.f);
+}
+
+void LineGeometry::ReleaseObject(ObjectData& object)
+{
+	object.positions.clear();
+	object.importance.clear();
+	object.scalarColor.clear();
+	object.lineOffsets.clear();
+	object.arcLength.clear();
+	object.simplificationError.clear();
+}
+
+void LineGeometry::ReleaseObject(ClusteredObjectData& clusteredObject)
+{
+	clusteredObject.lineIDs.clear();
+	ReleaseObject(clusteredObject.computed);
+}
+
+// set the value of mObject
+void LineGeometry::ParseLineData(const std::string& path, const std::string& importance, const std::string& scalarColor)
+{
+	ClearClusterCache();
+	mCurrentDataset = path;
+	mCurrentImportance = importance;
+	mCurrentScalarColor = scalarColor;
+	if (std::filesystem::path(path).extension() == ".lines")
+	{
+		LineGeometry::ParseLineSet(path, importance, scalarColor);
+	}
+	else
+	{
+		ObjectFile::Read(path, mObject);
+	}
+	LineGeometry::CalculateArcLength(mObject);
+	LineGeometry::CalculateSimplificationError(mObject);
+}
+
+void LineGeometry::CopyLineSet(const LineGeometry& other)
+{
+	ClearClusterCache();
+	mCurrentDataset = other.mCurrentDataset;
+	mCurrentImportance = other.mCurrentImportance;
+	mCurrentScalarColor = other.mCurrentScalarColor;
+	mObject = other.mObject;
+}
+
+// set the value of mObject from a mapped line set -> only the geometry and the two selected properties are read
+void LineGeometry::ParseLineSet(const std::string& path, const std::string& importance, const std::string& scalarColor)
+{
+	ReleaseObject(mObject);
+
+	LineSetFile file;
+	if (!file.Open(path) || file.GetNumProperties() == 0)
+	{
+		return;
+	}
+
+	// unknown importance -> first property, unknown scalarColor -> use the importance instead
+	const float* importances = file.FindProperty(importance);
+	if (!importances)
+	{
+		importances = file.FindProperty(file.GetProperty(0).name);
+	}
+	const float* scalarColors = file.FindProperty(scalarColor);
+	if (!scalarColors)
+	{
+		scalarColors = importances;
+	}
+
+	// same layout as the line set -> one copy per array
+	const uint64_t* lineOffsets = file.GetLineOffsets();
+	const XMFLOAT3* positions = (const XMFLOAT3*)file.GetPositions();
+	const uint64_t numVertices = file.GetNumVertices();
+	mObject.positions.assign(positions, positions + numVertices);
+	mObject.importance.assign(importances, importances + numVertices);
+	mObject.scalarColor.assign(scalarColors, scalarColors + numVertices);
+	mObject.lineOffsets.assign(lineOffsets, lineOffsets + file.GetNumLines() + 1);
+}
+
+// arc length of every vertex, once per line set -> loading a cluster cut only reads the lengths of its lines
+void LineGeometry::CalculateArcLength(ObjectData& object)
+{
+	object.arcLength.resize(object.GetNumVertices());
+	const int numLines = (int)object.GetNumLines();
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int line = 0; line < numLines; line++)
+	{
+		const XMFLOAT3* points = object.GetLine(line);
+		float* arcLength = object.arcLength.data() + object.lineOffsets[line];
+		float length = 0;
+		for (unsigned int id = 0; id < object.GetNumVertices(line); ++id)
+		{
+			if (id > 0)
+			{
+				length += LineGeometry::CalculatePointDistance(&points[id - 1], &points[id]);
+			}
+			arcLength[id] = length;
+		}
+	}
+}
+
+// Douglas-Peucker errors of every vertex, once per line set -> the levels of detail of a cluster cut are filtered from them
+void LineGeometry::CalculateSimplificationError(ObjectData& object)
+{
+	object.simplificationError.resize(object.GetNumVertices());
+	const int numLines = (int)object.GetNumLines();
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int line = 0; line < numLines; line++)
+	{
+		LineLod::CalculateSimplificationError(object.GetLine(line), object.GetNumVertices(line), object.simplificationError.data() + object.lineOffsets[line]);
+	}
+}
+
+float LineGeometry::CalculatePointDistance(const XMFLOAT3* a, const XMFLOAT3* b)
+{
+	XMVECTOR point0 = XMLoadFloat3(a);
+	XMVECTOR point1 = XMLoadFloat3(b);
+	float distance = 0;
+	XMStoreFloat(&distance, XMVector3Length(point0 - point1));
+	return distance;
+}
+
+void LineGeometry::DistributePolylines(const unsigned int lines_amount, const float accumLineLength, const unsigned totalNumberOfControlPoints, const std::vector<float>& lineLengths, std::vector<int>& numberOfControlPointsOfLine)
+{
+	assert(totalNumberOfControlPoints * 2 > lines_amount);
+	numberOfControlPointsOfLine.assign(lines_amount, 0);
+	if (lines_amount == 0)
+	{
+		return;
+	}
+
+	// calculate the average length of a polyline segment
+	float lengthPerPatch = accumLineLength / totalNumberOfControlPoints;
+
+	// we first make sure that lines shorter than this length receive two polyline segments
+	unsigned int remPatches = totalNumberOfControlPoints;
+	float remLength = accumLineLength;
+	for (int lineId = 0; lineId < lines_amount; ++lineId)
+	{
+		float length = lineLengths[lineId];
+		if (length <= lengthPerPatch)
+		{
+			numberOfControlPointsOfLine[lineId] = 2;
+			remPatches -= 2;
+			remLength -= length;
+		}
+	}
+
+	// the remaining polyline segments are distributed among the other lines
+	std::vector<std::pair<float, unsigned int>> remainder;
+	unsigned int assignedPatches = 0;
+	for (unsigned int lineId = 0; lineId < lines_amount; ++lineId)
+	{
+		float length = lineLengths[lineId];
+		if (length > lengthPerPatch)
+		{
+			float numPatches = length / remLength * remPatches;
+			numberOfControlPointsOfLine[lineId] = (unsigned int)numPatches;
+			assignedPatches += (int)numPatches;
+			remainder.push_back(std::pair<float, unsigned int>(numPatches - (unsigned int)numPatches, lineId));
+		}
+	}
+
+	// due to rounding a few segments are not yet assigned -> one more for each of the lines with the largest remainders.
+	// Partitioning instead of sorting: lines with equal remainders are all kept, ties go to the lower line id.
+	assert(assignedPatches <= remPatches);
+	const size_t missing = std::min<size_t>(remPatches - assignedPatches, remainder.size());
+	if (missing == 0)
+	{
+		return;
+	}
+	auto larger = [](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); };
+	std::nth_element(remainder.begin(), remainder.begin() + (missing - 1), remainder.end(), larger);
+	for (size_t i = 0; i < missing; i++)
+	{
+		numberOfControlPointsOfLine[remainder[i].second] += 1;
+	}
+}
+
+void LineGeometry::LoadLineSet(const ObjectData& object)
+{
+	LoadLines(object, NULL, object.GetNumLines());
+}
+
+void LineGeometry::LoadLineSet(const ClusteredObjectData& clusteredObject)
+{
+	if (clusteredObject.lineIDs.empty())
+	{
+		LoadLines(clusteredObject.computed, NULL, clusteredObject.computed.GetNumLines());
+	}
+	else
+	{
+		LoadLines(mObject, clusteredObject.lineIDs.data(), (unsigned)clusteredObject.lineIDs.size());
+	}
+}
+
+bool LineGeometry::OpenGeometryCache(const std::string& directory, const GeometryCacheKey& key)
+{
+	if (!mGeometryCache.Open(directory, key) || mGeometryCache.GetVertexData().numControlPoints != (unsigned)_TotalNumberOfControlPoints)
+	{
+		mGeometryCache.Close();
+		return false;
+	}
+	return true;
+}
+
+bool LineGeometry::WriteGeometryCache(const std::string& directory, const GeometryCacheKey& key) const
+{
+	return GeometryCacheFile::Write(directory, key, GetVertexData());
+}
+
+VertexData LineGeometry::GetVertexData() const
+{
+	if (mGeometryCache.IsOpen())
+	{
+		return mGeometryCache.GetVertexData();
+	}
+
+	VertexData data;
+	data.positions = (const float*)_Positions.data();
+	data.id = _ID.data();
+	data.importance = _Importance.data();
+	data.color = _Color.data();
+	data.alphaWeights = _AlphaWeights.data();
+	data.controlPointLineIndices = _ControlPointLineIndices.data();
+	data.levels = _LineLevels.data();
+	data.bounds = _LineBounds.data();
+	data.numVertices = (unsigned)_Positions.size();
+	data.numLineVertices = _VertexOffsets.empty() ? 0 : _VertexOffsets.back();
+	data.numControlPoints = (unsigned)_ControlPointLineIndices.size();
+	data.numLines = (unsigned)_LineBounds.size();
+	return data;
+}
+
+// lineIDs: lines of the object to load, NULL -> all lines
+// Only the selected lines are touched: their lengths come from the cached arc length, the vertex / control point offsets are a prefix sum
+// and the lines are then copied in parallel.
+void LineGeometry::LoadLines(const ObjectData& object, const unsigned* lineIDs, unsigned numLines)
+{
+	// the staging arrays are valid again
+	mGeometryCache.Close();
+
+	// total line length and the first vertex of every line
+	_LineLengths.resize(numLines);
+	_VertexOffsets.resize(numLines + 1);
+	float accumLineLength = 0;
+	unsigned int totalNumPoints = 0;
+	for (unsigned int i = 0; i < numLines; i++)
+	{
+		const unsigned line = lineIDs ? lineIDs[i] : i;
+		_LineLengths[i] = object.GetLineLength(line);
+		accumLineLength += _LineLengths[i];
+		_VertexOffsets[i] = totalNumPoints;
+		totalNumPoints += object.GetNumVertices(line);
+	}
+	_VertexOffsets[numLines] = totalNumPoints;
+
+	// Distribute polyline segments (here sometimes called control points) among the lines so that they are roughly equally-sized.
+	LineGeometry::DistributePolylines(numLines, accumLineLength, _TotalNumberOfControlPoints, _LineLengths, _NumberOfControlPointsOfLine);
+	_ControlPointOffsets.resize(numLines + 1);
+	_ControlPointOffsets[0] = 0;
+	for (unsigned int i = 0; i < numLines; i++)
+	{
+		_ControlPointOffsets[i + 1] = _ControlPointOffsets[i] + _NumberOfControlPointsOfLine[i];
+	}
+
+	// positions, IDs, importance / scalarColor and the (alpha) control weights in linear memory for the gpu, every line on its own
+	_Positions.resize(totalNumPoints);
+	_ID.resize(totalNumPoints);
+	_Importance.resize(totalNumPoints);
+	_Color.resize(totalNumPoints);
+	_AlphaWeights.resize(totalNumPoints);
+	_ControlPointLineIndices.resize(_TotalNumberOfControlPoints);
+	const unsigned int totalNumCPs = (unsigned int)_ControlPointLineIndices.size();
+	const int numLoadedLines = (int)numLines;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < numLoadedLines; i++)
+	{
+		const unsigned line = lineIDs ? lineIDs[i] : i;
+		const unsigned numPoints = object.GetNumVertices(line);
+		const unsigned offset = _VertexOffsets[i];
+		const int numCp = _NumberOfControlPointsOfLine[i];
+		const float cpOffset = (float)_ControlPointOffsets[i];
+		const XMFLOAT3* positions = object.GetLine(line);
+		std::transform(positions, positions + numPoints, _Positions.begin() + offset, [](const XMFLOAT3& p) { return Vec3f(p.x, p.y, p.z); });
+		memcpy(&_Importance[offset], object.GetImportance(line), numPoints * sizeof(float));
+		memcpy(&_Color[offset], object.GetScalarColor(line), numPoints * sizeof(float));
+		std::fill(_ID.begin() + offset, _ID.begin() + offset + numPoints, i);
+
+		// Compute the blending weight parameterization (position between the control points of the line)
+		const float* arcLength = object.GetArcLength(line);
+		for (unsigned int id = 0; id < numPoints; ++id)
+		{
+			_AlphaWeights[offset + id] = id == 0 ? 0.f : std::min(arcLength[id] / _LineLengths[i] * (numCp - 1), numCp - 1 - 0.0001f);
+			_AlphaWeights[offset + id] += cpOffset;
+		}
+
+		std::fill(_ControlPointLineIndices.begin() + std::min(_ControlPointOffsets[i], totalNumCPs), _ControlPointLineIndices.begin() + std::min(_ControlPointOffsets[i + 1], totalNumCPs), (unsigned int)i);
+	}
+
+	LineGeometry::LoadLevels(object, lineIDs, numLines);
+}
+
+// Levels of detail: the coarser versions of every loaded line are appended to the vertex data of the lines.
+// Each level is a consecutive copy of the kept vertices (with their alpha weights), so it is drawn like the line itself,
+// and levels that remove less than a third of the vertices share the range of the finer level (at most three times the vertices in total). LineLod::SelectLevels picks one per line and frame.
+void LineGeometry::LoadLevels(const ObjectData& object, const unsigned* lineIDs, unsigned numLines)
+{
+	const unsigned numLineVertices = _VertexOffsets[numLines];
+	const int numLoadedLines = (int)numLines;
+	_LineLevels.resize((size_t)numLines * LINE_LOD_LEVELS);
+	_LineBounds.resize(numLines);
+
+	// bounding sphere of every line, the tolerances of the levels are relative to the size of the line set
+	std::vector<XMFLOAT3> lower(numLines), upper(numLines);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < numLoadedLines; i++)
+	{
+		XMFLOAT3 low(FLT_MAX, FLT_MAX, FLT_MAX), high(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (unsigned v = _VertexOffsets[i]; v < _VertexOffsets[i + 1]; v++)
+		{
+			low = XMFLOAT3(std::min(low.x, _Positions[v].x), std::min(low.y, _Positions[v].y), std::min(low.z, _Positions[v].z));
+			high = XMFLOAT3(std::max(high.x, _Positions[v].x), std::max(high.y, _Positions[v].y), std::max(high.z, _Positions[v].z));
+		}
+		lower[i] = low;
+		upper[i] = high;
+		const float dx = high.x - low.x, dy = high.y - low.y, dz = high.z - low.z;
+		_LineBounds[i] = _VertexOffsets[i + 1] > _VertexOffsets[i] ? XMFLOAT4((low.x + high.x) * 0.5f, (low.y + high.y) * 0.5f, (low.z + high.z) * 0.5f, 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz)) : XMFLOAT4(0.f, 0.f, 0.f, 0.f);
+	}
+	XMFLOAT3 low(FLT_MAX, FLT_MAX, FLT_MAX), high(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (unsigned i = 0; i < numLines; i++)
+	{
+		if (_VertexOffsets[i + 1] == _VertexOffsets[i]) continue;
+		low = XMFLOAT3(std::min(low.x, lower[i].x), std::min(low.y, lower[i].y), std::min(low.z, lower[i].z));
+		high = XMFLOAT3(std::max(high.x, upper[i].x), std::max(high.y, upper[i].y), std::max(high.z, upper[i].z));
+	}
+	const float extent = high.x >= low.x ? std::sqrt((high.x - low.x) * (high.x - low.x) + (high.y - low.y) * (high.y - low.y) + (high.z - low.z) * (high.z - low.z)) : 0.f;
+
+	// vertices and error of every level, the new levels are numbered relative to the level vertices of their line
+	std::vector<unsigned> levelOffsets(numLines + 1, 0);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < numLoadedLines; i++)
+	{
+		const unsigned line = lineIDs ? lineIDs[i] : i;
+		const float* error = object.GetSimplificationError(line);
+		const unsigned numPoints = object.GetNumVertices(line);
+		LineLevel* levels = &_LineLevels[(size_t)i * LINE_LOD_LEVELS];
+		levels[0] = { _VertexOffsets[i], numPoints, 0.f };
+		unsigned levelVertices = 0;
+		for (unsigned level = 1; level < LINE_LOD_LEVELS; level++)
+		{
+			const float tolerance = LineLod::GetLevelTolerance(level, extent);
+			unsigned count = 0;
+			float levelError = 0.f;
+			for (unsigned v = 0; v < numPoints; v++)
+			{
+				if (error[v] >= tolerance) count++;
+				else levelError = std::max(levelError, error[v]);
+			}
+			if (count > LINE_LOD_REDUCTION * levels[level - 1].count || count < LINE_LOD_MIN_VERTICES)
+			{
+				levels[level] = levels[level - 1];
+				continue;
+			}
+			levels[level] = { levelVertices, count, levelError };
+			levelVertices += count;
+		}
+		levelOffsets[i + 1] = levelVertices;
+	}
+	for (unsigned i = 0; i < numLines; i++)
+	{
+		levelOffsets[i + 1] += levelOffsets[i];
+	}
+
+	const unsigned numVertices = numLineVertices + levelOffsets[numLines];
+	_Positions.resize(numVertices);
+	_ID.resize(numVertices);
+	_Importance.resize(numVertices);
+	_Color.resize(numVertices);
+	_AlphaWeights.resize(numVertices);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < numLoadedLines; i++)
+	{
+		const unsigned line = lineIDs ? lineIDs[i] : i;
+		const float* error = object.GetSimplificationError(line);
+		LineLevel* levels = &_LineLevels[(size_t)i * LINE_LOD_LEVELS];
+		for (unsigned level = 1; level < LINE_LOD_LEVELS; level++)
+		{
+			// shared with the finer level
+			if (levels[level].count == levels[level - 1].count)
+			{
+				levels[level].first = levels[level - 1].first;
+				continue;
+			}
+
+			levels[level].first += numLineVertices + levelOffsets[i];
+			const float tolerance = LineLod::GetLevelTolerance(level, extent);
+			unsigned target = levels[level].first;
+			for (unsigned v = 0; v < levels[0].count; v++)
+			{
+				if (error[v] < tolerance) continue;
+				const unsigned source = levels[0].first + v;
+				_Positions[target] = _Positions[source];
+				_ID[target] = _ID[source];
+				_Importance[target] = _Importance[source];
+				_Color[target] = _Color[source];
+				_AlphaWeights[target] = _AlphaWeights[source];
+				target++;
+			}
+		}
+	}
+}
+
+void LineGeometry::CalculateHierarchicalClustering()
+{
+	// no clustering -> show all lines
+	if (mClusterSize == 0 || mClusterSize > mObject.GetNumLines() || mDendrogram.numLines != mObject.GetNumLines())
+	{
+		ReleaseObject(mClusteredObject);
+		mClusteredObject.lineIDs.resize(mObject.GetNumLines());
+		std::iota(mClusteredObject.lineIDs.begin(), mClusteredObject.lineIDs.end(), 0);
+		return;
+	}
+
+	for (auto entry = mRepresentativeCache.begin(); entry != mRepresentativeCache.end(); entry++)
+	{
+		if (entry->clusterSize == mClusterSize && entry->method == mRepresentativeMethod)
+		{
+			mRepresentativeCache.splice(mRepresentativeCache.begin(), mRepresentativeCache, entry);
+			mClusteredObject = mRepresentativeCache.front().clusteredObject;
+			return;
+		}
+	}
+
+	const std::vector<unsigned>& clusterMapping = mDendrogramCut.Cut(mDendrogram, mClusterSize);
+
+	PickClusterRepresentatives(mRepresentativeMethod, clusterMapping, 1.0, 1.0);
+
+	mRepresentativeCache.push_front({ mClusterSize, mRepresentativeMethod, mClusteredObject });
+	// picked lines are only ids, computed lines count with their vertices
+	size_t cachedVertices = 0;
+	for (const RepresentativeCacheEntry& entry : mRepresentativeCache)
+	{
+		cachedVertices += entry.clusteredObject.computed.GetNumVertices();
+	}
+	while (mRepresentativeCache.size() > 1 && (mRepresentativeCache.size() > REPRESENTATIVE_CACHE_SIZE || cachedVertices > REPRESENTATIVE_CACHE_VERTICES * mObject.GetNumVertices()))
+	{
+		cachedVertices -= mRepresentativeCache.back().clusteredObject.computed.GetNumVertices();
+		mRepresentativeCache.pop_back();
+	}
+}
+
+void LineGeometry::SetMeanLineSamples(unsigned value)
+{
+	mMeanLineSamples = std::max(value, 2u);
+	// cached mean lines have the old resolution
+	mRepresentativeCache.remove_if([](const RepresentativeCacheEntry& entry) { return entry.method == RepresentativeMethod::MeanLine; });
+}
+
+// the cuts and their representatives belong to one dendrogram of one line set
+void LineGeometry::ClearClusterCache()
+{
+	mDendrogramCut.Reset();
+	mRepresentativeCache.clear();
+	mLineImportance.clear();
+}
+
+void LineGeometry::PickClusterRepresentatives(RepresentativeMethod method, const std::vector<unsigned>& clusterMapping, double importanceWeight, double scalarWeight)
+{
+	const auto start = std::chrono::steady_clock::now();
+	ReleaseObject(mClusteredObject);
+
+	// group the lines by cluster once (counting sort), every method then works on one cluster at a time
+	ClusterMembers clusters;
+	clusters.offsets.assign(mClusterSize + 1, 0);
+	for (unsigned clusterID : clusterMapping)
+	{
+		clusters.offsets[clusterID + 1]++;
+	}
+	for (unsigned clusterID = 0; clusterID < mClusterSize; clusterID++)
+	{
+		clusters.offsets[clusterID + 1] += clusters.offsets[clusterID];
+	}
+	clusters.lines.resize(clusterMapping.size());
+	std::vector<unsigned> next(clusters.offsets.begin(), clusters.offsets.end() - 1);
+	for (unsigned lineID = 0; lineID < clusterMapping.size(); lineID++)
+	{
+		clusters.lines[next[clusterMapping[lineID]]++] = lineID;
+	}
+
+	// pick representatives for each cluster -> computed lines or one line id per cluster
+	if (method != RepresentativeMethod::MeanLine)
+	{
+		mClusteredObject.lineIDs.resize(mClusterSize);
+	}
+	switch (method)
+	{
+	case RepresentativeMethod::FirstLine:
+	{
+		FirstRepresentatives(clusters);
+		break;
+	}
+	case RepresentativeMethod::MeanLine:
+	{
+		MeanRepresentatives(clusters, importanceWeight, scalarWeight);
+		break;
+	}
+	case RepresentativeMethod::LeastDistanceCurve:
+	{
+		LeastDistanceRepresentatives(clusters);
+		break;
+	}
+	case RepresentativeMethod::MostImportantCurve:
+	{
+		MostImportantRepresentatives(clusters);
+		break;
+	}
+	default:
+		break;
+	}
+
+	if (method > RepresentativeMethod::START && method < RepresentativeMethod::END)
+	{
+		mRepresentativeTimes[method] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+void LineGeometry::SetRepresentative(unsigned clusterID, unsigned lineID)
+{
+	mClusteredObject.lineIDs[clusterID] = lineID;
+}
+
+void LineGeometry::FirstRepresentatives(const ClusterMembers& clusters)
+{
+	// the members are sorted -> the first one is the first line found while iterating
+	const int numClusters = (int)mClusterSize;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for (int clusterID = 0; clusterID < numClusters; clusterID++)
+	{
+		SetRepresentative(clusterID, clusters.lines[clusters.offsets[clusterID]]);
+	}
+}
+
+// Mean line per cluster:
+// every line is resampled to mMeanLineSamples points at equal arc length, so all lines keep their full length
+// (averaging by vertex index only works up to the shortest line of the cluster and mixes different positions along the lines).
+// Lines are flipped to run in the direction of the first line of the cluster, otherwise opposite lines cancel each other out.
+// The samples are stored in a flat buffer (x, y, z, importance, scalarColor blocks) and summed four floats at a time.
+static void ResampleLine(const XMFLOAT3* line, const float* importance, const float* scalarColor, unsigned numPoints, bool reverse, unsigned numSamples, unsigned stride, std::vector<float>& arcLength, float* samples)
+{
+	auto point = [&](unsigned i) { return reverse ? numPoints - 1 - i : i; };
+
+	arcLength.resize(numPoints);
+	arcLength[0] = 0.f;
+	for (unsigned i = 1; i < numPoints; i++)
+	{
+		const XMFLOAT3& p0 = line[point(i - 1)];
+		const XMFLOAT3& p1 = line[point(i)];
+		const float dx = p1.x - p0.x, dy = p1.y - p0.y, dz = p1.z - p0.z;
+		arcLength[i] = arcLength[i - 1] + std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	const float length = arcLength[numPoints - 1];
+	unsigned segment = 0;
+	for (unsigned sample = 0; sample < numSamples; sample++)
+	{
+		// arc length of the sample and the segment containing it
+		const float s = numSamples > 1 ? length * (float)sample / (float)(numSamples - 1) : 0.f;
+		while (segment + 2 < numPoints && arcLength[segment + 1] < s) segment++;
+		const unsigned i0 = point(segment);
+		const unsigned i1 = point(std::min(segment + 1, numPoints - 1));
+		const float segmentLength = numPoints > 1 ? arcLength[std::min(segment + 1, numPoints - 1)] - arcLength[segment] : 0.f;
+		const float t = segmentLength > 0.f ? std::min(std::max((s - arcLength[segment]) / segmentLength, 0.f), 1.f) : 0.f;
+
+		samples[0 * stride + sample] = line[i0].x + t * (line[i1].x - line[i0].x);
+		samples[1 * stride + sample] = line[i0].y + t * (line[i1].y - line[i0].y);
+		samples[2 * stride + sample] = line[i0].z + t * (line[i1].z - line[i0].z);
+		samples[3 * stride + sample] = importance[i0] + t * (importance[i1] - importance[i0]);
+		samples[4 * stride + sample] = scalarColor[i0] + t * (scalarColor[i1] - scalarColor[i0]);
+	}
+}
+
+void LineGeometry::MeanRepresentatives(const ClusterMembers& clusters, double importanceWeight, double scalarWeight)
+{
+	const unsigned numSamples = std::max(mMeanLineSamples, 2u);
+	const unsigned stride = (numSamples + 3) & ~3u;		// every component block starts 16 byte aligned
+	const int numClusters = (int)mClusterSize;
+
+	// the mean lines are written straight into their store, numSamples vertices each
+	ObjectData& meanLines = mClusteredObject.computed;
+	meanLines.positions.resize((size_t)numClusters * numSamples);
+	meanLines.importance.resize((size_t)numClusters * numSamples);
+	meanLines.scalarColor.resize((size_t)numClusters * numSamples);
+	meanLines.lineOffsets.resize(numClusters + 1);
+	for (int cluster = 0; cluster <= numClusters; cluster++)
+	{
+		meanLines.lineOffsets[cluster] = cluster * numSamples;
+	}
+
+#ifndef _DEBUG
+#pragma omp parallel
+#endif
+	{
+		std::vector<XMFLOAT4A> sum(5 * stride / 4);
+		std::vector<XMFLOAT4A> samples(5 * stride / 4);
+		std::vector<float> arcLength;
+#ifndef _DEBUG
+#pragma omp for schedule(dynamic, 16)
+#endif
+		for (int cluster = 0; cluster < numClusters; cluster++)
+		{
+			const unsigned first = clusters.offsets[cluster];
+			const unsigned last = clusters.offsets[cluster + 1];
+			const XMFLOAT3* reference = mObject.GetLine(clusters.lines[first]);
+			const unsigned referencePoints = mObject.GetNumVertices(clusters.lines[first]);
+
+			std::fill(sum.begin(), sum.end(), XMFLOAT4A(0.f, 0.f, 0.f, 0.f));
+			std::fill(samples.begin(), samples.end(), XMFLOAT4A(0.f, 0.f, 0.f, 0.f));
+			unsigned numLines = 0;
+			for (unsigned member = first; member < last; member++)
+			{
+				const unsigned id = clusters.lines[member];
+				const XMFLOAT3* line = mObject.GetLine(id);
+				const unsigned numPoints = mObject.GetNumVertices(id);
+				if (numPoints == 0 || referencePoints == 0) continue;
+
+				// flip the line if its end points match the reversed reference better
+				const float same = CalculatePointDistance(&line[0], &reference[0]) + CalculatePointDistance(&line[numPoints - 1], &reference[referencePoints - 1]);
+				const float flipped = CalculatePointDistance(&line[0], &reference[referencePoints - 1]) + CalculatePointDistance(&line[numPoints - 1], &reference[0]);
+				ResampleLine(line, mObject.GetImportance(id), mObject.GetScalarColor(id), numPoints, flipped < same, numSamples, stride, arcLength, (float*)samples.data());
+
+				for (size_t i = 0; i < sum.size(); i++)
+				{
+					XMStoreFloat4A(&sum[i], XMVectorAdd(XMLoadFloat4A(&sum[i]), XMLoadFloat4A(&samples[i])));
+				}
+				numLines++;
+			}
+
+			// divide the sum by the amount of lines in the cluster
+			const XMVECTOR factor = XMVectorReplicate(1.f / (float)std::max(numLines, 1u));
+			for (size_t i = 0; i < sum.size(); i++)
+			{
+				XMStoreFloat4A(&sum[i], XMVectorMultiply(XMLoadFloat4A(&sum[i]), factor));
+			}
+
+			const float* mean = (const float*)sum.data();
+			const size_t offset = meanLines.lineOffsets[cluster];
+			for (unsigned sample = 0; sample < numSamples; sample++)
+			{
+				meanLines.positions[offset + sample] = XMFLOAT3(mean[sample], mean[stride + sample], mean[2 * stride + sample]);
+			}
+			memcpy(&meanLines.importance[offset], mean + 3 * stride, numSamples * sizeof(float));
+			memcpy(&meanLines.scalarColor[offset], mean + 4 * stride, numSamples * sizeof(float));
+		}
+	}
+	LineGeometry::CalculateArcLength(meanLines);
+	LineGeometry::CalculateSimplificationError(meanLines);
+}
+
+// read distance matrix
+// read rows of all lines in a cluster
+// pick line with minimum distance values according to some metric
+// Importance / ScalarColor scaling is already included in the distance matrix
+// -----------------------
+// example distance matrix
+// 0 1 2 1
+// 1 0 3 2
+// 2 3 0 5
+// 1 2 5 0
+// cluster = 1, 2, 4
+// totalDistance 1 = 0 + 1 + 1
+// totalDistance 2 = 1 + 0 + 2
+// totalDistance 3 = 1 + 2 + 0
+void LineGeometry::LeastDistanceRepresentatives(const ClusterMembers& clusters)
+{
+	// total distance of every line to all other lines of its cluster. Every pair is read once from the row of its lower line,
+	// the members are sorted -> the reads walk forward through the condensed rows
+	std::vector<float> totalLineClusterDistance(mObject.GetNumLines(), 0.f);
+	const float* distances = mDistanceFile.IsOpen() ? mDistanceFile.GetValues() : (!mLineGraph.IsOpen() ? mDistanceMatrix.data() : NULL);
+	const uint64_t numLines = mDendrogram.numLines;
+	const int numClusters = (int)mClusterSize;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for (int clusterID = 0; clusterID < numClusters; clusterID++)
+	{
+		const unsigned first = clusters.offsets[clusterID];
+		const unsigned last = clusters.offsets[clusterID + 1];
+		for (unsigned memberA = first; memberA < last; memberA++)
+		{
+			const unsigned lineA = clusters.lines[memberA];
+			// condensed row of lineA starts with the pair (lineA, lineA + 1)
+			const uint64_t row = lineA * numLines - (uint64_t)lineA * (lineA + 1) / 2;
+			for (unsigned memberB = memberA + 1; memberB < last; memberB++)
+			{
+				const unsigned lineB = clusters.lines[memberB];
+				const float distance = distances != NULL ? distances[row + (lineB - lineA - 1)] : GetLineDistance(lineA, lineB);
+				totalLineClusterDistance[lineA] += distance;
+				totalLineClusterDistance[lineB] += distance;
+			}
+		}
+
+		// pick minimum line from the cluster (medoid)
+		unsigned representativeID = clusters.lines[first];
+		for (unsigned member = first + 1; member < last; member++)
+		{
+			if (totalLineClusterDistance[clusters.lines[member]] < totalLineClusterDistance[representativeID])
+			{
+				representativeID = clusters.lines[member];
+			}
+		}
+		SetRepresentative(clusterID, representativeID);
+	}
+}
+
+void LineGeometry::MostImportantRepresentatives(const ClusterMembers& clusters)
+{
+	// the importance of a line does not depend on the clustering -> calculated once per line set
+	if (mLineImportance.size() != mObject.GetNumLines())
+	{
+		mLineImportance.assign(mObject.GetNumLines(), 0.0);
+		const int numLines = (int)mObject.GetNumLines();
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for (int i = 0; i < numLines; i++)
+		{
+			// weight every point by its share of the line w_i = |p_i - p_{i-1}| + |p_i - p{i+1}|
+			const XMFLOAT3* line = mObject.GetLine(i);
+			const float* importance = mObject.GetImportance(i);
+			const unsigned numPoints = mObject.GetNumVertices(i);
+			if (numPoints < 2) continue;
+			std::vector<float> pointWeights(numPoints);
+			pointWeights[0] = CalculatePointDistance(&line[0], &line[1]);
+			for (unsigned point = 1; point < numPoints - 1; point++)
+			{
+				pointWeights[point] = CalculatePointDistance(&line[point], &line[point - 1]) + CalculatePointDistance(&line[point], &line[point + 1]);
+			}
+			pointWeights[numPoints - 1] = CalculatePointDistance(&line[numPoints - 1], &line[numPoints - 2]);
+
+			double totalWeight = 0.0;
+			for (unsigned j = 0; j < numPoints; j++)
+			{
+				totalWeight += pointWeights[j];
+			}
+			if (totalWeight <= 0.0) continue;
+
+			double totalImportance = 0.0;
+			for (unsigned j = 0; j < numPoints; j++)
+			{
+				totalImportance += (importance[j] * pointWeights[j]) / totalWeight;
+			}
+			mLineImportance[i] = totalImportance;
+		}
+	}
+
+	// for each cluster -> pick maximum importance line
+	const int numClusters = (int)mClusterSize;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+	for (int clusterID = 0; clusterID < numClusters; clusterID++)
+	{
+		unsigned representativeID = clusters.lines[clusters.offsets[clusterID]];
+		for (unsigned member = clusters.offsets[clusterID] + 1; member < clusters.offsets[clusterID + 1]; member++)
+		{
+			if (mLineImportance[clusters.lines[member]] > mLineImportance[representativeID])
+			{
+				representativeID = clusters.lines[member];
+			}
+		}
+		SetRepresentative(clusterID, representativeID);
+	}
+}
+
+unsigned LineGeometry::LoadDistanceMatrix(const std::string& filename)
+{
+	mDistanceFile.Close();
+	mDistanceMatrix.clear();
+
+	// prefer the binary version of a text matrix (converted by the Transformer)
+	const std::filesystem::path binary = std::filesystem::path(filename).replace_extension(".distb");
+	if (std::filesystem::exists(binary))
+	{
+		return mDistanceFile.Open(binary.string()) ? (unsigned)mDistanceFile.GetNumLines() : 0;
+	}
+
+	// alglib text matrix of older runs (*.dist) -> keep its upper triangle
+	std::ifstream in(filename);
+	if (!in.is_open())
+	{
+		return 0;
+	}
+	std::string s;
+	in >> s;
+	alglib::real_2d_array d(s.c_str());
+	const alglib::ae_int_t n = d.rows();
+	mDistanceMatrix.reserve((size_t)n * (n - 1) / 2);
+	for (alglib::ae_int_t i = 0; i < n; i++)
+	{
+		for (alglib::ae_int_t j = i + 1; j < n; j++)
+		{
+			mDistanceMatrix.push_back((float)d(i, j));
+		}
+	}
+	return (unsigned)n;
+}
+
+void LineGeometry::CalculateClusterReport(const std::string& distanceMatrixPath, int linkageType)
+{
+	ClearClusterCache();
+	mDendrogram = Dendrogram();
+	mLineGraph.Close();
+
+	// sparse line graph -> single linkage on its minimum spanning tree, no N x N matrix
+	if (std::filesystem::path(distanceMatrixPath).extension() == ".knn")
+	{
+		mDistanceFile.Close();
+		mDistanceMatrix.clear();
+		if (!mLineGraph.Open(distanceMatrixPath))
+		{
+			return;
+		}
+		const uint64_t numEntries = mLineGraph.GetNumLines() * mLineGraph.GetK();
+		const uint64_t hash = DendrogramFile::Hash(mLineGraph.GetNeighbors(0), numEntries * sizeof(uint32_t), DendrogramFile::Hash(mLineGraph.GetDistances(0), numEntries * sizeof(float)));
+		const std::string dendrogramPath = DendrogramFile::GetPath(distanceMatrixPath, LinkageMethod::SingleLinkage);
+		if (!DendrogramFile::Read(dendrogramPath, hash, LinkageMethod::SingleLinkage, mDendrogram))
+		{
+			mDendrogram = HierarchicalClustering::SingleLinkage(mLineGraph);
+			DendrogramFile::Write(dendrogramPath, hash, LinkageMethod::SingleLinkage, mDendrogram);
+		}
+		return;
+	}
+
+	const unsigned numLines = LineGeometry::LoadDistanceMatrix(distanceMatrixPath);
+	if (numLines == 0)
+	{
+		return;
+	}
+	const float* distances = mDistanceFile.IsOpen() ? mDistanceFile.GetValues() : mDistanceMatrix.data();
+	const size_t numValues = (size_t)numLines * (numLines - 1) / 2;
+	const LinkageMethod linkage = (LinkageMethod)linkageType;
+
+	// clustered before (also by an earlier session)?
+	const uint64_t hash = DendrogramFile::Hash(distances, numValues * sizeof(float));
+	const std::string dendrogramPath = DendrogramFile::GetPath(distanceMatrixPath, linkage);
+	if (DendrogramFile::Read(dendrogramPath, hash, linkage, mDendrogram) && mDendrogram.numLines == numLines)
+	{
+		return;
+	}
+
+	if (linkage == LinkageMethod::SingleLinkage)
+	{
+		// only reads the matrix
+		mDendrogram = HierarchicalClustering::SingleLinkage(distances, numLines);
+	}
+	else
+	{
+		// the other linkages overwrite the matrix with the cluster distances -> one working copy, the original stays for the representatives
+		std::vector<float> clusterDistances(distances, distances + numValues);
+		mDendrogram = HierarchicalClustering::NearestNeighborChain(clusterDistances.data(), numLines, linkage);
+	}
+	DendrogramFile::Write(dendrogramPath, hash, linkage, mDendrogram);
+}
+
+// distance from the matrix, or from the line graph: pairs that are not connected by it are at least as far apart as the k-th neighbor of both lines
+float LineGeometry::GetLineDistance(unsigned a, unsigned b)
+{
+	if (a == b) return 0.0f;
+	if (mDistanceFile.IsOpen())
+	{
+		return a < b ? mDistanceFile.GetDistance(a, b) : mDistanceFile.GetDistance(b, a);
+	}
+	if (!mLineGraph.IsOpen())
+	{
+		const uint64_t n = mDendrogram.numLines;
+		return a < b ? mDistanceMatrix[a * n - (uint64_t)a * (a + 1) / 2 + (b - a - 1)] : mDistanceMatrix[b * n - (uint64_t)b * (b + 1) / 2 + (a - b - 1)];
+	}
+
+	const unsigned k = mLineGraph.GetK();
+	float bound = 0.0f;
+	for (unsigned line : { a, b })
+	{
+		const unsigned other = line == a ? b : a;
+		const uint32_t* neighbors = mLineGraph.GetNeighbors(line);
+		const float* distances = mLineGraph.GetDistances(line);
+		for (unsigned n = 0; n < k; n++)
+		{
+			if (neighbors[n] == other) return distances[n];
+			if (neighbors[n] != LINEGRAPH_NO_NEIGHBOR) bound = std::max(bound, distances[n]);
+		}
+	}
+	return bound;
+}
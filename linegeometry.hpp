@@ -0,0 +1,189 @@
+#pragma once
+
+#include "math.hpp"
+#include <vector>
+#include <array>
+#include <map>
+#include <set>
+#include <list>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include "stdafx.h"
+#include "dataanalysis.h"
+#include "linegraph.hpp"
+#include "distancematrix.hpp"
+#include "clustering.hpp"
+#include "geometrycache.hpp"
+
+// All lines of a data set in one contiguous store, the vertices of line i are lineOffsets[i] .. lineOffsets[i + 1] - 1
+struct ObjectData {
+	std::vector<XMFLOAT3> positions;
+	std::vector<float> importance;		// one value per vertex
+	std::vector<float> scalarColor;		// one value per vertex
+	std::vector<unsigned> lineOffsets;	// numLines + 1 entries, the last one is the vertex count
+	std::vector<float> arcLength;		// one value per vertex: distance along its line from the first vertex, set by LineGeometry::CalculateArcLength
+	std::vector<float> simplificationError;	// one value per vertex: tolerance at which Douglas-Peucker removes it (LineLod)
+
+	unsigned GetNumLines() const { return lineOffsets.empty() ? 0 : (unsigned)lineOffsets.size() - 1; }
+	unsigned GetNumVertices() const { return (unsigned)positions.size(); }
+	unsigned GetNumVertices(unsigned line) const { return lineOffsets[line + 1] - lineOffsets[line]; }
+	const XMFLOAT3* GetLine(unsigned line) const { return positions.data() + lineOffsets[line]; }
+	const float* GetImportance(unsigned line) const { return importance.data() + lineOffsets[line]; }
+	const float* GetScalarColor(unsigned line) const { return scalarColor.data() + lineOffsets[line]; }
+	const float* GetArcLength(unsigned line) const { return arcLength.data() + lineOffsets[line]; }
+	float GetLineLength(unsigned line) const { return GetNumVertices(line) == 0 ? 0.f : arcLength[lineOffsets[line + 1] - 1]; }
+	const float* GetSimplificationError(unsigned line) const { return simplificationError.data() + lineOffsets[line]; }
+};
+
+// Lines shown after clustering: representatives of the line set referenced by their line id (no copy of their vertices),
+// or lines that were computed per cluster (mean lines) in their own store
+struct ClusteredObjectData {
+	std::vector<unsigned> lineIDs;		// line of the line set per cluster, empty -> the lines are in computed
+	ObjectData computed;
+};
+
+enum RepresentativeMethod {
+	START,
+	FirstLine,					// pick first line found while iterating
+	MeanLine,					// calculate the mean line from cluster -> weight with importance / scalarColor
+	LeastDistanceCurve,			// pick curve with least distance to all other curves
+	MostImportantCurve,			// pick curve with largest importance value
+	END
+};
+
+// lines of every cluster of a cut, grouped by cluster in ascending line order
+struct ClusterMembers {
+	std::vector<unsigned> offsets;		// clusterSize + 1, the lines of cluster c are lines[offsets[c] .. offsets[c + 1])
+	std::vector<unsigned> lines;
+};
+
+// representatives of one cut, cached so that moving the cluster count slider back and forth does not pick them again
+struct RepresentativeCacheEntry {
+	unsigned clusterSize;
+	RepresentativeMethod method;
+	ClusteredObjectData clusteredObject;
+};
+
+// CPU side of the lines: the line set, its clustering and the vertex data for the gpu buffers.
+// Free of d3d -> a dataset can be loaded on a worker thread (see DatasetLoader) and headless.
+class LineGeometry
+{
+public:
+
+	// only stores the settings, the data is read by ParseLineData / CalculateClusterReport
+	LineGeometry(const std::string& path, const std::string& distanceMatrixPath, const RepresentativeMethod repMethod, const int totalNumCPs, const unsigned clusterSize);
+
+	// copy all lines / the clustered lines into the vertex buffer data in one pass
+	void LoadLineSet(const ObjectData& object);
+	void LoadLineSet(const ClusteredObjectData& clusteredObject);
+	// obj files name the properties in the file name, line sets (*.lines) contain all properties -> importance / scalarColor pick two of them
+	void ParseLineData(const std::string& path, const std::string& importance = "", const std::string& scalarColor = "");
+	// line set of other (and the names it was parsed with) -> it can be clustered again without parsing the file
+	void CopyLineSet(const LineGeometry& other);
+	void CalculateHierarchicalClustering();
+	void CalculateClusterReport(const std::string& distanceMatrixPath, int linkageType = 0);
+	// clusterMapping: cluster id of every line, the methods run in parallel over the clusters
+	void PickClusterRepresentatives(RepresentativeMethod method, const std::vector<unsigned>& clusterMapping, double importanceWeight, double scalarWeight);
+	void FirstRepresentatives(const ClusterMembers& clusters);
+	void MeanRepresentatives(const ClusterMembers& clusters, double importanceWeight, double scalarWeight);
+	void LeastDistanceRepresentatives(const ClusterMembers& clusters);
+	void MostImportantRepresentatives(const ClusterMembers& clusters);
+	void ReleaseObject(ObjectData& object);
+	void ReleaseObject(ClusteredObjectData& clusteredObject);
+	// vertex data of a configuration that was prepared before -> shown without the line set, until the next LoadLineSet
+	bool OpenGeometryCache(const std::string& directory, const GeometryCacheKey& key);
+	bool WriteGeometryCache(const std::string& directory, const GeometryCacheKey& key) const;
+	// arrays of the gpu buffers: the staging arrays, or the mapped cache file
+	VertexData GetVertexData() const;
+
+	int GetTotalNumberOfControlPoints() const { return _TotalNumberOfControlPoints; }
+	// all vertices in the buffers: the lines and their levels of detail
+	int GetTotalNumberOfVertices() const { return mGeometryCache.IsOpen() ? (int)mGeometryCache.GetVertexData().numVertices : (int)_Positions.size(); }
+	// vertices of the lines themselves (level 0), they come first
+	int GetNumberOfLineVertices() const { return mGeometryCache.IsOpen() ? (int)mGeometryCache.GetVertexData().numLineVertices : (_VertexOffsets.empty() ? 0 : (int)_VertexOffsets.back()); }
+	std::string& GetCurrentDataSet() { return mCurrentDataset; }
+	const std::string& GetCurrentDataSet() const { return mCurrentDataset; }
+	void SetCurrentDataSet(std::string value) { mCurrentDataset = value; }
+	// properties requested from ParseLineData, empty -> the default of the file
+	const std::string& GetCurrentImportance() const { return mCurrentImportance; }
+	const std::string& GetCurrentScalarColor() const { return mCurrentScalarColor; }
+	unsigned GetClusterSize() const { return mClusterSize; }
+	void SetClusterSize(unsigned int value) { mClusterSize = value; }
+
+	ObjectData& GetObjectData() { return mObject; }
+	ClusteredObjectData& GetClusteredObjectData() { return mClusteredObject; }
+	unsigned GetTotalLineAmount() { return mObject.GetNumLines(); }
+
+	// points of every mean line (MeanLine representatives) -> bounds the vertices of the clustered line set
+	unsigned GetMeanLineSamples() const { return mMeanLineSamples; }
+	void SetMeanLineSamples(unsigned value);
+
+	RepresentativeMethod GetRepresentativeMethod() { return mRepresentativeMethod; }
+	// milliseconds of the last pick with the method, < 0 if it did not run yet
+	float GetRepresentativeTime(RepresentativeMethod method) const { return mRepresentativeTimes[method]; }
+	void SetRepresentativeMethod(RepresentativeMethod value) { mRepresentativeMethod = value; }
+	std::string RepresentativeToString(RepresentativeMethod method) 
+	{
+		switch (method) 
+		{
+		case RepresentativeMethod::FirstLine:			return	"First Line";
+		case RepresentativeMethod::MeanLine:			return	"Mean Line";
+		case RepresentativeMethod::LeastDistanceCurve:	return	"Least Distance Curve";
+		case RepresentativeMethod::MostImportantCurve:	return	"MostImportantCurve";
+		}
+	}
+
+
+protected:
+	int _TotalNumberOfControlPoints;
+	unsigned int mClusterSize;
+
+	std::vector<Vec3f> _Positions;
+	std::vector<int> _ID;
+	std::vector<float> _Importance;
+	std::vector<float> _AlphaWeights;	// Blending weight parameterization
+
+	std::vector<float> _LineLengths;
+	std::vector<int> _NumberOfControlPointsOfLine;
+	std::vector<unsigned int> _ControlPointLineIndices;
+	std::vector<unsigned int> _VertexOffsets;		// first vertex / control point of every loaded line, numLines + 1 entries
+	std::vector<unsigned int> _ControlPointOffsets;
+	std::vector<LineLevel> _LineLevels;			// LINE_LOD_LEVELS per loaded line
+	std::vector<XMFLOAT4> _LineBounds;			// bounding sphere per loaded line
+
+	std::vector<float> _Color;
+	std::string mCurrentDataset;				// this should be in scene.cpp
+	std::string mCurrentDistanceMatrixPath;		// used for clustering
+	std::string mCurrentImportance;
+	std::string mCurrentScalarColor;
+
+	ObjectData mObject;							// save the obj file
+	ClusteredObjectData mClusteredObject;		// lines of the current clustering
+	GeometryCacheFile mGeometryCache;			// open -> its vertex data replaces the staging arrays
+
+private:
+	void ParseLineSet(const std::string& path, const std::string& importance, const std::string& scalarColor);
+	void CalculateArcLength(ObjectData& object);
+	void CalculateSimplificationError(ObjectData& object);
+	float CalculatePointDistance(const XMFLOAT3* a, const XMFLOAT3* b);
+	void LoadLines(const ObjectData& object, const unsigned* lineIDs, unsigned numLines);
+	void LoadLevels(const ObjectData& object, const unsigned* lineIDs, unsigned numLines);
+	void DistributePolylines(const unsigned int lines_amount, const float accumLineLength, const unsigned totalNumberOfControlPoints, const std::vector<float>& lineLengths, std::vector<int>& numberOfControlPointsOfLine);
+	unsigned LoadDistanceMatrix(const std::string& filename);	// number of lines, 0 if it could not be read
+	float GetLineDistance(unsigned a, unsigned b);
+	void ClearClusterCache();
+	void SetRepresentative(unsigned clusterID, unsigned lineID);
+
+	DistanceMatrixFile mDistanceFile;			// binary distance matrix (*.distb), stays mapped for the representatives
+	std::vector<float> mDistanceMatrix;			// condensed text distance matrix (*.dist) of older runs
+	LineGraphFile mLineGraph;					// k nearest lines (*.knn) instead of the distance matrix
+	Dendrogram mDendrogram;						// save merges to calculate clusters
+	DendrogramCut mDendrogramCut;				// union find state of the last cut
+	std::list<RepresentativeCacheEntry> mRepresentativeCache;	// most recently used first
+	std::vector<double> mLineImportance;		// length weighted importance of every line (MostImportantCurve)
+	std::array<float, RepresentativeMethod::END> mRepresentativeTimes;
+
+	RepresentativeMethod mRepresentativeMethod;
+	unsigned mMeanLineSamples;
+};
@@ -0,0 +1,66 @@
+#include "linegraph.hpp"
+#include <cstring>
+#include <utility>
+
+LineGraphFile::LineGraphFile() :
+	mHeader(NULL),
+	mNeighbors(NULL),
+	mDistances(NULL)
+{
+}
+
+LineGraphFile::~LineGraphFile()
+{
+	Close();
+}
+
+LineGraphFile::LineGraphFile(LineGraphFile&& other) :
+	mFile(std::move(other.mFile)),
+	mHeader(other.mHeader),
+	mNeighbors(other.mNeighbors),
+	mDistances(other.mDistances)
+{
+	other.mHeader = NULL;
+	other.mNeighbors = NULL;
+	other.mDistances = NULL;
+}
+
+LineGraphFile& LineGraphFile::operator=(LineGraphFile&& other)
+{
+	if (this != &other)
+	{
+		mFile = std::move(other.mFile);
+		mHeader = other.mHeader;
+		mNeighbors = other.mNeighbors;
+		mDistances = other.mDistances;
+		other.mHeader = NULL;
+		other.mNeighbors = NULL;
+		other.mDistances = NULL;
+	}
+	return *this;
+}
+
+bool LineGraphFile::Open(const std::string& path)
+{
+	Close();
+	if (!mFile.Open(path) || mFile.GetSize() < sizeof(LineGraphHeader)) { Close(); return false; }
+
+	// check the header and that both blocks lie inside of the file
+	const LineGraphHeader* header = (const LineGraphHeader*)mFile.GetData();
+	if (memcmp(header->magic, LINEGRAPH_MAGIC, sizeof(LINEGRAPH_MAGIC)) != 0 || header->version != LINEGRAPH_VERSION || header->k == 0) { Close(); return false; }
+	const uint64_t numEntries = header->numLines * header->k;
+	if (header->neighborsOffset + numEntries * sizeof(uint32_t) > mFile.GetSize() || header->distancesOffset + numEntries * sizeof(float) > mFile.GetSize()) { Close(); return false; }
+
+	mHeader = header;
+	mNeighbors = (const uint32_t*)(mFile.GetData() + header->neighborsOffset);
+	mDistances = (const float*)(mFile.GetData() + header->distancesOffset);
+	return true;
+}
+
+void LineGraphFile::Close()
+{
+	mFile.Close();
+	mHeader = NULL;
+	mNeighbors = NULL;
+	mDistances = NULL;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "mappedfile.hpp"
+#include "linegraphformat.hpp"
+
+// Read-only memory mapping of a line graph.
+class LineGraphFile
+{
+public:
+	LineGraphFile();
+	~LineGraphFile();
+	LineGraphFile(const LineGraphFile&) = delete;
+	LineGraphFile& operator=(const LineGraphFile&) = delete;
+	LineGraphFile(LineGraphFile&& other);
+	LineGraphFile& operator=(LineGraphFile&& other);
+
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const { return mHeader != NULL; }
+
+	uint64_t GetNumLines() const { return mHeader->numLines; }
+	uint32_t GetK() const { return mHeader->k; }
+	const uint32_t* GetNeighbors(uint64_t line) const { return mNeighbors + line * mHeader->k; }
+	const float* GetDistances(uint64_t line) const { return mDistances + line * mHeader->k; }
+
+private:
+	MappedFile mFile;
+	const LineGraphHeader* mHeader;
+	const uint32_t* mNeighbors;
+	const float* mDistances;
+};
@@ -0,0 +1,136 @@
+#include "linelod.hpp"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+static const float LINE_LOD_FINEST_TOLERANCE = 1e-4f;	// tolerance of level 1 relative to the size of the line set, doubled per level
+
+// distance of p to the segment a b
+static float SegmentDistance(const XMFLOAT3& p, const XMFLOAT3& a, const XMFLOAT3& b)
+{
+	const float abx = b.x - a.x, aby = b.y - a.y, abz = b.z - a.z;
+	const float apx = p.x - a.x, apy = p.y - a.y, apz = p.z - a.z;
+	const float lengthSquared = abx * abx + aby * aby + abz * abz;
+	const float t = lengthSquared > 0.f ? std::min(std::max((apx * abx + apy * aby + apz * abz) / lengthSquared, 0.f), 1.f) : 0.f;
+	const float dx = apx - t * abx, dy = apy - t * aby, dz = apz - t * abz;
+	return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+void LineLod::CalculateSimplificationError(const XMFLOAT3* line, unsigned numPoints, float* error)
+{
+	if (numPoints == 0) return;
+	std::fill(error, error + numPoints, 0.f);
+	error[0] = std::numeric_limits<float>::infinity();
+	error[numPoints - 1] = std::numeric_limits<float>::infinity();
+
+	// the splits of Douglas-Peucker without a tolerance: every segment is split at its farthest vertex
+	struct Segment { unsigned first; unsigned last; float error; };
+	std::vector<Segment> segments;
+	segments.push_back({ 0, numPoints - 1, std::numeric_limits<float>::infinity() });
+	while (!segments.empty())
+	{
+		const Segment segment = segments.back();
+		segments.pop_back();
+		if (segment.last <= segment.first + 1) continue;
+
+		unsigned farthest = segment.first + 1;
+		float distance = -1.f;
+		for (unsigned i = segment.first + 1; i < segment.last; i++)
+		{
+			const float d = SegmentDistance(line[i], line[segment.first], line[segment.last]);
+			if (d > distance)
+			{
+				distance = d;
+				farthest = i;
+			}
+		}
+
+		// a vertex is removed no later than the vertex that split its segment
+		const float splitError = std::min(distance, segment.error);
+		error[farthest] = splitError;
+		segments.push_back({ segment.first, farthest, splitError });
+		segments.push_back({ farthest, segment.last, splitError });
+	}
+}
+
+float LineLod::GetLevelTolerance(unsigned level, float extent)
+{
+	return level == 0 ? 0.f : extent * LINE_LOD_FINEST_TOLERANCE * (float)(1u << (level - 1));
+}
+
+void LineLod::SelectLevels(const LineLevel* levels, const XMFLOAT4* bounds, unsigned numLines, const LodView& view, LodSelection& selection)
+{
+	selection.levels.resize(numLines);
+	selection.offsets.resize(numLines + 1);
+	selection.offsets[0] = 0;
+
+	// view space: x * p11 = +-z * side and y * p22 = +-z * side are the side planes of the frustum, widened by the strips
+	const XMMATRIX viewMatrix = XMLoadFloat4x4(&view.view);
+	const float p11 = view.projection._11;
+	const float p22 = view.projection._22;
+	const float side = 1.f + view.margin;
+	const float nearPlane = -view.projection._43 / view.projection._33;
+	const float farPlane = view.projection._43 / (1.f - view.projection._33);
+	const float normalizeX = 1.f / std::sqrt(p11 * p11 + side * side);
+	const float normalizeY = 1.f / std::sqrt(p22 * p22 + side * side);
+	// a distance at depth z covers distance * pixelsPerUnit / z pixels
+	const float pixelsPerUnit = p22 * 0.5f * view.viewportHeight;
+
+	const int numSelected = (int)numLines;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(static)
+#endif
+	for (int i = 0; i < numSelected; i++)
+	{
+		XMFLOAT3 center;
+		XMStoreFloat3(&center, XMVector3Transform(XMLoadFloat4(&bounds[i]), viewMatrix));
+		const float radius = bounds[i].w;
+		const bool outside = center.z + radius < nearPlane || center.z - radius > farPlane
+			|| (center.x * p11 - center.z * side) * normalizeX > radius || (-center.x * p11 - center.z * side) * normalizeX > radius
+			|| (center.y * p22 - center.z * side) * normalizeY > radius || (-center.y * p22 - center.z * side) * normalizeY > radius;
+
+		unsigned numIndices = 0;
+		unsigned char level = LINE_LOD_CULLED;
+		if (!outside)
+		{
+			// coarsest level below the pixel error at the closest point of the line, lines reaching to the camera stay complete
+			const LineLevel* line = levels + (size_t)i * LINE_LOD_LEVELS;
+			level = 0;
+			const float depth = center.z - radius;
+			if (depth > nearPlane)
+			{
+				const float maxError = view.pixelError * depth / pixelsPerUnit;
+				while (level + 1u < LINE_LOD_LEVELS && line[level + 1].error <= maxError) level++;
+			}
+			// like Draw(numVertices - 2): every vertex except for the last two starts a segment, then the strip is cut
+			const unsigned numPoints = line[level].count;
+			numIndices = numPoints >= LINE_LOD_MIN_VERTICES ? numPoints - 1 : 0;
+		}
+		selection.levels[i] = level;
+		selection.offsets[i + 1] = numIndices;
+	}
+
+	selection.numVertices = 0;
+	for (unsigned i = 0; i < numLines; i++)
+	{
+		if (selection.offsets[i + 1] > 0) selection.numVertices += selection.offsets[i + 1] + 1;
+		selection.offsets[i + 1] += selection.offsets[i];
+	}
+	selection.indices.resize(selection.offsets[numLines]);
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (int i = 0; i < numSelected; i++)
+	{
+		const unsigned numIndices = selection.offsets[i + 1] - selection.offsets[i];
+		if (numIndices == 0) continue;
+		const unsigned first = levels[(size_t)i * LINE_LOD_LEVELS + selection.levels[i]].first;
+		unsigned* indices = selection.indices.data() + selection.offsets[i];
+		for (unsigned k = 0; k + 1 < numIndices; k++)
+		{
+			indices[k] = first + k;
+		}
+		indices[numIndices - 1] = LINE_LOD_STRIP_CUT;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include "math.hpp"
+
+static const unsigned LINE_LOD_LEVELS = 8;				// level 0 is the line itself
+static const unsigned LINE_LOD_MIN_VERTICES = 4;		// the geometry shader draws the segments between the second and the second to last vertex
+static const unsigned char LINE_LOD_CULLED = 0xFF;
+static const unsigned LINE_LOD_STRIP_CUT = 0xFFFFFFFF;	// restarts the line strip (32 bit indices)
+
+// one level of detail of a loaded line: vertices first .. first + count - 1 of the vertex buffers, consecutive like the line itself
+struct LineLevel {
+	unsigned first;
+	unsigned count;
+	float error;					// maximum distance of a removed vertex to the simplified line
+};
+
+// camera of a frame for the level selection
+struct LodView {
+	XMFLOAT4X4 view;
+	XMFLOAT4X4 projection;			// perspective (XMMatrixPerspectiveFovLH)
+	float viewportHeight;			// pixels
+	float pixelError;				// allowed error on screen in pixels
+	float margin;					// strip width in normalized device coordinates, widens the sides of the frustum
+};
+
+// indices of one frame, reused between frames
+struct LodSelection {
+	std::vector<unsigned char> levels;	// chosen level per line, LINE_LOD_CULLED for lines outside of the view
+	std::vector<unsigned> offsets;		// first index of every line, numLines + 1 entries
+	std::vector<unsigned> indices;		// LINESTRIP indices, the lines are separated by LINE_LOD_STRIP_CUT
+	unsigned numVertices;				// line vertices drawn with the indices
+};
+
+// Multiresolution lines for the rendering: Douglas-Peucker levels per line, picked per frame by their error on screen.
+class LineLod
+{
+public:
+	// Distance at which Douglas-Peucker removes every vertex: the vertices with error >= tolerance are the simplified line.
+	// The errors of a split are limited by the error of the split above it, so the levels are nested. End points are never removed.
+	static void CalculateSimplificationError(const XMFLOAT3* line, unsigned numPoints, float* error);
+	// tolerance of the level > 0, relative to the size of the line set
+	static float GetLevelTolerance(unsigned level, float extent);
+
+	// per line the coarsest level whose error stays below view.pixelError pixels, lines outside of the view frustum are skipped.
+	// The indices start every line at its level's first vertex like Draw(numVertices - 2) does for all lines.
+	// levels: LINE_LOD_LEVELS per line, bounds: center xyz and radius w per line
+	static void SelectLevels(const LineLevel* levels, const XMFLOAT4* bounds, unsigned numLines, const LodView& view, LodSelection& selection);
+};
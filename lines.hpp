@@ -1,98 +1,47 @@
 #pragma once
 
-#include "math.hpp"
 #include <d3d11.h>
-#include <vector>
-#include <map>
-#include <set>
-#include <fstream>
-#include <sstream>
 #include "buffer.hpp"
-#include "stdafx.h"
-#include "dataanalysis.h"
+#include "linegeometry.hpp"
 
-typedef std::vector<XMFLOAT3> Line;
-
-// make this different -> vector<ObjectData> should be used instead
-struct ObjectData {
-	std::vector<Line> lines;
-	std::vector<std::vector<float>> importance;
-	std::vector<std::vector<float>> scalarColor;
-	unsigned int vertexCount;
-};
-
-enum RepresentativeMethod {
-	START,
-	FirstLine,					// pick first line found while iterating
-	MeanLine,					// calculate the mean line from cluster -> weight with importance / scalarColor
-	LeastDistanceCurve,			// pick curve with least distance to all other curves
-	MostImportantCurve,			// pick curve with largest importance value
-	END
-};
-
-class Lines
+// GPU side of the lines: the vertex buffers of the geometry and the alpha of the control points
+class Lines : public LineGeometry
 {
 public:
 
 	Lines(const std::string& path, const std::string& distanceMatrixPath, const RepresentativeMethod repMethod, const int totalNumCPs, const unsigned clusterSize, ID3D11Device* Device);
+	// takes over a geometry that was loaded in the background
+	Lines(LineGeometry&& geometry, ID3D11Device* Device);
 	~Lines();
 
+	// takes over the line set and clustering of the geometry whose cached vertex data is already in the gpu buffers
+	void Restore(LineGeometry&& geometry);
+
+	// buffers with room for every cluster count of the line set, filled with the current vertex data
 	bool Create(ID3D11Device* Device);
+	// after LoadLineSet: uploads the vertex data into the existing buffers, they are only created again if it does not fit
+	bool UpdateBuffers(ID3D11Device* Device, ID3D11DeviceContext* ImmediateContext);
 	void Release();
 	void DrawHQ(ID3D11DeviceContext* ImmediateContext);
 	void DrawLowRes(ID3D11DeviceContext* ImmediateContext);
-	void LoadLineSet(const ObjectData& object);
-	void ParseLineData(const std::string& path);
-	void CalculateHierarchicalClustering();
-	void CalculateClusterReport(const std::string& distanceMatrixPath, int linkageType = 0);
-	void PickClusterRepresentatives(RepresentativeMethod method, alglib::integer_1d_array& clusterMapping, double importanceWeight, double scalarWeight);
-	void FirstRepresentatives(alglib::integer_1d_array& clusterMapping);
-	void MeanRepresentatives(alglib::integer_1d_array& clusterMapping, double importanceWeight, double scalarWeight);
-	void LeastDistanceRepresentatives(alglib::integer_1d_array& clusterMapping);
-	void MostImportantRepresentatives(alglib::integer_1d_array& clusterMapping);
-	void ReleaseObject(ObjectData& object);
+
+	// picks the level of detail of every line for the camera and uploads the indices, only if the camera or the settings changed
+	void UpdateLevelOfDetail(ID3D11DeviceContext* ImmediateContext, const XMFLOAT4X4& view, const XMFLOAT4X4& projection, float viewportHeight, float margin);
+	bool GetLevelOfDetail() const { return mLevelOfDetail; }
+	void SetLevelOfDetail(bool value) { mLevelOfDetail = value; mLodDirty = true; }
+	float GetLodPixelError() const { return mLodView.pixelError; }
+	void SetLodPixelError(float value) { mLodView.pixelError = value; mLodDirty = true; }
+	// line vertices drawn in the last frame
+	unsigned GetLodVertices() const { return mLevelOfDetail && _IbLevelOfDetail ? mLodSelection.numVertices : (unsigned)GetNumberOfLineVertices(); }
 
 	vislab::BufferD3D11& GetCurrentAlpha() { return mVbCurrentAlpha; }
 	std::array<vislab::BufferD3D11, 2>& GetAlpha() { return mAlphaBuffer; }
 	ID3D11ShaderResourceView* GetSrvAlphaWeights() { return _SrvAlphaWeights; }
 	ID3D11ShaderResourceView* GetSrvLineID() { return _SrvLineID; }
 
-	int GetTotalNumberOfControlPoints() const { return _TotalNumberOfControlPoints; }
-	int GetTotalNumberOfVertices() const { return (int)_Positions.size(); }
-	std::string& GetCurrentDataSet() { return mCurrentDataset; }
-	void SetCurrentDataSet(std::string value) { mCurrentDataset = value; }
-	unsigned GetClusterSize() const { return mClusterSize; }
-	void SetClusterSize(unsigned int value) { mClusterSize = value; }
-
-	ObjectData& GetObjectData() { return mObject; }
-	ObjectData& GetClusteredObjectData() { return mClusteredObject; }
-	unsigned GetTotalLineAmount() { return mObject.lines.size(); }
-
-	RepresentativeMethod GetRepresentativeMethod() { return mRepresentativeMethod; }
-	void SetRepresentativeMethod(RepresentativeMethod value) { mRepresentativeMethod = value; }
-	std::string RepresentativeToString(RepresentativeMethod method) 
-	{
-		switch (method) 
-		{
-		case RepresentativeMethod::FirstLine:			return	"First Line";
-		case RepresentativeMethod::MeanLine:			return	"Mean Line";
-		case RepresentativeMethod::LeastDistanceCurve:	return	"Least Distance Curve";
-		case RepresentativeMethod::MostImportantCurve:	return	"MostImportantCurve";
-		}
-	}
-
-
 private:
-	float CalculateLineLength(const Line& line);
-	float CalculatePointDistance(const XMFLOAT3* a, const XMFLOAT3* b);
-	void StorePositionsIds(const std::vector<Line>& lines, const unsigned int totalNumPoints);
-	void StoreImportanceScalarColor(const ObjectData& clusteredObject);
-	std::vector<int> DistributePolylines(const unsigned int lines_amount, const float accumLineLength, const unsigned totalNumberOfControlPoints, const std::vector<float>& lineLengths);
-	std::vector<float> ComputeAlphaWeights(const std::vector<Line> lines, const unsigned int totalNumPoints, const std::vector<float>& lineLengths, std::vector<int>& numberOfControlPointsOfLine);
-	alglib::real_2d_array LoadDistanceMatrix(const std::string& filename);
-
-	int _TotalNumberOfControlPoints;
-	unsigned int mClusterSize;
+	bool Upload(ID3D11DeviceContext* ImmediateContext);
+	void ReleaseBuffers();
 
 	ID3D11Buffer* _VbPosition;
 	ID3D11Buffer* _VbID;
@@ -107,25 +56,13 @@ private:
 	ID3D11Buffer* _LineID;							// stores for every control point the lineID (used for smoothing)
 	ID3D11ShaderResourceView* _SrvLineID;
 
-	std::vector<Vec3f> _Positions;
-	std::vector<int> _ID;
-	std::vector<float> _Importance;
-	std::vector<float> _AlphaWeights;	// Blending weight parameterization
-
-	std::vector<float> _LineLengths;
-	std::vector<int> _NumberOfControlPointsOfLine;
-	std::vector<unsigned int> _ControlPointLineIndices;
-
-
 	ID3D11Buffer* _VbColor;			// color scalar value
-	std::vector<float> _Color;
-	std::string mCurrentDataset;				// this should be in scene.cpp
-	std::string mCurrentDistanceMatrixPath;		// used for clustering
 
-	ObjectData mObject;							// save the obj file
-	alglib::real_2d_array mDistanceMatrix;		// save distance matrix
-	ObjectData mClusteredObject;				// save the obj file
-	alglib::ahcreport mClusterReport;			// save report to calculate clusters
-
-	RepresentativeMethod mRepresentativeMethod;
-};
\ No newline at end of file
+	ID3D11Buffer* _IbLevelOfDetail;	// line strip indices of the selected levels (dynamic)
+	unsigned mVertexCapacity;		// vertices that fit into the vertex buffers
+	unsigned mIndexCapacity;		// indices that fit into _IbLevelOfDetail
+	LodSelection mLodSelection;
+	LodView mLodView;				// camera of the current indices
+	bool mLevelOfDetail;
+	bool mLodDirty;
+};
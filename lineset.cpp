@@ -0,0 +1,68 @@
+#include "lineset.hpp"
+#include <cstring>
+
+LineSetFile::LineSetFile() :
+	mHeader(NULL),
+	mProperties(NULL)
+{
+}
+
+LineSetFile::~LineSetFile()
+{
+	Close();
+}
+
+bool LineSetFile::Open(const std::string& path)
+{
+	Close();
+	if (!mFile.Open(path) || mFile.GetSize() < sizeof(LineSetHeader)) { Close(); return false; }
+	const char* data = mFile.GetData();
+	const uint64_t size = mFile.GetSize();
+
+	// check the header and that every block lies inside of the file
+	const LineSetHeader* header = (const LineSetHeader*)data;
+	if (memcmp(header->magic, LINESET_MAGIC, sizeof(LINESET_MAGIC)) != 0 || header->version != LINESET_VERSION) { Close(); return false; }
+	if (header->numLines >= size / sizeof(uint64_t) || header->numVertices > size / (3 * sizeof(float)) || header->lineOffsetsOffset > size || header->positionsOffset > size) { Close(); return false; }
+	const uint64_t propertiesEnd = sizeof(LineSetHeader) + header->numProperties * sizeof(LineSetProperty);
+	const uint64_t offsetsEnd = header->lineOffsetsOffset + (header->numLines + 1) * sizeof(uint64_t);
+	const uint64_t positionsEnd = header->positionsOffset + header->numVertices * 3 * sizeof(float);
+	if (propertiesEnd > size || offsetsEnd > size || positionsEnd > size) { Close(); return false; }
+	const LineSetProperty* properties = (const LineSetProperty*)(data + sizeof(LineSetHeader));
+	for (uint32_t p = 0; p < header->numProperties; p++)
+	{
+		if (properties[p].valuesOffset > size || properties[p].valuesOffset + header->numVertices * sizeof(float) > size) { Close(); return false; }
+		// FindProperty compares the names as c strings
+		if (memchr(properties[p].name, '\0', sizeof(properties[p].name)) == NULL) { Close(); return false; }
+	}
+
+	// the lines have to cover the vertices in order
+	const uint64_t* lineOffsets = (const uint64_t*)(data + header->lineOffsetsOffset);
+	for (uint64_t line = 0; line < header->numLines; line++)
+	{
+		if (lineOffsets[line] > lineOffsets[line + 1]) { Close(); return false; }
+	}
+	if (lineOffsets[header->numLines] != header->numVertices) { Close(); return false; }
+
+	mHeader = header;
+	mProperties = properties;
+	return true;
+}
+
+void LineSetFile::Close()
+{
+	mFile.Close();
+	mHeader = NULL;
+	mProperties = NULL;
+}
+
+const float* LineSetFile::FindProperty(const std::string& name) const
+{
+	for (uint32_t p = 0; p < mHeader->numProperties; p++)
+	{
+		if (name == mProperties[p].name)
+		{
+			return (const float*)(mFile.GetData() + mProperties[p].valuesOffset);
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "mappedfile.hpp"
+#include "linesetformat.hpp"
+
+// Read-only memory mapping of a line set.
+class LineSetFile
+{
+public:
+	LineSetFile();
+	~LineSetFile();
+	LineSetFile(const LineSetFile&) = delete;
+	LineSetFile& operator=(const LineSetFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	uint64_t GetNumLines() const { return mHeader->numLines; }
+	uint64_t GetNumVertices() const { return mHeader->numVertices; }
+	const uint64_t* GetLineOffsets() const { return (const uint64_t*)(mFile.GetData() + mHeader->lineOffsetsOffset); }
+	const float* GetPositions() const { return (const float*)(mFile.GetData() + mHeader->positionsOffset); }
+
+	uint32_t GetNumProperties() const { return mHeader->numProperties; }
+	const LineSetProperty& GetProperty(uint32_t index) const { return mProperties[index]; }
+	// values of a property, NULL if the line set does not contain it
+	const float* FindProperty(const std::string& name) const;
+
+private:
+	MappedFile mFile;
+	const LineSetHeader* mHeader;
+	const LineSetProperty* mProperties;
+};
@@ -7,6 +7,7 @@
 #include "imgui_helper.hpp"
 #include "colormap.hpp"
 #include "scene.hpp"
+#include "datasetloader.hpp"
 #include <Windows.h>
 #include <windowsx.h>
 #include "gpuprofiler.hpp"
@@ -23,6 +24,7 @@ Renderer* g_Renderer = NULL;
 ImguiHelper* g_Imgui = NULL;
 Colormap* g_Colormap = NULL;
 Scene* g_Scene = NULL;
+DatasetLoader* g_Loader = NULL;
 static UINT g_ResizeWidth = 0, g_ResizeHeight = 0;
 
 
@@ -100,6 +102,27 @@ HRESULT InitWindow(HINSTANCE hInstance, int nCmdShow, const std::string& WindowT
 	return S_OK;
 }
 
+// a dataset that finished loading in the background gets its gpu buffers before the current lines are released
+// -> the old lines are drawn until the frame in which the new ones are complete
+void SwapLoadedGeometry(ID3D11Device* device)
+{
+	bool completion = false;
+	std::unique_ptr<LineGeometry> geometry = g_Loader->TakeGeometry(completion);
+	if (!geometry)
+		return;
+
+	// line set of the cached vertex data that is already drawn -> the gpu buffers stay
+	if (completion)
+	{
+		g_Lines->Restore(std::move(*geometry));
+		return;
+	}
+
+	Lines* lines = new Lines(std::move(*geometry), device);
+	delete g_Lines;
+	g_Lines = lines;
+}
+
 int probe = 0;
 // ---------------------------------------
 // Update and Render
@@ -122,7 +145,7 @@ void Render(double dt)
 	g_Renderer->Draw(immediateContext, g_D3D, g_Lines, g_Camera, g_Colormap, dt);
 
 	#ifdef ENABLE_IMGUI
-		g_Imgui->Draw(immediateContext, rtvBackbuffer, g_Renderer, g_D3D, g_Colormap, g_Camera, g_Lines, g_Scene);
+		g_Imgui->Draw(immediateContext, rtvBackbuffer, g_Renderer, g_D3D, g_Colormap, g_Camera, g_Lines, g_Scene, g_Loader);
 	#endif
 
 	g_gpuProfiler.WaitForDataAndUpdate(immediateContext);
@@ -388,7 +411,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	ID3D11RenderTargetView* rtvBackbuffer = g_D3D->GetRtvBackbuffer();
 
 	g_Camera = new Camera(eye, lookAt, (float)resolution.x / (float)resolution.y, hWnd);
-	g_Lines = new Lines(path, distanceMatrixPath, representativeMethod, totalNumCPs, clusterCount, device);
+	g_Loader = new DatasetLoader("cache", (uint64_t)4 << 30);	// at most 4 GiB of prepared vertex data
+	{
+		// the first frame waits for the dataset, or only for its vertex data if it was prepared in an earlier session
+		DatasetLoader::Request request = { path, "", "", distanceMatrixPath, 0, representativeMethod, totalNumCPs, 0, (unsigned)clusterCount };
+		g_Loader->Start(request);
+		bool completion = false;
+		std::unique_ptr<LineGeometry> geometry = g_Loader->WaitForGeometry(completion);
+		g_Lines = geometry ? new Lines(std::move(*geometry), device) : new Lines(path, distanceMatrixPath, representativeMethod, totalNumCPs, clusterCount, device);
+	}
 	g_Renderer = new Renderer(q, r, lambda, stripWidth, smoothingIterations, histogramMode, segments, device, & g_D3D->GetBackBufferSurfaceDesc());
 	g_Imgui = new ImguiHelper(hWnd);
 	g_Colormap = new Colormap(colormap_folder_path);
@@ -428,6 +459,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		double elapsedS = (double)timeElapsed / (double)frequency.QuadPart;
 		timerLast = timerCurrent;
 
+		// swap in a dataset that was loaded in the background -> between two frames
+		SwapLoadedGeometry(device);
+
 		// update the camera
 		g_Camera->Update((float) elapsedS);
 		// render the scene
@@ -470,6 +504,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	}
 	
 	// Clean up before closing.
+	delete g_Loader;
 	delete g_Camera;
 	delete g_Lines;
 	delete g_Renderer;
@@ -0,0 +1,18 @@
+#include "objectfile.hpp"
+#include "linegeometry.hpp"
+#include "objectformat.hpp"
+#include <cstring>
+
+bool ObjectFile::Read(const std::string& path, ObjectData& object)
+{
+	ObjectLines lines;
+	const bool read = ReadObjectLines(path.c_str(), lines);
+
+	// same flat layout, only the positions are grouped and the offsets narrowed
+	object.positions.resize(lines.positions.size() / 3);
+	if (!object.positions.empty()) memcpy(object.positions.data(), lines.positions.data(), lines.positions.size() * sizeof(float));
+	object.importance = std::move(lines.importance);
+	object.scalarColor = std::move(lines.scalarColor);
+	object.lineOffsets.assign(lines.lineOffsets.begin(), lines.lineOffsets.end());
+	return read;
+}
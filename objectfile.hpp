@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+struct ObjectData;
+
+// OBJ line files (v / vt / l records), the two tex coords of a vertex are its importance and scalarColor.
+// Parsed with the chunked parser shared with the Transformer (format/objectformat.hpp).
+class ObjectFile
+{
+public:
+	// false if the file can not be opened, object holds all lines that could be read
+	static bool Read(const std::string& path, ObjectData& object);
+};
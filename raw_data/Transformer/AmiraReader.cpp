@@ -1,5 +1,12 @@
 #include "AmiraReader.hpp"
+#include "mappedfile.hpp"
+#include "Sampling.hpp"
 #include <fstream>
+#include <mutex>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
 #include <vtkFloatArray.h>
@@ -12,78 +19,158 @@ namespace vispro
 		return buffer;
 	}
 
+	// memory referenced by vtk arrays (mapping or aligned copy) -> released by the free function of the array
+	static std::mutex mappingMutex;
+	static std::unordered_multimap<const void*, std::shared_ptr<const void>> mappingOwners;
 
-	vtkSmartPointer<vtkImageData> AmiraReader::ReadField(const char* path, const char* fieldName, Eigen::AlignedBox3d& bounds, Eigen::Vector3i& resolution, Eigen::Vector3d& spacing, int& numComponents)
+	static void ReleaseMapping(void* data)
 	{
-		// read the header
-		if (!ReadHeader(path, bounds, resolution, spacing, numComponents)) return nullptr;
+		std::lock_guard<std::mutex> lock(mappingMutex);
+		auto owner = mappingOwners.find(data);
+		if (owner != mappingOwners.end())
+		{
+			mappingOwners.erase(owner);
+		}
+	}
 
-		// allocate output field
-		vtkNew<vtkImageData> field;
-		field->SetDimensions(resolution.data());
-		field->SetOrigin(bounds.min().data());
-		field->SetSpacing(spacing.data());
-		vtkNew<vtkFloatArray> mArray;
-		int64_t numPoints = (int64_t)field->GetDimensions()[0] * field->GetDimensions()[1] * field->GetDimensions()[2];
-		mArray->SetNumberOfComponents(numComponents);
-		mArray->SetNumberOfTuples(numPoints);
-		mArray->SetName(fieldName);
-		field->GetPointData()->AddArray(mArray);
-		field->GetPointData()->SetActiveScalars(fieldName);
+	bool AmiraView::Open(const char* path)
+	{
+		std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+		// copy-on-write: the values are handed to vtk as writable arrays
+		if (!file->OpenCopy(path)) return false;
+		if (!AmiraReader::ParseHeader(file->GetData(), file->GetSize(), mHeader)) return false;
 
-		// read the data
-		if (!ReadField(path, mArray)) return nullptr;
-		return field;
+		const int64_t numValues = (int64_t)mHeader.resolution[0] * mHeader.resolution[1] * mHeader.resolution[2] * mHeader.numComponents;
+		if ((uint64_t)(mHeader.dataOffset + numValues * (int64_t)sizeof(float)) > file->GetSize()) return false;
+
+		const char* data = file->GetData() + mHeader.dataOffset;
+		if ((uintptr_t)data % alignof(float) == 0)
+		{
+			mData = (const float*)data;
+			mAlignedCopy.reset();
+		}
+		else
+		{
+			// the header length is arbitrary -> a misaligned data section is read once into aligned memory
+			file.reset();
+			mAlignedCopy = std::make_shared<std::vector<float>>(numValues);
+			std::ifstream stream(path, std::ios::in | std::ios::binary);
+			stream.seekg(mHeader.dataOffset);
+			if (!stream.read((char*)mAlignedCopy->data(), numValues * sizeof(float))) return false;
+			mData = mAlignedCopy->data();
+		}
+		mFile = file;
+		mNumValues = numValues;
+		return true;
 	}
 
-	vtkSmartPointer<vtkImageData> AmiraReader::ReadField(const char* path, const char* fieldName)
+	FieldSampler AmiraView::CreateSampler() const
+	{
+		return FieldSampler(mData, mHeader.numComponents, mHeader.resolution, mHeader.bounds.min(), mHeader.spacing);
+	}
+
+	vtkSmartPointer<vtkImageData> AmiraView::CreateField(const char* fieldName) const
 	{
-		// read the header
-		Eigen::AlignedBox3d bounds;
-		Eigen::Vector3i resolution;
-		Eigen::Vector3d spacing;
-		int numComponents;
-		if (!ReadHeader(path, bounds, resolution, spacing, numComponents)) return nullptr;
-		
-		// allocate output field
 		vtkNew<vtkImageData> field;
-		field->SetDimensions(resolution.data());
-		field->SetOrigin(bounds.min().data());
-		field->SetSpacing(spacing.data());
+		field->SetDimensions(mHeader.resolution.data());
+		field->SetOrigin(mHeader.bounds.min().data());
+		field->SetSpacing(mHeader.spacing.data());
+
 		vtkNew<vtkFloatArray> mArray;
-		int64_t numPoints = (int64_t)field->GetDimensions()[0] * field->GetDimensions()[1] * field->GetDimensions()[2];
-		mArray->SetNumberOfComponents(numComponents);
-		mArray->SetNumberOfTuples(numPoints);
+		mArray->SetNumberOfComponents(mHeader.numComponents);
 		mArray->SetName(fieldName);
+		// no copy -> the array releases its reference on the memory when it is deleted
+		{
+			std::lock_guard<std::mutex> lock(mappingMutex);
+			if (mAlignedCopy)
+				mappingOwners.emplace(mData, mAlignedCopy);
+			else
+				mappingOwners.emplace(mData, mFile);
+		}
+		mArray->SetArray(const_cast<float*>(mData), mNumValues, 0, vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+		mArray->SetArrayFreeFunction(ReleaseMapping);
 		field->GetPointData()->AddArray(mArray);
 		field->GetPointData()->SetActiveScalars(fieldName);
-
-		// read the data
-		if (!ReadField(path, mArray)) return nullptr;
 		return field;
 	}
 
+	vtkSmartPointer<vtkImageData> AmiraReader::ReadField(const char* path, const char* fieldName, Eigen::AlignedBox3d& bounds, Eigen::Vector3i& resolution, Eigen::Vector3d& spacing, int& numComponents)
+	{
+		AmiraView view;
+		if (!view.Open(path)) return nullptr;
+
+		// header data
+		bounds = view.GetHeader().bounds;
+		resolution = view.GetHeader().resolution;
+		spacing = view.GetHeader().spacing;
+		numComponents = view.GetHeader().numComponents;
+		return view.CreateField(fieldName);
+	}
+
+	vtkSmartPointer<vtkImageData> AmiraReader::ReadField(const char* path, const char* fieldName)
+	{
+		AmiraView view;
+		if (!view.Open(path)) return nullptr;
+		return view.CreateField(fieldName);
+	}
+
 	bool AmiraReader::ReadHeader(const char* path, Eigen::AlignedBox3d& bounds, Eigen::Vector3i& resolution, Eigen::Vector3d& spacing, int& numComponents)
 	{
-		// get the path parameter
-		FILE* fp = fopen(path, "rb");
-		if (!fp) return false;
+		// only the header pages of the mapping are touched
+		MappedFile file;
+		if (!file.Open(path)) return false;
+
+		AmiraHeader header;
+		if (!ParseHeader(file.GetData(), file.GetSize(), header)) return false;
+		bounds = header.bounds;
+		resolution = header.resolution;
+		spacing = header.spacing;
+		numComponents = header.numComponents;
+		return true;
+	}
 
-		// We read the first 2k bytes into memory to parse the header.
-		// The fixed buffer size looks a bit like a hack, and it is one, but it gets the job done.
-		char buffer[2048];
-		fread(buffer, sizeof(char), 2047, fp);
-		buffer[2047] = '\0'; //The following string routines prefer null-terminated strings
+	bool AmiraReader::ReadField(const char* path, vtkFloatArray* output)
+	{
+		AmiraView view;
+		if (!view.Open(path)) return false;
+
+		// copy the data
+		const int64_t numValues = output->GetNumberOfValues();
+		if (numValues > view.GetNumValues()) return false;
+		std::memcpy(output->GetPointer(0), view.GetData(), numValues * sizeof(float));
+		return true;
+	}
+
+	bool AmiraReader::ParseHeader(const char* data, const int64_t size, AmiraHeader& header)
+	{
+		// The header is text up to "# Data section follows", followed by a line "@1" and the binary data.
+		static const char dataMarker[] = "# Data section follows";
+		const char* end = data + size;
+		const char* marker = std::search(data, end, dataMarker, dataMarker + sizeof(dataMarker) - 1);
+		if (marker == end) return false;
+
+		// Consume the marker line and the next line, which is "@1"
+		const char* dataStart = marker;
+		for (int line = 0; line < 2; line++)
+		{
+			dataStart = std::find(dataStart, end, '\n');
+			if (dataStart == end) return false;
+			dataStart++;
+		}
+		header.dataOffset = dataStart - data;
+
+		// The following string routines prefer null-terminated strings
+		const std::string text(data, marker);
+		const char* buffer = text.c_str();
 
 		if (!strstr(buffer, "# AmiraMesh BINARY-LITTLE-ENDIAN 2.1")) {
-			fclose(fp);
 			return false;
 		}
 
 		// Find the Lattice definition, i.e., the dimensions of the uniform grid
 		int xDim(0), yDim(0), zDim(0);
 		if (sscanf(FindAndJump(buffer, "define Lattice"), "%d %d %d", &xDim, &yDim, &zDim) == 3)
-			resolution = Eigen::Vector3i(xDim, yDim, zDim);
+			header.resolution = Eigen::Vector3i(xDim, yDim, zDim);
 
 		//Is it a uniform grid? We need this only for the sanity check below.
 		const bool bIsUniform = (strstr(buffer, "CoordType \"uniform\"") != NULL);
@@ -92,73 +179,34 @@ namespace vispro
 		float xmin(1.0f), ymin(1.0f), zmin(1.0f);
 		float xmax(-1.0f), ymax(-1.0f), zmax(-1.0f);
 		if (sscanf(FindAndJump(buffer, "BoundingBox"), "%g %g %g %g %g %g", &xmin, &xmax, &ymin, &ymax, &zmin, &zmax) == 6)
-			bounds = Eigen::AlignedBox3d(Eigen::Vector3d(xmin, ymin, zmin), Eigen::Vector3d(xmax, ymax, zmax));
+			header.bounds = Eigen::AlignedBox3d(Eigen::Vector3d(xmin, ymin, zmin), Eigen::Vector3d(xmax, ymax, zmax));
 
 		//Type of the field: scalar, vector
-		numComponents = 0;
+		header.numComponents = 0;
 		if (strstr(buffer, "Lattice { float Data }"))
 		{
 			// Scalar field
-			numComponents = 1;
+			header.numComponents = 1;
 		}
 		else
 		{
 			// A field with more than one component, i.e., a vector field
-			if (sscanf(FindAndJump(buffer, "Lattice { float["), "%d", &numComponents) != 1)
+			if (sscanf(FindAndJump(buffer, "Lattice { float["), "%d", &header.numComponents) != 1)
 			{
-				fclose(fp);
 				return false;
 			}
 		}
 
 		// Sanity check
-		if (xDim <= 0 || yDim <= 0 || zDim <= 0 || xmin > xmax || ymin > ymax || zmin > zmax || !bIsUniform || numComponents <= 0) {
-			fclose(fp);
+		if (xDim <= 0 || yDim <= 0 || zDim <= 0 || xmin > xmax || ymin > ymax || zmin > zmax || !bIsUniform || header.numComponents <= 0) {
 			return false;
 		}
 
 		// compute spacing
-		spacing = Eigen::Vector3d(
-			(bounds.max()[0] - bounds.min()[0]) / (resolution[0] - 1.),
-			(bounds.max()[1] - bounds.min()[1]) / (resolution[1] - 1.),
-			(bounds.max()[2] - bounds.min()[2]) / (resolution[2] - 1.));
+		header.spacing = Eigen::Vector3d(
+			(header.bounds.max()[0] - header.bounds.min()[0]) / (header.resolution[0] - 1.),
+			(header.bounds.max()[1] - header.bounds.min()[1]) / (header.resolution[1] - 1.),
+			(header.bounds.max()[2] - header.bounds.min()[2]) / (header.resolution[2] - 1.));
 		return true;
 	}
-
-	bool AmiraReader::ReadField(const char* path, vtkFloatArray* output)
-	{
-		// get the path parameter
-		FILE* fp = fopen(path, "rb");
-		if (!fp) return false;
-
-		// We read the first 2k bytes into memory to parse the header.
-		// The fixed buffer size looks a bit like a hack, and it is one, but it gets the job done.
-		char buffer[2048];
-		fread(buffer, sizeof(char), 2047, fp);
-		buffer[2047] = '\0'; //The following string routines prefer null-terminated strings
-
-		// Find the beginning of the data section
-		const long idxStartData = (long)(strstr(buffer, "# Data section follows") - buffer);
-		if (idxStartData > 0)
-		{
-			// Set the file pointer to the beginning of "# Data section follows"
-			fseek(fp, idxStartData, SEEK_SET);
-			// Consume this line, which is "# Data section follows"
-			fgets(buffer, 2047, fp);
-			// Consume the next line, which is "@1"
-			fgets(buffer, 2047, fp);
-
-			// read the data
-			const size_t numValues = output->GetNumberOfValues();
-			const size_t actRead = fread((void*)output->GetPointer(0), sizeof(float), numValues, fp);
-			if (numValues != actRead) {
-				fclose(fp);
-				return false;
-			}
-			fclose(fp);
-			return true;
-		}
-		fclose(fp);
-		return false;
-	}
-}
\ No newline at end of file
+}
@@ -2,13 +2,53 @@
 
 #include <vtkSmartPointer.h>
 #include <Eigen/Eigen>
+#include <memory>
+#include <vector>
 
 class vtkImageData;
 class vtkFloatArray;
+class MappedFile;
 
 namespace vispro
 {
-	// Helper class for writing vtkImageData to the Amira format (*.am)
+	class FieldSampler;
+
+	// Grid description from the header of an amira file.
+	struct AmiraHeader
+	{
+		Eigen::AlignedBox3d bounds;
+		Eigen::Vector3i resolution;
+		Eigen::Vector3d spacing;
+		int numComponents;
+		int64_t dataOffset;		// byte offset of the binary data section
+	};
+
+	// Read-only view onto the data section of a memory mapped amira file. The header is parsed once,
+	// the values are paged in by the os when they are touched. Copies of a view share the mapping.
+	class AmiraView
+	{
+	public:
+		bool Open(const char* path);
+
+		const AmiraHeader& GetHeader() const { return mHeader; }
+		const float* GetData() const { return mData; }
+		int64_t GetNumValues() const { return mNumValues; }
+
+		// Sampler that reads directly from the mapping.
+		FieldSampler CreateSampler() const;
+		// vtkImageData whose array references the mapping without a copy. The mapping stays alive as long as the array.
+		// The pages are copy-on-write, writing to the array never changes the file. Arrays of the same view share their values.
+		vtkSmartPointer<vtkImageData> CreateField(const char* fieldName) const;
+
+	private:
+		std::shared_ptr<MappedFile> mFile;
+		AmiraHeader mHeader;
+		const float* mData = nullptr;
+		int64_t mNumValues = 0;
+		std::shared_ptr<std::vector<float>> mAlignedCopy;	// only used if the data section is not float aligned
+	};
+
+	// Helper class for reading vtkImageData from the Amira format (*.am)
 	class AmiraReader
 	{
 	public:
@@ -23,5 +63,8 @@ namespace vispro
 
 		// Reads a field into a pre-allocated vtkFloatArray. Note that it needs to have the right size allocated!
 		static bool ReadField(const char* path, vtkFloatArray* output);
+
+		// Parses the header text in front of the data section.
+		static bool ParseHeader(const char* data, const int64_t size, AmiraHeader& header);
 	};
-}
\ No newline at end of file
+}
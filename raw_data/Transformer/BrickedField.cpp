@@ -0,0 +1,256 @@
+#include "BrickedField.hpp"
+#include "mappedfile.hpp"
+#include "Sampling.hpp"
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+
+namespace vispro
+{
+	// header of the cache file, the values follow at cacheDataOffset
+	struct BrickedFieldHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t layout;
+		int32_t dimensions[3];
+		int32_t numComponents;
+		double origin[3];
+		double spacing[3];
+		int64_t numNodes;
+	};
+	static const char cacheMagic[8] = "VPFIELD";
+	static const uint32_t cacheVersion = 1;
+	static const int64_t cacheDataOffset = 128;		// keeps the mapped values aligned
+
+	static const int brickBits = 3;
+	static const int brickSize = 1 << brickBits;
+	static const int brickMask = brickSize - 1;
+
+	// number of bits to address the indices [0, size)
+	static int NumBits(const int size)
+	{
+		int bits = 0;
+		while ((1 << bits) < size)
+		{
+			bits++;
+		}
+		return bits;
+	}
+
+	void BrickedField::Setup(const FieldSampler& field, const FieldLayout layout)
+	{
+		mLayout = layout;
+		mDimensions = field.GetDimensions();
+		mOrigin = field.GetOrigin();
+		mSpacing = field.GetSpacing();
+		for (int d = 0; d < 3; d++)
+		{
+			mOffsets[d].resize(mDimensions[d]);
+		}
+
+		switch (layout)
+		{
+		case FieldLayout::Bricked:
+		{
+			// offset = brick * 512 + local node, the bricks and the nodes inside a brick are x fastest
+			const Eigen::Vector3i numBricks = (mDimensions + Eigen::Vector3i::Constant(brickMask)) / brickSize;
+			const int64_t brickVolume = brickSize * brickSize * brickSize;
+			const int64_t brickStride[3] = { brickVolume, brickVolume * numBricks[0], brickVolume * numBricks[0] * numBricks[1] };
+			const int64_t localStride[3] = { 1, brickSize, brickSize * brickSize };
+			for (int d = 0; d < 3; d++)
+				for (int i = 0; i < mDimensions[d]; i++)
+					mOffsets[d][i] = (i >> brickBits) * brickStride[d] + (i & brickMask) * localStride[d];
+			mNumNodes = brickStride[2] * numBricks[2];
+			break;
+		}
+		case FieldLayout::ZOrder:
+		{
+			// interleave the index bits, dimensions that run out of bits are skipped -> no gaps besides the power of two padding
+			const int bits[3] = { NumBits(mDimensions[0]), NumBits(mDimensions[1]), NumBits(mDimensions[2]) };
+			int position[3][32];
+			int numPositions = 0;
+			for (int bit = 0; bit < 32; bit++)
+				for (int d = 0; d < 3; d++)
+					if (bit < bits[d])
+						position[d][bit] = numPositions++;
+
+			for (int d = 0; d < 3; d++)
+			{
+				for (int i = 0; i < mDimensions[d]; i++)
+				{
+					int64_t offset = 0;
+					for (int bit = 0; bit < bits[d]; bit++)
+					{
+						if (i & (1 << bit))
+						{
+							offset |= int64_t(1) << position[d][bit];
+						}
+					}
+					mOffsets[d][i] = offset;
+				}
+			}
+			mNumNodes = int64_t(1) << numPositions;
+			break;
+		}
+		default:
+			for (int i = 0; i < mDimensions[0]; i++)
+				mOffsets[0][i] = i;
+			for (int i = 0; i < mDimensions[1]; i++)
+				mOffsets[1][i] = (int64_t)i * mDimensions[0];
+			for (int i = 0; i < mDimensions[2]; i++)
+				mOffsets[2][i] = (int64_t)i * mDimensions[0] * mDimensions[1];
+			mNumNodes = (int64_t)mDimensions[0] * mDimensions[1] * mDimensions[2];
+			break;
+		}
+	}
+
+	void BrickedField::Convert(const FieldSampler& field, const FieldLayout layout)
+	{
+		Setup(field, layout);
+		mFile.reset();
+		mValues.assign(mNumNodes * 3, 0.0f);	// padding nodes are never sampled
+
+		const float* source = field.GetData();
+		const int numComponents = field.GetNumComponents();
+		#ifndef _DEBUG
+		#pragma omp parallel for
+		#endif
+		for (int iz = 0; iz < mDimensions[2]; iz++)
+		{
+			for (int iy = 0; iy < mDimensions[1]; iy++)
+			{
+				for (int ix = 0; ix < mDimensions[0]; ix++)
+				{
+					const float* value = source + field.LinearIndex(ix, iy, iz) * numComponents;
+					float* target = mValues.data() + NodeIndex(ix, iy, iz) * 3;
+					target[0] = value[0];
+					target[1] = value[1];
+					target[2] = value[2];
+				}
+			}
+		}
+		mData = mValues.data();
+	}
+
+	bool BrickedField::Write(const char* path) const
+	{
+		BrickedFieldHeader header = {};
+		std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+		header.version = cacheVersion;
+		header.layout = (uint32_t)mLayout;
+		header.numComponents = 3;
+		header.numNodes = mNumNodes;
+		for (int d = 0; d < 3; d++)
+		{
+			header.dimensions[d] = mDimensions[d];
+			header.origin[d] = mOrigin[d];
+			header.spacing[d] = mSpacing[d];
+		}
+
+		std::ofstream stream(path, std::ios::out | std::ios::binary);
+		if (!stream.is_open()) return false;
+		char padded[cacheDataOffset] = {};
+		std::memcpy(padded, &header, sizeof(header));
+		stream.write(padded, cacheDataOffset);
+		stream.write((const char*)mData, mNumNodes * 3 * sizeof(float));
+		return stream.good();
+	}
+
+	bool BrickedField::Read(const char* path, const FieldSampler& field, const FieldLayout layout, const char* sourcePath)
+	{
+		// the cache is outdated if the amira file has been written after it
+		if (sourcePath)
+		{
+			std::error_code error;
+			const std::filesystem::file_time_type cacheTime = std::filesystem::last_write_time(path, error);
+			if (error) return false;
+			const std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(sourcePath, error);
+			if (error || cacheTime < sourceTime) return false;
+		}
+
+		std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+		if (!file->Open(path) || file->GetSize() < (uint64_t)cacheDataOffset) return false;
+
+		BrickedFieldHeader header;
+		std::memcpy(&header, file->GetData(), sizeof(header));
+		if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion || header.layout != (uint32_t)layout || header.numComponents != 3)
+		{
+			return false;
+		}
+		for (int d = 0; d < 3; d++)
+		{
+			if (header.dimensions[d] != field.GetDimensions()[d] || header.origin[d] != field.GetOrigin()[d] || header.spacing[d] != field.GetSpacing()[d])
+			{
+				return false;
+			}
+		}
+
+		Setup(field, layout);
+		if (header.numNodes != mNumNodes || file->GetSize() < (uint64_t)(cacheDataOffset + mNumNodes * 3 * (int64_t)sizeof(float)))
+		{
+			return false;
+		}
+		mValues.clear();
+		mValues.shrink_to_fit();
+		mFile = file;
+		mData = (const float*)(file->GetData() + cacheDataOffset);
+		return true;
+	}
+
+	bool BrickedField::Load(const std::string& amiraPath, const FieldSampler& field, const FieldLayout layout)
+	{
+		const std::string cachePath = CachePath(amiraPath, layout);
+		if (Read(cachePath.c_str(), field, layout, amiraPath.c_str()))
+		{
+			return true;
+		}
+		Convert(field, layout);
+		Write(cachePath.c_str());
+		return false;
+	}
+
+	std::string BrickedField::CachePath(const std::string& amiraPath, const FieldLayout layout)
+	{
+		switch (layout)
+		{
+		case FieldLayout::Bricked:
+			return amiraPath + ".bricked";
+		case FieldLayout::ZOrder:
+			return amiraPath + ".zorder";
+		default:
+			return amiraPath + ".linear";
+		}
+	}
+
+	std::string BrickedField::ToString(const FieldLayout layout)
+	{
+		switch (layout)
+		{
+		case FieldLayout::Linear:
+			return "Linear";
+		case FieldLayout::Bricked:
+			return "Bricked";
+		case FieldLayout::ZOrder:
+			return "ZOrder";
+		default:
+			return "";
+		}
+	}
+
+	GridView BrickedField::GetGridView() const
+	{
+		GridView grid;
+		grid.data = mData;
+		grid.strideY = mDimensions.x();
+		grid.strideZ = (int64_t)mDimensions.x() * mDimensions.y();
+		for (int d = 0; d < 3; d++)
+		{
+			grid.maxIndex[d] = mDimensions[d] - 1;
+			grid.origin[d] = mOrigin[d];
+			grid.spacing[d] = mSpacing[d];
+			grid.offsets[d] = mLayout == FieldLayout::Linear ? nullptr : mOffsets[d].data();
+		}
+		return grid;
+	}
+}
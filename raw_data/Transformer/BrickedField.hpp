@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <Eigen/Eigen>
+#include "SamplingBatch.hpp"
+
+class MappedFile;
+
+namespace vispro
+{
+	class FieldSampler;
+
+	enum class FieldLayout
+	{
+		Linear,		// x fastest, as stored in the amira file
+		Bricked,	// 8x8x8 bricks, x fastest inside a brick and between bricks
+		ZOrder,		// morton order, every dimension is padded to the next power of two
+	};
+
+	// Copy of an interleaved float[3] vector field in a cache friendly node order.
+	// In the linear layout the eight corners of a cell lie in four rows that are one row and one slice apart, so a trilinear
+	// lookup touches distant cache lines and often different pages. Both the bricked and the morton layout keep most cells
+	// inside a few neighbouring cache lines. Their node offsets are separable (offset = x[ix] + y[iy] + z[iz]), so the
+	// batch sampler only replaces the stride multiplications with three small lookup tables and samples the same values.
+	// The conversion can be cached in a file next to the amira file, which is mapped on the next load.
+	class BrickedField
+	{
+	public:
+		// Re-orders the values of a linear field. The sampler has to have three components.
+		void Convert(const FieldSampler& field, const FieldLayout layout);
+
+		// Writes the converted field into a cache file.
+		bool Write(const char* path) const;
+		// Maps a cache file. Returns false if it is missing, has a different layout or grid, or is older than the source file.
+		bool Read(const char* path, const FieldSampler& field, const FieldLayout layout, const char* sourcePath = nullptr);
+		// Reads the cache next to the amira file or converts the field and writes the cache.
+		bool Load(const std::string& amiraPath, const FieldSampler& field, const FieldLayout layout);
+
+		// Cache file of a layout next to the amira file.
+		static std::string CachePath(const std::string& amiraPath, const FieldLayout layout);
+		static std::string ToString(const FieldLayout layout);
+
+		// Grid description with the offset tables of the layout for SamplingBatch.
+		GridView GetGridView() const;
+
+		inline int64_t NodeIndex(const int ix, const int iy, const int iz) const
+		{
+			return mOffsets[2][iz] + mOffsets[1][iy] + mOffsets[0][ix];
+		}
+
+		FieldLayout GetLayout() const { return mLayout; }
+		const float* GetData() const { return mData; }
+		// number of nodes including the padding of the layout
+		int64_t GetNumNodes() const { return mNumNodes; }
+
+	private:
+		// fills the offset tables and the number of nodes of the layout
+		void Setup(const FieldSampler& field, const FieldLayout layout);
+
+		FieldLayout mLayout = FieldLayout::Linear;
+		Eigen::Vector3i mDimensions;
+		Eigen::Vector3d mOrigin;
+		Eigen::Vector3d mSpacing;
+		std::vector<int64_t> mOffsets[3];
+		int64_t mNumNodes = 0;
+
+		const float* mData = nullptr;
+		std::vector<float> mValues;				// converted values
+		std::shared_ptr<MappedFile> mFile;		// or the mapped cache file
+	};
+}
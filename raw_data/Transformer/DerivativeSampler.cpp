@@ -0,0 +1,154 @@
+#include "DerivativeSampler.hpp"
+#include "Sampling.hpp"
+#include "Jacobian.hpp"
+#include <algorithm>
+
+namespace vispro
+{
+	DerivativeSampler::Brick::Brick(const int numComponents) : values(new float[(size_t)brickVolume * numComponents])
+	{
+		for (std::atomic<uint8_t>& node : state)
+		{
+			node.store(NodeState::Empty, std::memory_order_relaxed);
+		}
+	}
+
+	DerivativeSampler::DerivativeSampler(const FieldSampler& velocity, const DerivativeQuantity quantity) :
+		mVelocity(velocity), mQuantity(quantity), mNumComponents(quantity == DerivativeQuantity::Acceleration ? 3 : 1), mNumCachedNodes(0), mNumCachedBricks(0)
+	{
+		const Eigen::Vector3i& res = velocity.GetDimensions();
+		mNumBricks = Eigen::Vector3i((res[0] + brickMask) >> brickBits, (res[1] + brickMask) >> brickBits, (res[2] + brickMask) >> brickBits);
+		const int64_t numBricks = (int64_t)mNumBricks[0] * mNumBricks[1] * mNumBricks[2];
+		mBricks.reset(new std::atomic<Brick*>[numBricks]);
+		for (int64_t i = 0; i < numBricks; i++)
+		{
+			mBricks[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	DerivativeSampler::~DerivativeSampler()
+	{
+		const int64_t numBricks = (int64_t)mNumBricks[0] * mNumBricks[1] * mNumBricks[2];
+		for (int64_t i = 0; i < numBricks; i++)
+		{
+			delete mBricks[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	DerivativeSampler::Brick& DerivativeSampler::GetBrick(const int ix, const int iy, const int iz) const
+	{
+		std::atomic<Brick*>& slot = mBricks[((int64_t)(iz >> brickBits) * mNumBricks[1] + (iy >> brickBits)) * mNumBricks[0] + (ix >> brickBits)];
+		Brick* brick = slot.load(std::memory_order_acquire);
+		if (brick)
+		{
+			return *brick;
+		}
+
+		// several threads may allocate the same brick -> the first one wins, the others drop theirs
+		Brick* allocated = new Brick(mNumComponents);
+		if (slot.compare_exchange_strong(brick, allocated, std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			mNumCachedBricks.fetch_add(1, std::memory_order_relaxed);
+			return *allocated;
+		}
+		delete allocated;
+		return *brick;
+	}
+
+	void DerivativeSampler::Evaluate(const int ix, const int iy, const int iz, float* values) const
+	{
+		// same expressions as Jacobian::Compute
+		const Eigen::Matrix3d jacobian = Jacobian::NodeJacobian(mVelocity, ix, iy, iz);
+		if (mQuantity == DerivativeQuantity::Acceleration)
+		{
+			Eigen::Vector3d vel(mVelocity.Value3(mVelocity.LinearIndex(ix, iy, iz)));
+			Eigen::Vector3d acceleration = jacobian * vel;
+			values[0] = acceleration[0];
+			values[1] = acceleration[1];
+			values[2] = acceleration[2];
+		}
+		else
+		{
+			values[0] = Jacobian::Curl(jacobian).norm();
+		}
+	}
+
+	void DerivativeSampler::Node(const int ix, const int iy, const int iz, float* values) const
+	{
+		Brick& brick = GetBrick(ix, iy, iz);
+		const int local = ((iz & brickMask) * brickSize + (iy & brickMask)) * brickSize + (ix & brickMask);
+		float* node = brick.values.get() + (size_t)local * mNumComponents;
+
+		uint8_t state = brick.state[local].load(std::memory_order_acquire);
+		if (state == NodeState::Empty && brick.state[local].compare_exchange_strong(state, NodeState::Filling, std::memory_order_acquire))
+		{
+			Evaluate(ix, iy, iz, node);
+			brick.state[local].store(NodeState::Filled, std::memory_order_release);
+			mNumCachedNodes.fetch_add(1, std::memory_order_relaxed);
+			state = NodeState::Filled;
+		}
+
+		if (state == NodeState::Filled)
+		{
+			std::copy(node, node + mNumComponents, values);
+		}
+		else
+		{
+			// another thread is filling the node -> the same values without waiting for it
+			Evaluate(ix, iy, iz, values);
+		}
+	}
+
+	void DerivativeSampler::Corners(const Eigen::Vector3d& position, Cursor& cursor, Eigen::Vector3d& interp) const
+	{
+		Eigen::Vector3i sample0, sample1;
+		mVelocity.CellCoordinates(position, sample0, sample1, interp);
+		if (sample0 != cursor.sample0 || sample1 != cursor.sample1)
+		{
+			Node(sample0.x(), sample0.y(), sample0.z(), cursor.corners[0]);
+			Node(sample1.x(), sample0.y(), sample0.z(), cursor.corners[1]);
+			Node(sample0.x(), sample1.y(), sample0.z(), cursor.corners[2]);
+			Node(sample1.x(), sample1.y(), sample0.z(), cursor.corners[3]);
+			Node(sample0.x(), sample0.y(), sample1.z(), cursor.corners[4]);
+			Node(sample1.x(), sample0.y(), sample1.z(), cursor.corners[5]);
+			Node(sample0.x(), sample1.y(), sample1.z(), cursor.corners[6]);
+			Node(sample1.x(), sample1.y(), sample1.z(), cursor.corners[7]);
+			cursor.sample0 = sample0;
+			cursor.sample1 = sample1;
+		}
+	}
+
+	// same weighting as FieldSampler::Sample3
+	Eigen::Vector3d DerivativeSampler::SampleAcceleration(const Eigen::Vector3d& position, Cursor& cursor) const
+	{
+		Eigen::Vector3d interp;
+		Corners(position, cursor, interp);
+		auto value = [&cursor](const int corner) { return Eigen::Vector3d(cursor.corners[corner][0], cursor.corners[corner][1], cursor.corners[corner][2]); };
+		return
+			(1 - interp.z()) * (1 - interp.y()) * (1 - interp.x()) * value(0)
+			+ (1 - interp.z()) * (1 - interp.y()) * (interp.x()) * value(1)
+			+ (1 - interp.z()) * (interp.y()) * (1 - interp.x()) * value(2)
+			+ (1 - interp.z()) * (interp.y()) * (interp.x()) * value(3)
+			+ (interp.z()) * (1 - interp.y()) * (1 - interp.x()) * value(4)
+			+ (interp.z()) * (1 - interp.y()) * (interp.x()) * value(5)
+			+ (interp.z()) * (interp.y()) * (1 - interp.x()) * value(6)
+			+ (interp.z()) * (interp.y()) * (interp.x()) * value(7);
+	}
+
+	// same weighting as FieldSampler::Sample1
+	double DerivativeSampler::SampleVorticity(const Eigen::Vector3d& position, Cursor& cursor) const
+	{
+		Eigen::Vector3d interp;
+		Corners(position, cursor, interp);
+		const float (&c)[8][3] = cursor.corners;
+		return
+			(1 - interp.z()) * (1 - interp.y()) * (1 - interp.x()) * (double)c[0][0]
+			+ (1 - interp.z()) * (1 - interp.y()) * (interp.x()) * (double)c[1][0]
+			+ (1 - interp.z()) * (interp.y()) * (1 - interp.x()) * (double)c[2][0]
+			+ (1 - interp.z()) * (interp.y()) * (interp.x()) * (double)c[3][0]
+			+ (interp.z()) * (1 - interp.y()) * (1 - interp.x()) * (double)c[4][0]
+			+ (interp.z()) * (1 - interp.y()) * (interp.x()) * (double)c[5][0]
+			+ (interp.z()) * (interp.y()) * (1 - interp.x()) * (double)c[6][0]
+			+ (interp.z()) * (interp.y()) * (interp.x()) * (double)c[7][0];
+	}
+}
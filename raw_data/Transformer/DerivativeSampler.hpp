@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <Eigen/Eigen>
+
+namespace vispro
+{
+	class FieldSampler;
+
+	// quantity derived from the velocity gradient, one per sampler
+	enum class DerivativeQuantity
+	{
+		Acceleration,	// J v, 3 components
+		Vorticity,		// |curl v|, 1 component
+	};
+
+	// Samples a quantity derived from the velocity gradient directly at query points instead of materialising the whole field.
+	// The jacobian of a grid node is evaluated with the stencil of Jacobian::Compute the first time a cell touching the node
+	// is sampled and the quantity is cached in sparse 8x8x8 bricks. The values are stored as float, so the results match sampling
+	// the fields of Jacobian::Compute exactly while memory and work grow with the cells the lines touch, not with the grid.
+	// One sampler is shared by all threads: bricks are allocated with a compare and swap, every node has an atomic fill state.
+	// A thread that finds a node being filled by another thread evaluates it for itself without storing it.
+	class DerivativeSampler
+	{
+	public:
+		// corners of the last sampled cell, one per thread -> consecutive vertices of a line mostly fall into the same cell
+		struct Cursor
+		{
+			Eigen::Vector3i sample0 = Eigen::Vector3i(-1, -1, -1);
+			Eigen::Vector3i sample1 = Eigen::Vector3i(-1, -1, -1);
+			float corners[8][3];
+		};
+
+		DerivativeSampler(const FieldSampler& velocity, const DerivativeQuantity quantity);
+		~DerivativeSampler();
+		DerivativeSampler(const DerivativeSampler&) = delete;
+		DerivativeSampler& operator=(const DerivativeSampler&) = delete;
+
+		// Linearly interpolated acceleration J v at a given domain location. Requires DerivativeQuantity::Acceleration.
+		Eigen::Vector3d SampleAcceleration(const Eigen::Vector3d& position, Cursor& cursor) const;
+		// Linearly interpolated vorticity magnitude |curl v| at a given domain location. Requires DerivativeQuantity::Vorticity.
+		double SampleVorticity(const Eigen::Vector3d& position, Cursor& cursor) const;
+
+		// number of grid nodes that have been evaluated and stored
+		int64_t GetNumCachedNodes() const { return mNumCachedNodes.load(std::memory_order_relaxed); }
+		// number of allocated bricks
+		int64_t GetNumCachedBricks() const { return mNumCachedBricks.load(std::memory_order_relaxed); }
+
+	private:
+		enum NodeState : uint8_t
+		{
+			Empty,
+			Filling,
+			Filled,
+		};
+
+		static const int brickBits = 3;
+		static const int brickSize = 1 << brickBits;
+		static const int brickMask = brickSize - 1;
+		static const int brickVolume = brickSize * brickSize * brickSize;
+
+		struct Brick
+		{
+			Brick(const int numComponents);
+			std::atomic<uint8_t> state[brickVolume];
+			std::unique_ptr<float[]> values;	// numComponents per node
+		};
+
+		// brick of the node, allocated on first access
+		Brick& GetBrick(const int ix, const int iy, const int iz) const;
+		// quantity of the node, computed on first access
+		void Node(const int ix, const int iy, const int iz, float* values) const;
+		// evaluates the quantity with the expressions of Jacobian::Compute
+		void Evaluate(const int ix, const int iy, const int iz, float* values) const;
+		// values at the eight corners of the cell containing the position
+		void Corners(const Eigen::Vector3d& position, Cursor& cursor, Eigen::Vector3d& interp) const;
+
+		const FieldSampler& mVelocity;
+		const DerivativeQuantity mQuantity;
+		const int mNumComponents;
+		Eigen::Vector3i mNumBricks;
+		std::unique_ptr<std::atomic<Brick*>[]> mBricks;
+		mutable std::atomic<int64_t> mNumCachedNodes;
+		mutable std::atomic<int64_t> mNumCachedBricks;
+	};
+}
@@ -0,0 +1,81 @@
+#include "DistanceMatrix.hpp"
+#include "mappedfile.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace vispro
+{
+	static const uint64_t distanceMatrixValuesOffset = 64;
+
+	bool DistanceMatrixView::Open(const char* path)
+	{
+		std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+		if (!file->Open(path) || file->GetSize() < sizeof(DistanceMatrixHeader)) return false;
+
+		const DistanceMatrixHeader* header = (const DistanceMatrixHeader*)file->GetData();
+		if (std::memcmp(header->magic, DISTANCEMATRIX_MAGIC, sizeof(DISTANCEMATRIX_MAGIC)) != 0 || header->version != DISTANCEMATRIX_VERSION) return false;
+		const uint64_t numValues = header->numLines * (header->numLines - 1) / 2;
+		if (header->numLines == 0 || header->valuesOffset + numValues * sizeof(float) > file->GetSize()) return false;
+
+		mFile = file;
+		mHeader = header;
+		mValues = (const float*)(file->GetData() + header->valuesOffset);
+		return true;
+	}
+
+	Eigen::MatrixXd DistanceMatrixView::ToMatrix() const
+	{
+		const int64_t numLines = (int64_t)mHeader->numLines;
+		Eigen::MatrixXd distance(numLines, numLines);
+		#ifndef _DEBUG
+		#pragma omp parallel for
+		#endif
+		for (int64_t j = 0; j < numLines; j++)
+		{
+			// column j is row j of the symmetric matrix
+			for (int64_t i = 0; i < numLines; i++)
+			{
+				distance(i, j) = (*this)(i, j);
+			}
+		}
+		return distance;
+	}
+
+	bool DistanceMatrixWriter::WriteDistanceMatrix(const char* filename, const Eigen::MatrixXd& distance, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized, const double farDistance)
+	{
+		const uint64_t numLines = distance.rows();
+		if (numLines == 0 || distance.cols() != distance.rows()) return false;
+		const uint64_t numValues = numLines * (numLines - 1) / 2;
+
+		MappedFile file;
+		if (!file.Create(filename, distanceMatrixValuesOffset + std::max<uint64_t>(numValues, 1) * sizeof(float))) return false;
+
+		DistanceMatrixHeader* header = (DistanceMatrixHeader*)file.GetData();
+		std::memset(header, 0, distanceMatrixValuesOffset);
+		std::memcpy(header->magic, DISTANCEMATRIX_MAGIC, sizeof(DISTANCEMATRIX_MAGIC));
+		header->version = DISTANCEMATRIX_VERSION;
+		header->normalized = normalized ? 1 : 0;
+		header->numLines = numLines;
+		std::strncpy(header->metric, metric.c_str(), sizeof(header->metric) - 1);
+		header->importanceWeight = importanceWeight;
+		header->scalarColorWeight = scalarColorWeight;
+		header->valuesOffset = distanceMatrixValuesOffset;
+		header->farDistance = (float)farDistance;
+
+		// row i of the upper triangle equals the lower part of column i, which is contiguous in eigen
+		float* values = (float*)(file.GetData() + distanceMatrixValuesOffset);
+		#ifndef _DEBUG
+		#pragma omp parallel for schedule(dynamic, 64)
+		#endif
+		for (int64_t i = 0; i < (int64_t)numLines; i++)
+		{
+			float* row = values + DistanceMatrixView::CondensedIndex(i, i + 1, numLines);
+			for (uint64_t j = i + 1; j < numLines; j++)
+			{
+				row[j - i - 1] = (float)distance(j, i);
+			}
+		}
+		file.Close();
+		return true;
+	}
+}
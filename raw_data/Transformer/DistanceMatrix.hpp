@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <Eigen/Eigen>
+#include "distancematrixformat.hpp"
+
+class MappedFile;
+
+namespace vispro
+{
+	// Read-only view onto a memory mapped distance matrix.
+	class DistanceMatrixView
+	{
+	public:
+		bool Open(const char* path);
+
+		const DistanceMatrixHeader& GetHeader() const { return *mHeader; }
+		uint64_t GetNumLines() const { return mHeader->numLines; }
+		const float* GetValues() const { return mValues; }
+		float operator()(const uint64_t i, const uint64_t j) const
+		{
+			if (i == j) return 0.0f;
+			return i < j ? mValues[CondensedIndex(i, j, mHeader->numLines)] : mValues[CondensedIndex(j, i, mHeader->numLines)];
+		}
+		Eigen::MatrixXd ToMatrix() const;
+
+		// position of the pair i < j in the condensed upper triangle
+		static uint64_t CondensedIndex(const uint64_t i, const uint64_t j, const uint64_t numLines)
+		{
+			return DistanceMatrixIndex(i, j, numLines);
+		}
+
+	private:
+		std::shared_ptr<MappedFile> mFile;
+		const DistanceMatrixHeader* mHeader = nullptr;
+		const float* mValues = nullptr;
+	};
+
+	class DistanceMatrixWriter
+	{
+	public:
+		// Writes the upper triangle of the (symmetric) matrix through a writable mapping of the file.
+		static bool WriteDistanceMatrix(const char* filename, const Eigen::MatrixXd& distance, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized, const double farDistance);
+	};
+}
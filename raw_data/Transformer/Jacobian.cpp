@@ -0,0 +1,139 @@
+#include "Jacobian.hpp"
+#include "Sampling.hpp"
+#include <vtkPointData.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <omp.h>
+#include <algorithm>
+
+namespace vispro
+{
+	// the per node stencil matches Jacobian::NodeJacobian, the pass only hoists the row offsets
+	// tile of the cache blocked pass -> a tile walks through its z slabs, the three slabs touched by the stencil stay in cache
+	static const int tileRows = 16;
+	static const int tileSlabs = 32;
+
+	JacobianFields Jacobian::Compute(const vtkSmartPointer<vtkImageData>& velocityField, const bool invariants)
+	{
+		JacobianFields fields;
+		JacobianOutputs outputs;
+		fields.vorticity = AllocateField(velocityField, "vorticity", 1, outputs.vorticity);
+		fields.acceleration = AllocateField(velocityField, "acceleration", 3, outputs.acceleration);
+		if (invariants)
+		{
+			fields.lambda2 = AllocateField(velocityField, "lambda2", 1, outputs.lambda2);
+			fields.qCriterion = AllocateField(velocityField, "qCriterion", 1, outputs.qCriterion);
+			fields.helicity = AllocateField(velocityField, "helicity", 1, outputs.helicity);
+		}
+		Compute(FieldSampler(velocityField, "velocity"), outputs);
+		return fields;
+	}
+
+	vtkSmartPointer<vtkImageData> Jacobian::AllocateField(vtkImageData* velocityField, const char* name, const int numComponents, float*& values)
+	{
+		vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+		image->SetDimensions(velocityField->GetDimensions());
+		image->SetOrigin(velocityField->GetOrigin());
+		image->SetSpacing(velocityField->GetSpacing());
+
+		vtkNew<vtkFloatArray> array;
+		int64_t numPoints = (int64_t)velocityField->GetDimensions()[0] * velocityField->GetDimensions()[1] * velocityField->GetDimensions()[2];
+		array->SetNumberOfComponents(numComponents);
+		array->SetNumberOfTuples(numPoints);
+		array->SetName(name);
+		image->GetPointData()->AddArray(array);
+		image->GetPointData()->SetActiveScalars(name);
+		values = array->GetPointer(0);
+		return image;
+	}
+
+	void Jacobian::Compute(const FieldSampler& velocity, const JacobianOutputs& outputs)
+	{
+		const Eigen::Vector3i res = velocity.GetDimensions();
+		const Eigen::Vector3d spacing = velocity.GetSpacing();
+		const int numTilesY = (res[1] + tileRows - 1) / tileRows;
+		const int numTilesZ = (res[2] + tileSlabs - 1) / tileSlabs;
+		const int numTiles = numTilesY * numTilesZ;
+		const bool invariants = outputs.lambda2 || outputs.qCriterion;
+
+		#ifndef _DEBUG
+		#pragma omp parallel for schedule(dynamic)
+		#endif
+		for (int tile = 0; tile < numTiles; ++tile)
+		{
+			const int tileY = tile % numTilesY;
+			const int tileZ = tile / numTilesY;
+			const int yBegin = tileY * tileRows, yEnd = std::min(yBegin + tileRows, res[1]);
+			const int zBegin = tileZ * tileSlabs, zEnd = std::min(zBegin + tileSlabs, res[2]);
+			for (int iz = zBegin; iz < zEnd; ++iz) {
+				const int iz0 = std::max(0, iz - 1);
+				const int iz1 = std::min(iz + 1, res[2] - 1);
+				const double spacing_z = (iz1 - iz0) * spacing[2];
+				for (int iy = yBegin; iy < yEnd; ++iy) {
+					const int iy0 = std::max(0, iy - 1);
+					const int iy1 = std::min(iy + 1, res[1] - 1);
+					const double spacing_y = (iy1 - iy0) * spacing[1];
+					const int64_t row = velocity.LinearIndex(0, iy, iz);
+					const int64_t row_y0 = velocity.LinearIndex(0, iy0, iz);
+					const int64_t row_y1 = velocity.LinearIndex(0, iy1, iz);
+					const int64_t row_z0 = velocity.LinearIndex(0, iy, iz0);
+					const int64_t row_z1 = velocity.LinearIndex(0, iy, iz1);
+					for (int ix = 0; ix < res[0]; ++ix) {
+						const int ix0 = std::max(0, ix - 1);
+						const int ix1 = std::min(ix + 1, res[0] - 1);
+						const double spacing_x = (ix1 - ix0) * spacing[0];
+
+						Eigen::Vector3d dv_dx = (velocity.Value3(row + ix1) - velocity.Value3(row + ix0)) / spacing_x;
+						Eigen::Vector3d dv_dy = (velocity.Value3(row_y1 + ix) - velocity.Value3(row_y0 + ix)) / spacing_y;
+						Eigen::Vector3d dv_dz = (velocity.Value3(row_z1 + ix) - velocity.Value3(row_z0 + ix)) / spacing_z;
+
+						Eigen::Matrix3d jacobian;
+						jacobian.col(0) = dv_dx;
+						jacobian.col(1) = dv_dy;
+						jacobian.col(2) = dv_dz;
+
+						const int64_t linear = row + ix;
+						Eigen::Vector3d vel(velocity.Value3(linear));
+						Eigen::Vector3d vorticity(
+							dv_dy[2] - dv_dz[1],
+							dv_dz[0] - dv_dx[2],
+							dv_dx[1] - dv_dy[0]
+						);
+
+						if (outputs.vorticity)
+						{
+							outputs.vorticity[linear] = vorticity.norm();
+						}
+						if (outputs.acceleration)
+						{
+							Eigen::Vector3d acceleration = jacobian * vel;
+							outputs.acceleration[3 * linear + 0] = acceleration[0];
+							outputs.acceleration[3 * linear + 1] = acceleration[1];
+							outputs.acceleration[3 * linear + 2] = acceleration[2];
+						}
+						if (outputs.helicity)
+						{
+							outputs.helicity[linear] = vel.dot(vorticity);
+						}
+						if (invariants)
+						{
+							// strain rate and rotation tensor
+							Eigen::Matrix3d strain = 0.5 * (jacobian + jacobian.transpose());
+							Eigen::Matrix3d rotation = 0.5 * (jacobian - jacobian.transpose());
+							if (outputs.qCriterion)
+							{
+								outputs.qCriterion[linear] = 0.5 * (rotation.squaredNorm() - strain.squaredNorm());
+							}
+							if (outputs.lambda2)
+							{
+								Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+								solver.computeDirect(strain * strain + rotation * rotation, Eigen::EigenvaluesOnly);
+								outputs.lambda2[linear] = solver.eigenvalues()[1];	// sorted ascending
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <cstdint>
+#include <algorithm>
+#include "Sampling.hpp"
+
+namespace vispro
+{
+	// Preallocated outputs of the jacobian pass, one value (acceleration: three values) per grid point.
+	// Outputs that are nullptr are skipped.
+	struct JacobianOutputs
+	{
+		float* vorticity = nullptr;		// |curl v|
+		float* acceleration = nullptr;	// J v
+		float* lambda2 = nullptr;		// second eigenvalue of S^2 + Omega^2
+		float* qCriterion = nullptr;	// 0.5 (|Omega|^2 - |S|^2)
+		float* helicity = nullptr;		// v . curl v
+	};
+
+	// Fields derived from the velocity gradient. Fields that were not requested stay empty.
+	struct JacobianFields
+	{
+		vtkSmartPointer<vtkImageData> vorticity;
+		vtkSmartPointer<vtkImageData> acceleration;
+		vtkSmartPointer<vtkImageData> lambda2;
+		vtkSmartPointer<vtkImageData> qCriterion;
+		vtkSmartPointer<vtkImageData> helicity;
+	};
+
+	// Computes the velocity gradient with central differences (one sided at the boundary) in a single
+	// multithreaded pass over the raw velocity array and derives all requested quantities from it.
+	class Jacobian
+	{
+	public:
+		// Computes vorticity magnitude and acceleration, with invariants also lambda2, Q-criterion and helicity.
+		static JacobianFields Compute(const vtkSmartPointer<vtkImageData>& velocityField, const bool invariants = false);
+		// Fills the given outputs.
+		static void Compute(const FieldSampler& velocity, const JacobianOutputs& outputs);
+		// Velocity gradient at a grid node, J(i, j) = dv_i / dx_j.
+		static inline Eigen::Matrix3d NodeJacobian(const FieldSampler& velocity, const int ix, const int iy, const int iz)
+		{
+			const Eigen::Vector3i& res = velocity.GetDimensions();
+			const Eigen::Vector3d& spacing = velocity.GetSpacing();
+			const int ix0 = std::max(0, ix - 1);
+			const int ix1 = std::min(ix + 1, res[0] - 1);
+			const int iy0 = std::max(0, iy - 1);
+			const int iy1 = std::min(iy + 1, res[1] - 1);
+			const int iz0 = std::max(0, iz - 1);
+			const int iz1 = std::min(iz + 1, res[2] - 1);
+
+			const double spacing_x = (ix1 - ix0) * spacing[0];
+			const double spacing_y = (iy1 - iy0) * spacing[1];
+			const double spacing_z = (iz1 - iz0) * spacing[2];
+
+			const int64_t linear = velocity.LinearIndex(ix, iy, iz);
+			const int64_t strideY = res[0];
+			const int64_t strideZ = strideY * res[1];
+
+			Eigen::Matrix3d jacobian;
+			jacobian.col(0) = (velocity.Value3(linear + (ix1 - ix)) - velocity.Value3(linear - (ix - ix0))) / spacing_x;
+			jacobian.col(1) = (velocity.Value3(linear + (iy1 - iy) * strideY) - velocity.Value3(linear - (iy - iy0) * strideY)) / spacing_y;
+			jacobian.col(2) = (velocity.Value3(linear + (iz1 - iz) * strideZ) - velocity.Value3(linear - (iz - iz0) * strideZ)) / spacing_z;
+			return jacobian;
+		}
+
+		static inline Eigen::Vector3d Curl(const Eigen::Matrix3d& jacobian)
+		{
+			return Eigen::Vector3d(
+				jacobian(2, 1) - jacobian(1, 2),
+				jacobian(0, 2) - jacobian(2, 0),
+				jacobian(1, 0) - jacobian(0, 1)
+			);
+		}
+
+		// Allocates a float field with the grid of the velocity field.
+		static vtkSmartPointer<vtkImageData> AllocateField(vtkImageData* velocityField, const char* name, const int numComponents, float*& values);
+	};
+}
@@ -0,0 +1,91 @@
+#include "LineDistanceBatch.hpp"
+#include <algorithm>
+
+#if defined(VISPRO_X86_SIMD)
+#include <emmintrin.h>
+#endif
+
+namespace vispro
+{
+	void LineDistanceBatch::ClosestPointsScalar(const LineBlock& a, const LineBlock& b, float* minA, float* minB)
+	{
+		std::fill(minB, minB + b.paddedCount, 3.4e38f);
+		for (int64_t va = 0; va < a.count; va++)
+		{
+			const float p[5] = { a.values[0][va], a.values[1][va], a.values[2][va], a.values[3][va], a.values[4][va] };
+			float rowMin = 3.4e38f;
+			for (int64_t vb = 0; vb < b.paddedCount; vb++)
+			{
+				float distance = 0.0f;
+				for (int c = 0; c < 5; c++)
+				{
+					const float diff = p[c] - b.values[c][vb];
+					distance = distance + diff * diff;
+				}
+				rowMin = std::min(rowMin, distance);
+				minB[vb] = std::min(minB[vb], distance);
+			}
+			minA[va] = rowMin;
+		}
+	}
+
+	void LineDistanceBatch::ClosestPoints(const LineBlock& a, const LineBlock& b, float* minA, float* minB)
+	{
+		static const SimdLevel level = SamplingBatch::GetSimdLevel();
+		ClosestPoints(a, b, minA, minB, level);
+	}
+
+	void LineDistanceBatch::ClosestPoints(const LineBlock& a, const LineBlock& b, float* minA, float* minB, const SimdLevel level)
+	{
+		if (!SamplingBatch::IsSupported(level))
+		{
+			ClosestPointsScalar(a, b, minA, minB);
+			return;
+		}
+
+		switch (level)
+		{
+#if defined(VISPRO_X86_SIMD)
+		case SimdLevel::SSE2:
+			ClosestPointsSSE2(a, b, minA, minB);
+			break;
+		case SimdLevel::AVX2:
+			ClosestPointsAVX2(a, b, minA, minB);
+			break;
+		case SimdLevel::AVX512:
+			ClosestPointsAVX512(a, b, minA, minB);
+			break;
+#endif
+		default:
+			ClosestPointsScalar(a, b, minA, minB);
+			break;
+		}
+	}
+
+#if defined(VISPRO_X86_SIMD)
+	// four vertices of b per iteration
+	void LineDistanceBatch::ClosestPointsSSE2(const LineBlock& a, const LineBlock& b, float* minA, float* minB)
+	{
+		std::fill(minB, minB + b.paddedCount, 3.4e38f);
+		for (int64_t va = 0; va < a.count; va++)
+		{
+			const __m128 p[5] = { _mm_set1_ps(a.values[0][va]), _mm_set1_ps(a.values[1][va]), _mm_set1_ps(a.values[2][va]), _mm_set1_ps(a.values[3][va]), _mm_set1_ps(a.values[4][va]) };
+			__m128 rowMin = _mm_set1_ps(3.4e38f);
+			for (int64_t vb = 0; vb < b.paddedCount; vb += 4)
+			{
+				__m128 distance = _mm_setzero_ps();
+				for (int c = 0; c < 5; c++)
+				{
+					const __m128 diff = _mm_sub_ps(p[c], _mm_loadu_ps(b.values[c] + vb));
+					distance = _mm_add_ps(distance, _mm_mul_ps(diff, diff));
+				}
+				rowMin = _mm_min_ps(rowMin, distance);
+				_mm_storeu_ps(minB + vb, _mm_min_ps(_mm_loadu_ps(minB + vb), distance));
+			}
+			rowMin = _mm_min_ps(rowMin, _mm_movehl_ps(rowMin, rowMin));
+			rowMin = _mm_min_ss(rowMin, _mm_shuffle_ps(rowMin, rowMin, 1));
+			minA[va] = _mm_cvtss_f32(rowMin);
+		}
+	}
+#endif
+}
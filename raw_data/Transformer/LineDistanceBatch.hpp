@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include "SamplingBatch.hpp"
+
+// This header is also included by the translation units that are compiled with AVX2 / AVX-512 code generation.
+// Keep it free of Eigen, vtk and the standard library so that no inline function gets instantiated with wider instructions.
+
+namespace vispro
+{
+	// One line in structure-of-arrays float32 layout (x, y, z, importance, scalarColor).
+	// Every component holds paddedCount values, the padding vertices are set to LineDistanceBatch::paddingValue.
+	struct LineBlock
+	{
+		const float* values[5];
+		int64_t count;
+		int64_t paddedCount;	// multiple of LineDistanceBatch::padding
+	};
+
+	// Brute force closest point search between the vertices of two lines.
+	// Both directions are computed in one sweep: every vertex pair is visited once.
+	// All code paths compute the same squared distances in the same order.
+	class LineDistanceBatch
+	{
+	public:
+		static constexpr int64_t padding = 16;
+		static constexpr float paddingValue = 1e15f;	// far away from every line, but the squared distance stays finite
+
+		// minA[a.count]:			squared distance of every vertex of a to its closest vertex of b
+		// minB[b.paddedCount]:		squared distance of every vertex of b to its closest vertex of a
+		static void ClosestPoints(const LineBlock& a, const LineBlock& b, float* minA, float* minB);
+		// Falls back to the scalar path if the level is not available.
+		static void ClosestPoints(const LineBlock& a, const LineBlock& b, float* minA, float* minB, const SimdLevel level);
+		// Reference implementation.
+		static void ClosestPointsScalar(const LineBlock& a, const LineBlock& b, float* minA, float* minB);
+
+	private:
+		static void ClosestPointsSSE2(const LineBlock& a, const LineBlock& b, float* minA, float* minB);
+		static void ClosestPointsAVX2(const LineBlock& a, const LineBlock& b, float* minA, float* minB);
+		static void ClosestPointsAVX512(const LineBlock& a, const LineBlock& b, float* minA, float* minB);
+	};
+}
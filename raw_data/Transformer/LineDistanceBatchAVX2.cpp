@@ -0,0 +1,41 @@
+#include "LineDistanceBatch.hpp"
+
+// This translation unit is compiled with AVX2 code generation (see CMakeLists.txt).
+// It is only entered after SamplingBatch::IsSupported(SimdLevel::AVX2) returned true.
+#if defined(VISPRO_X86_SIMD)
+#include <immintrin.h>
+
+namespace vispro
+{
+	// eight vertices of b per iteration
+	void LineDistanceBatch::ClosestPointsAVX2(const LineBlock& a, const LineBlock& b, float* minA, float* minB)
+	{
+		const __m256 maximum = _mm256_set1_ps(3.4e38f);
+		for (int64_t vb = 0; vb < b.paddedCount; vb += 8)
+		{
+			_mm256_storeu_ps(minB + vb, maximum);
+		}
+
+		for (int64_t va = 0; va < a.count; va++)
+		{
+			const __m256 p[5] = { _mm256_set1_ps(a.values[0][va]), _mm256_set1_ps(a.values[1][va]), _mm256_set1_ps(a.values[2][va]), _mm256_set1_ps(a.values[3][va]), _mm256_set1_ps(a.values[4][va]) };
+			__m256 rowMin = maximum;
+			for (int64_t vb = 0; vb < b.paddedCount; vb += 8)
+			{
+				__m256 distance = _mm256_setzero_ps();
+				for (int c = 0; c < 5; c++)
+				{
+					const __m256 diff = _mm256_sub_ps(p[c], _mm256_loadu_ps(b.values[c] + vb));
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(diff, diff));
+				}
+				rowMin = _mm256_min_ps(rowMin, distance);
+				_mm256_storeu_ps(minB + vb, _mm256_min_ps(_mm256_loadu_ps(minB + vb), distance));
+			}
+			__m128 lanes = _mm_min_ps(_mm256_castps256_ps128(rowMin), _mm256_extractf128_ps(rowMin, 1));
+			lanes = _mm_min_ps(lanes, _mm_movehl_ps(lanes, lanes));
+			lanes = _mm_min_ss(lanes, _mm_shuffle_ps(lanes, lanes, 1));
+			minA[va] = _mm_cvtss_f32(lanes);
+		}
+	}
+}
+#endif
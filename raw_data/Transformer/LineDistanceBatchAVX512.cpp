@@ -0,0 +1,38 @@
+#include "LineDistanceBatch.hpp"
+
+// This translation unit is compiled with AVX-512 code generation (see CMakeLists.txt).
+// It is only entered after SamplingBatch::IsSupported(SimdLevel::AVX512) returned true.
+#if defined(VISPRO_X86_SIMD)
+#include <immintrin.h>
+
+namespace vispro
+{
+	// sixteen vertices of b per iteration -> one iteration per padding block
+	void LineDistanceBatch::ClosestPointsAVX512(const LineBlock& a, const LineBlock& b, float* minA, float* minB)
+	{
+		const __m512 maximum = _mm512_set1_ps(3.4e38f);
+		for (int64_t vb = 0; vb < b.paddedCount; vb += 16)
+		{
+			_mm512_storeu_ps(minB + vb, maximum);
+		}
+
+		for (int64_t va = 0; va < a.count; va++)
+		{
+			const __m512 p[5] = { _mm512_set1_ps(a.values[0][va]), _mm512_set1_ps(a.values[1][va]), _mm512_set1_ps(a.values[2][va]), _mm512_set1_ps(a.values[3][va]), _mm512_set1_ps(a.values[4][va]) };
+			__m512 rowMin = maximum;
+			for (int64_t vb = 0; vb < b.paddedCount; vb += 16)
+			{
+				__m512 distance = _mm512_setzero_ps();
+				for (int c = 0; c < 5; c++)
+				{
+					const __m512 diff = _mm512_sub_ps(p[c], _mm512_loadu_ps(b.values[c] + vb));
+					distance = _mm512_add_ps(distance, _mm512_mul_ps(diff, diff));
+				}
+				rowMin = _mm512_min_ps(rowMin, distance);
+				_mm512_storeu_ps(minB + vb, _mm512_min_ps(_mm512_loadu_ps(minB + vb), distance));
+			}
+			minA[va] = _mm512_reduce_min_ps(rowMin);
+		}
+	}
+}
+#endif
@@ -0,0 +1,157 @@
+#include "LineDistanceBatch.hpp"
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <random>
+#include <algorithm>
+#include <iostream>
+
+// Self-contained check of the closest point kernel of rMCPD: every simd level has to reproduce ClosestPointsScalar
+// on random line pairs, on degenerate lines (no vertex, one vertex, all vertices in one point) and on parallel and identical lines
+// (many equal distances). Returns non-zero if a level differs.
+
+using namespace vispro;
+
+static const float LINE_DISTANCE_TOLERANCE = FLT_EPSILON;	// relative to the squared distance
+static const int LINE_DISTANCE_RANDOM_PAIRS = 200;
+static const int LINE_DISTANCE_MAX_VERTICES = 70;
+
+// one line in the padded structure-of-arrays layout of LineDistanceMetrics
+struct CheckLine
+{
+	std::vector<float> values[5];
+	int64_t count;
+	int64_t paddedCount;
+
+	explicit CheckLine(const int64_t count) : count(count)
+	{
+		paddedCount = (count + LineDistanceBatch::padding - 1) / LineDistanceBatch::padding * LineDistanceBatch::padding;
+		for (std::vector<float>& component : values)
+		{
+			component.assign(std::max<int64_t>(paddedCount, LineDistanceBatch::padding), LineDistanceBatch::paddingValue);
+		}
+	}
+
+	LineBlock GetBlock() const
+	{
+		LineBlock block;
+		for (int c = 0; c < 5; c++)
+		{
+			block.values[c] = values[c].data();
+		}
+		block.count = count;
+		block.paddedCount = paddedCount;
+		return block;
+	}
+
+	void Set(const int64_t vertex, const float x, const float y, const float z, const float importance, const float scalarColor)
+	{
+		values[0][vertex] = x;
+		values[1][vertex] = y;
+		values[2][vertex] = z;
+		values[3][vertex] = importance;
+		values[4][vertex] = scalarColor;
+	}
+};
+
+static CheckLine RandomLine(const int64_t count, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> position(-5.f, 5.f), value(0.f, 1.f);
+	CheckLine line(count);
+	for (int64_t v = 0; v < count; v++)
+	{
+		line.Set(v, position(random), position(random), position(random), value(random), value(random));
+	}
+	return line;
+}
+
+// straight line along direction, shifted by offset
+static CheckLine StraightLine(const int64_t count, const float offset[3], const float direction[3])
+{
+	CheckLine line(count);
+	for (int64_t v = 0; v < count; v++)
+	{
+		line.Set(v, offset[0] + v * direction[0], offset[1] + v * direction[1], offset[2] + v * direction[2], 0.5f, 0.25f);
+	}
+	return line;
+}
+
+static float MaxError(const std::vector<float>& values, const std::vector<float>& reference, const int64_t count)
+{
+	float maxError = 0.f;
+	for (int64_t i = 0; i < count; i++)
+	{
+		maxError = std::max(maxError, std::fabs(values[i] - reference[i]) / std::max(reference[i], 1.f));
+	}
+	return maxError;
+}
+
+// compares all supported levels against ClosestPointsScalar in both directions, true if all of them match
+static bool CheckPairs(const std::vector<std::pair<CheckLine, CheckLine>>& pairs, const char* name)
+{
+	bool ok = true;
+	for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 })
+	{
+		if (!SamplingBatch::IsSupported(level))
+		{
+			std::cout << name << ", " << SamplingBatch::ToString(level) << ": not supported\n";
+			continue;
+		}
+
+		float maxError = 0.f;
+		for (const std::pair<CheckLine, CheckLine>& pair : pairs)
+		{
+			const LineBlock a = pair.first.GetBlock();
+			const LineBlock b = pair.second.GetBlock();
+			std::vector<float> minA0(std::max<int64_t>(a.count, 1)), minB0(std::max<int64_t>(b.paddedCount, 1));
+			std::vector<float> minA(minA0.size()), minB(minB0.size());
+			LineDistanceBatch::ClosestPointsScalar(a, b, minA0.data(), minB0.data());
+			LineDistanceBatch::ClosestPoints(a, b, minA.data(), minB.data(), level);
+			maxError = std::max(maxError, std::max(MaxError(minA, minA0, a.count), MaxError(minB, minB0, b.count)));
+		}
+		const bool match = maxError <= LINE_DISTANCE_TOLERANCE;
+		std::cout << name << ", " << SamplingBatch::ToString(level) << ": max relative error " << maxError << (match ? " (ok)\n" : " (FAILED)\n");
+		ok = ok && match;
+	}
+	return ok;
+}
+
+int main(int, char*[])
+{
+	std::cout << "Selected simd level: " << SamplingBatch::ToString(SamplingBatch::GetSimdLevel()) << "\n";
+
+	// random lengths -> padded and unpadded tails of every vector width
+	std::mt19937 random(11);
+	std::uniform_int_distribution<int> count(1, LINE_DISTANCE_MAX_VERTICES);
+	std::vector<std::pair<CheckLine, CheckLine>> pairs;
+	for (int i = 0; i < LINE_DISTANCE_RANDOM_PAIRS; i++)
+	{
+		pairs.emplace_back(RandomLine(count(random), random), RandomLine(count(random), random));
+	}
+	bool ok = CheckPairs(pairs, "random");
+
+	// no vertex, a single vertex and a line collapsed into one point
+	pairs.clear();
+	const float origin[3] = { 1.f, -2.f, 0.5f };
+	const float none[3] = { 0.f, 0.f, 0.f };
+	pairs.emplace_back(CheckLine(0), RandomLine(23, random));
+	pairs.emplace_back(RandomLine(1, random), RandomLine(1, random));
+	pairs.emplace_back(RandomLine(1, random), RandomLine(LineDistanceBatch::padding, random));
+	pairs.emplace_back(RandomLine(37, random), RandomLine(1, random));
+	pairs.emplace_back(StraightLine(29, origin, none), RandomLine(41, random));
+	pairs.emplace_back(StraightLine(29, origin, none), StraightLine(17, origin, none));
+	ok = CheckPairs(pairs, "degenerate") && ok;
+
+	// parallel, identical and crossing straight lines: equal distances between many vertex pairs
+	pairs.clear();
+	const float direction[3] = { 0.3f, 0.1f, -0.2f };
+	const float shifted[3] = { 1.f, -1.5f, 0.5f };
+	const float crossing[3] = { -0.1f, 0.3f, 0.2f };
+	pairs.emplace_back(StraightLine(33, origin, direction), StraightLine(33, shifted, direction));
+	pairs.emplace_back(StraightLine(48, origin, direction), StraightLine(48, origin, direction));
+	pairs.emplace_back(StraightLine(20, origin, direction), StraightLine(64, origin, direction));
+	pairs.emplace_back(StraightLine(45, origin, direction), StraightLine(45, origin, crossing));
+	ok = CheckPairs(pairs, "parallel") && ok;
+
+	return ok ? 0 : 1;
+}
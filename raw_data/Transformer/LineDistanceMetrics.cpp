@@ -1,17 +1,21 @@
 #include "LineDistanceMetrics.hpp"
+#include "LineDistanceBatch.hpp"
+#include <memory>
+#include <limits>
+#include <algorithm>
 
 
 namespace vispro
 {
 
-	Eigen::MatrixXd LineDistanceMetrics::Compute_Metric(const Lines5d& lines, const DistanceMetrics metric)
+	Eigen::MatrixXd LineDistanceMetrics::Compute_Metric(const Lines5d& lines, const DistanceMetrics metric, const double farDistance)
 	{
 		switch (metric)
 		{
 		case MeanL2:
 			return LineDistanceMetrics::Compute_Mean_L2_Naive(lines);
 		case rMCPD:
-			return LineDistanceMetrics::Compute_rMCPD(lines);
+			return LineDistanceMetrics::Compute_rMCPD(lines, rMCPDKdTreeMinLength, farDistance);
 		default:
 			return Eigen::MatrixXd();
 		}
@@ -30,6 +34,21 @@ namespace vispro
 		}
 	}
 
+	// mean distance of the vertices with the same index
+	static double MeanL2Distance(const Line5d& a, const Line5d& b)
+	{
+		double mean = 0;
+		int sum = 0;
+		for (size_t iv = 0; iv < std::min(a.size(), b.size()); ++iv)
+		{
+			mean += (a[iv] - b[iv]).norm();
+			sum += 1;
+		}
+		if (sum > 0)
+			mean /= sum;
+		return mean;
+	}
+
 	Eigen::MatrixXd LineDistanceMetrics::Compute_Mean_L2_Naive(const Lines5d& lines)
 	{
 		Eigen::MatrixXd distanceMatrix;
@@ -48,19 +67,7 @@ namespace vispro
 			// for every other line j
 			for (int j = i + 1; j < numLines; ++j)
 			{
-				double mean = 0;
-				int sum = 0;
-
-				// for each vertex of line i and j
-				const Line5d& line_j = lines[j];
-				for (size_t iv = 0; iv < std::min(line_i.size(), line_j.size()); ++iv)
-				{
-					double dist = (line_i[iv] - line_j[iv]).norm();
-					mean += dist;
-					sum += 1;
-				}
-				if (sum > 0)
-					mean /= sum;
+				double mean = MeanL2Distance(line_i, lines[j]);
 				distanceMatrix(i, j) = mean;
 				distanceMatrix(j, i) = mean;
 			}
@@ -68,8 +75,292 @@ namespace vispro
 		return distanceMatrix;
 	}
 	
+	typedef nanoflann::KDTreeSingleIndexAdaptor<nanoflann::L2_Simple_Adaptor<double, PointCloud5>, PointCloud5, 5, int> LineKdTree;
+
+	// mean distance of the vertices of line a to their closest vertex of line b
+	static double MeanClosestPoint(const Line5d& a, const LineKdTree& b)
+	{
+		double mean = 0;
+		for (const Eigen::Vector<double, 5>& vertex : a)
+		{
+			size_t index;
+			double distanceSquared;
+			nanoflann::KNNResultSet<double> resultSet(1);
+			resultSet.init(&index, &distanceSquared);
+			b.findNeighbors(resultSet, vertex.data(), nanoflann::SearchParameters());
+			mean += std::sqrt(distanceSquared);
+		}
+		return mean / a.size();
+	}
+
+	// every vertex of a has at least its distance to the bounding box of b to the closest vertex of b
+	static double MeanBoxDistance(const Line5d& a, const Eigen::AlignedBox<double, 5>& b)
+	{
+		double mean = 0;
+		for (const Eigen::Vector<double, 5>& vertex : a)
+		{
+			mean += std::sqrt(b.squaredExteriorDistance(vertex));
+		}
+		return mean / a.size();
+	}
+
+	// all lines in structure-of-arrays float32 layout, every component padded for the batch kernels
+	struct LineBlocks
+	{
+		LineBlocks(const Lines5d& lines)
+		{
+			std::vector<int64_t> offsets(lines.size() + 1, 0);
+			for (size_t id = 0; id < lines.size(); id++)
+			{
+				const int64_t padded = (lines[id].size() + LineDistanceBatch::padding - 1) / LineDistanceBatch::padding * LineDistanceBatch::padding;
+				offsets[id + 1] = offsets[id] + 5 * padded;
+			}
+			values.resize(offsets.back(), LineDistanceBatch::paddingValue);
+			blocks.resize(lines.size());
+			for (size_t id = 0; id < lines.size(); id++)
+			{
+				LineBlock& block = blocks[id];
+				block.count = lines[id].size();
+				block.paddedCount = (offsets[id + 1] - offsets[id]) / 5;
+				maxPaddedCount = std::max(maxPaddedCount, block.paddedCount);
+				for (int c = 0; c < 5; c++)
+				{
+					float* component = values.data() + offsets[id] + c * block.paddedCount;
+					for (size_t vertex = 0; vertex < lines[id].size(); vertex++)
+					{
+						component[vertex] = (float)lines[id][vertex][c];
+					}
+					block.values[c] = component;
+				}
+			}
+		}
+
+		std::vector<float> values;
+		std::vector<LineBlock> blocks;
+		int64_t maxPaddedCount = 0;
+	};
+
+	static std::vector<Eigen::AlignedBox<double, 5>> LineBoxes(const Lines5d& lines)
+	{
+		std::vector<Eigen::AlignedBox<double, 5>> boxes(lines.size());
+		for (size_t id = 0; id < lines.size(); id++)
+		{
+			for (const Eigen::Vector<double, 5>& vertex : lines[id])
+			{
+				boxes[id].extend(vertex);
+			}
+		}
+		return boxes;
+	}
+
+	// lower bound of the rMCPD of a pair: the box distance bounds both directions, the mean distance of the vertices to the other box is tighter
+	// the tighter bound is only computed if the box distance does not exceed threshold already
+	static double LowerBound(const Lines5d& lines, const std::vector<Eigen::AlignedBox<double, 5>>& boxes, const int64_t i, const int64_t j, const double threshold)
+	{
+		const double bound = boxes[i].exteriorDistance(boxes[j]);
+		if (bound > threshold)
+		{
+			return bound;
+		}
+		return std::min(MeanBoxDistance(lines[i], boxes[j]), MeanBoxDistance(lines[j], boxes[i]));
+	}
+
+	// exact rMCPD of single pairs: brute force kernel for short lines, kd-trees as soon as one line of a pair is longer than kdTreeMinLength
+	class rMCPDPairs
+	{
+	public:
+		rMCPDPairs(const Lines5d& lines, const size_t kdTreeMinLength) : mLines(lines), mBlocks(lines), mKdTreeMinLength(kdTreeMinLength), mTrees(lines.size())
+		{
+			// the trees reference the clouds -> no reallocation after this
+			bool longLines = false;
+			for (const Line5d& line : lines)
+			{
+				longLines |= line.size() > kdTreeMinLength;
+			}
+			if (!longLines)
+			{
+				return;
+			}
+			mClouds.reserve(lines.size());
+			for (const Line5d& line : lines)
+			{
+				mClouds.emplace_back(line);
+			}
+			#ifndef _DEBUG
+			#pragma omp parallel for schedule(dynamic)
+			#endif
+			for (int64_t id = 0; id < (int64_t)lines.size(); id++)
+			{
+				mTrees[id] = std::make_unique<LineKdTree>(5, mClouds[id], nanoflann::KDTreeSingleIndexAdaptorParams(10));
+				mTrees[id]->buildIndex();
+			}
+		}
+
+		// minA / minB: scratch with GetScratchSize() floats each
+		double Distance(const int64_t i, const int64_t j, float* minA, float* minB) const
+		{
+			if (mLines[i].size() > mKdTreeMinLength || mLines[j].size() > mKdTreeMinLength)
+			{
+				return std::min(MeanClosestPoint(mLines[i], *mTrees[j]), MeanClosestPoint(mLines[j], *mTrees[i]));
+			}
+
+			const LineBlock& a = mBlocks.blocks[i];
+			const LineBlock& b = mBlocks.blocks[j];
+			LineDistanceBatch::ClosestPoints(a, b, minA, minB);
+			double meanI = 0, meanJ = 0;
+			for (int64_t v = 0; v < a.count; v++) meanI += std::sqrt((double)minA[v]);
+			for (int64_t v = 0; v < b.count; v++) meanJ += std::sqrt((double)minB[v]);
+			return std::min(meanI / a.count, meanJ / b.count);
+		}
+
+		int64_t GetScratchSize() const { return mBlocks.maxPaddedCount; }
+
+	private:
+		const Lines5d& mLines;
+		const LineBlocks mBlocks;
+		const size_t mKdTreeMinLength;
+		std::vector<PointCloud5> mClouds;
+		std::vector<std::unique_ptr<LineKdTree>> mTrees;
+	};
+
+	// The matrix is processed in tiles of lines, so the blocks of both tiles stay in cache while their pairs are visited.
+	// Both directions of a pair come out of one sweep -> no second pass to take the minimum.
+	Eigen::MatrixXd LineDistanceMetrics::Compute_rMCPD(const Lines5d& lines, const size_t kdTreeMinLength, const double farDistance)
+	{
+		const int64_t numLines = lines.size();
+		Eigen::MatrixXd distanceMatrix = Eigen::MatrixXd::Zero(numLines, numLines);
+		const rMCPDPairs pairs(lines, kdTreeMinLength);
+		const std::vector<Eigen::AlignedBox<double, 5>> boxes = farDistance > 0.0 ? LineBoxes(lines) : std::vector<Eigen::AlignedBox<double, 5>>();
+
+		// upper triangle of the tile grid
+		const int64_t tileSize = 32;
+		const int64_t numTiles = (numLines + tileSize - 1) / tileSize;
+		std::vector<std::pair<int64_t, int64_t>> tiles;
+		for (int64_t ti = 0; ti < numTiles; ti++)
+		{
+			for (int64_t tj = ti; tj < numTiles; tj++)
+			{
+				tiles.emplace_back(ti, tj);
+			}
+		}
+
+		#ifndef _DEBUG
+		#pragma omp parallel
+		#endif
+		{
+			std::vector<float> minA(pairs.GetScratchSize()), minB(pairs.GetScratchSize());
+			#ifndef _DEBUG
+			#pragma omp for schedule(dynamic)
+			#endif
+			for (int64_t t = 0; t < (int64_t)tiles.size(); t++)
+			{
+				const int64_t iEnd = std::min((tiles[t].first + 1) * tileSize, numLines);
+				const int64_t jEnd = std::min((tiles[t].second + 1) * tileSize, numLines);
+				for (int64_t i = tiles[t].first * tileSize; i < iEnd; i++)
+				{
+					for (int64_t j = std::max(tiles[t].second * tileSize, i + 1); j < jEnd; j++)
+					{
+						double value = farDistance > 0.0 ? LowerBound(lines, boxes, i, j, farDistance) : 0.0;
+						if (value <= farDistance)
+						{
+							value = pairs.Distance(i, j, minA.data(), minB.data());
+						}
+						distanceMatrix(i, j) = value;
+						distanceMatrix(j, i) = value;
+					}
+				}
+			}
+		}
+		return distanceMatrix;
+	}
+
+	// Candidates are the lines with the closest centroids (kd-tree over the 5d vertex means). They are refined with the exact
+	// distance in the order of their lower bounds, a candidate whose bound exceeds the current k-th distance is skipped.
+	LineGraph LineDistanceMetrics::Compute_KNN(const Lines5d& lines, const DistanceMetrics metric, const uint32_t k, const uint32_t numCandidates)
+	{
+		LineGraph graph;
+		graph.numLines = lines.size();
+		graph.k = k;
+		graph.numCandidates = std::max(numCandidates, k);
+		graph.neighbors.assign(graph.numLines * k, LineGraph::noNeighbor);
+		graph.distances.assign(graph.numLines * k, std::numeric_limits<float>::infinity());
+		if (lines.size() < 2 || k == 0)
+		{
+			return graph;
+		}
+
+		Line5d centroids(lines.size(), Eigen::Vector<double, 5>::Zero());
+		for (size_t id = 0; id < lines.size(); id++)
+		{
+			for (const Eigen::Vector<double, 5>& vertex : lines[id])
+			{
+				centroids[id] += vertex;
+			}
+			centroids[id] /= std::max<size_t>(lines[id].size(), 1);
+		}
+		PointCloud5 centroidCloud(centroids);
+		LineKdTree centroidTree(5, centroidCloud, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+		centroidTree.buildIndex();
+
+		const std::vector<Eigen::AlignedBox<double, 5>> boxes = LineBoxes(lines);
+		std::unique_ptr<rMCPDPairs> pairs = metric == rMCPD ? std::make_unique<rMCPDPairs>(lines, rMCPDKdTreeMinLength) : nullptr;
+		const size_t numQueries = std::min<size_t>(graph.numCandidates + 1, lines.size());	// the line finds itself
+
+		#ifndef _DEBUG
+		#pragma omp parallel
+		#endif
+		{
+			std::vector<float> minA(pairs ? pairs->GetScratchSize() : 0), minB(pairs ? pairs->GetScratchSize() : 0);
+			std::vector<size_t> candidates(numQueries);
+			std::vector<double> candidateDistances(numQueries);
+			std::vector<std::pair<double, int64_t>> order;
+			std::vector<std::pair<double, int64_t>> nearest;
+			#ifndef _DEBUG
+			#pragma omp for schedule(dynamic, 64)
+			#endif
+			for (int64_t i = 0; i < (int64_t)lines.size(); i++)
+			{
+				nanoflann::KNNResultSet<double> resultSet(numQueries);
+				resultSet.init(candidates.data(), candidateDistances.data());
+				centroidTree.findNeighbors(resultSet, centroids[i].data(), nanoflann::SearchParameters());
+
+				// rMCPD: cheap lower bounds first, MeanL2 is evaluated right away
+				order.clear();
+				for (size_t c = 0; c < resultSet.size(); c++)
+				{
+					const int64_t j = candidates[c];
+					if (j == i) continue;
+					order.emplace_back(metric == rMCPD ? LowerBound(lines, boxes, i, j, std::numeric_limits<double>::infinity()) : MeanL2Distance(lines[i], lines[j]), j);
+				}
+				std::sort(order.begin(), order.end());
+
+				nearest.clear();
+				for (const std::pair<double, int64_t>& candidate : order)
+				{
+					if (nearest.size() == k && candidate.first >= nearest.back().first)
+					{
+						break;	// sorted by lower bound -> no remaining candidate can be closer
+					}
+					const double distance = metric == rMCPD ? pairs->Distance(i, candidate.second, minA.data(), minB.data()) : candidate.first;
+					if (nearest.size() < k || distance < nearest.back().first)
+					{
+						if (nearest.size() == k) nearest.pop_back();
+						nearest.insert(std::upper_bound(nearest.begin(), nearest.end(), std::make_pair(distance, candidate.second)), std::make_pair(distance, candidate.second));
+					}
+				}
+
+				for (size_t n = 0; n < nearest.size(); n++)
+				{
+					graph.neighbors[i * k + n] = (uint32_t)nearest[n].second;
+					graph.distances[i * k + n] = (float)nearest[n].first;
+				}
+			}
+		}
+		return graph;
+	}
+
 	// kdtree is just used to find closest point -> could also just linearly search through array but will be slower probably
-	Eigen::MatrixXd LineDistanceMetrics::Compute_rMCPD(const Lines5d& lines)
+	Eigen::MatrixXd LineDistanceMetrics::Compute_rMCPD_KdTree(const Lines5d& lines)
 	{
 		Eigen::MatrixXd distanceMatrix;
 
@@ -3,6 +3,7 @@
 #include <include/nanoflann.hpp>
 #include <omp.h>
 #include "ObjectReader.hpp"
+#include "LineGraph.hpp"
 
 
 enum DistanceMetrics {
@@ -20,9 +21,20 @@ namespace vispro
 	class LineDistanceMetrics
 	{
 	public:
-		static Eigen::MatrixXd Compute_Metric(const Lines5d& lines, const DistanceMetrics metric);
+		// farDistance > 0 -> pairs that are certainly further apart are not evaluated (rMCPD only, see Compute_rMCPD)
+		static Eigen::MatrixXd Compute_Metric(const Lines5d& lines, const DistanceMetrics metric, const double farDistance = 0.0);
 		static Eigen::MatrixXd Compute_Mean_L2_Naive(const Lines5d& lines);
-		static Eigen::MatrixXd Compute_rMCPD(const Lines5d& lines);
+		// brute force for short lines, kd-trees as soon as one line of a pair is longer than kdTreeMinLength
+		// farDistance > 0: pairs whose lower bound (bounding boxes of the lines) lies beyond farDistance store that lower bound
+		// instead of the exact distance -> every pair closer than farDistance stays exact, all others are reported as > farDistance
+		static Eigen::MatrixXd Compute_rMCPD(const Lines5d& lines, const size_t kdTreeMinLength = rMCPDKdTreeMinLength, const double farDistance = 0.0);
+		static Eigen::MatrixXd Compute_rMCPD_KdTree(const Lines5d& lines);
+		// sparse alternative to the matrices: the k closest lines of every line, O(N * k) memory
+		// the neighbors are searched among the numCandidates lines with the closest centroids
+		static LineGraph Compute_KNN(const Lines5d& lines, const DistanceMetrics metric, const uint32_t k, const uint32_t numCandidates);
+
+		// crossover of the brute force kernel and the kd-tree search (see CompareDistanceKernels in main.cpp)
+		static constexpr size_t rMCPDKdTreeMinLength = 4096;
 
 		static std::string ToString(const DistanceMetrics& metric);
 	private:
@@ -31,7 +43,7 @@ namespace vispro
 	struct PointCloud3
 	{
 		PointCloud3(const Line5d& line) : mLine(line) {}
-		const Line5d mLine;
+		const Line5d& mLine;
 
 		inline size_t kdtree_get_point_count() const 
 		{ 
@@ -67,7 +79,7 @@ namespace vispro
 	struct PointCloud5
 	{
 		PointCloud5(const Line5d& line) : mLine(line) {}
-		const Line5d mLine;
+		const Line5d& mLine;
 
 		inline size_t kdtree_get_point_count() const
 		{
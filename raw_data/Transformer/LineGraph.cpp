@@ -0,0 +1,40 @@
+#include "LineGraph.hpp"
+#include "mappedfile.hpp"
+#include <cstring>
+
+namespace vispro
+{
+	static const uint64_t lineGraphAlignment = 64;
+
+	static uint64_t AlignOffset(const uint64_t offset)
+	{
+		return (offset + lineGraphAlignment - 1) / lineGraphAlignment * lineGraphAlignment;
+	}
+
+	bool LineGraphWriter::WriteLineGraph(const char* filename, const LineGraph& graph, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized)
+	{
+		const uint64_t numEntries = graph.numLines * graph.k;
+		if (numEntries == 0 || graph.neighbors.size() != numEntries || graph.distances.size() != numEntries) return false;
+
+		LineGraphHeader header = {};
+		std::memcpy(header.magic, LINEGRAPH_MAGIC, sizeof(LINEGRAPH_MAGIC));
+		header.version = LINEGRAPH_VERSION;
+		header.k = graph.k;
+		header.numLines = graph.numLines;
+		std::strncpy(header.metric, metric.c_str(), sizeof(header.metric) - 1);
+		header.importanceWeight = importanceWeight;
+		header.scalarColorWeight = scalarColorWeight;
+		header.normalized = normalized ? 1 : 0;
+		header.numCandidates = graph.numCandidates;
+		header.neighborsOffset = AlignOffset(sizeof(LineGraphHeader));
+		header.distancesOffset = AlignOffset(header.neighborsOffset + numEntries * sizeof(uint32_t));
+
+		MappedFile file;
+		if (!file.Create(filename, header.distancesOffset + numEntries * sizeof(float))) return false;
+		std::memcpy(file.GetData(), &header, sizeof(header));
+		std::memcpy(file.GetData() + header.neighborsOffset, graph.neighbors.data(), numEntries * sizeof(uint32_t));
+		std::memcpy(file.GetData() + header.distancesOffset, graph.distances.data(), numEntries * sizeof(float));
+		file.Close();
+		return true;
+	}
+}
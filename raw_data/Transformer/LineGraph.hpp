@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "linegraphformat.hpp"
+
+namespace vispro
+{
+	struct LineGraph
+	{
+		static constexpr uint32_t noNeighbor = LINEGRAPH_NO_NEIGHBOR;
+
+		uint64_t numLines = 0;
+		uint32_t k = 0;
+		uint32_t numCandidates = 0;
+		std::vector<uint32_t> neighbors;	// numLines * k
+		std::vector<float> distances;		// numLines * k
+	};
+
+	class LineGraphWriter
+	{
+	public:
+		// Writes the graph through a writable mapping of the file.
+		static bool WriteLineGraph(const char* filename, const LineGraph& graph, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized);
+	};
+}
@@ -0,0 +1,183 @@
+#include "LineSet.hpp"
+#include "mappedfile.hpp"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace vispro
+{
+	static const uint64_t lineSetAlignment = 64;
+
+	static uint64_t AlignOffset(const uint64_t offset)
+	{
+		return (offset + lineSetAlignment - 1) / lineSetAlignment * lineSetAlignment;
+	}
+
+	bool LineSetView::Open(const char* path)
+	{
+		std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+		if (!file->Open(path) || file->GetSize() < sizeof(LineSetHeader)) return false;
+
+		const char* data = file->GetData();
+		const uint64_t size = file->GetSize();
+		const LineSetHeader* header = (const LineSetHeader*)data;
+		if (std::memcmp(header->magic, LINESET_MAGIC, sizeof(LINESET_MAGIC)) != 0 || header->version != LINESET_VERSION) return false;
+		if (header->numLines >= size / sizeof(uint64_t) || header->numVertices > size / (3 * sizeof(float)) || header->lineOffsetsOffset > size || header->positionsOffset > size) return false;
+
+		// every block has to lie inside of the file
+		const uint64_t propertiesEnd = sizeof(LineSetHeader) + header->numProperties * sizeof(LineSetProperty);
+		const uint64_t offsetsEnd = header->lineOffsetsOffset + (header->numLines + 1) * sizeof(uint64_t);
+		const uint64_t positionsEnd = header->positionsOffset + header->numVertices * 3 * sizeof(float);
+		if (propertiesEnd > size || offsetsEnd > size || positionsEnd > size) return false;
+		const LineSetProperty* properties = (const LineSetProperty*)(data + sizeof(LineSetHeader));
+		for (uint32_t p = 0; p < header->numProperties; p++)
+		{
+			if (properties[p].valuesOffset > size || properties[p].valuesOffset + header->numVertices * sizeof(float) > size) return false;
+			// FindProperty compares the names as c strings
+			if (std::memchr(properties[p].name, '\0', sizeof(properties[p].name)) == nullptr) return false;
+		}
+
+		// the lines have to cover the vertices in order
+		const uint64_t* lineOffsets = (const uint64_t*)(data + header->lineOffsetsOffset);
+		for (uint64_t line = 0; line < header->numLines; line++)
+		{
+			if (lineOffsets[line] > lineOffsets[line + 1]) return false;
+		}
+		if (lineOffsets[header->numLines] != header->numVertices) return false;
+
+		mFile = file;
+		mHeader = header;
+		mProperties = properties;
+		mLineOffsets = lineOffsets;
+		mPositions = (const float*)(data + header->positionsOffset);
+		return true;
+	}
+
+	const float* LineSetView::FindProperty(const std::string& name) const
+	{
+		for (uint32_t p = 0; p < mHeader->numProperties; p++)
+		{
+			if (name == mProperties[p].name)
+			{
+				return (const float*)(mFile->GetData() + mProperties[p].valuesOffset);
+			}
+		}
+		return nullptr;
+	}
+
+	bool LineSetWriter::WriteLineSet(const char* filename, const std::vector<Line>& lines, const std::vector<std::string>& propertyNames, const std::vector<const std::vector<std::vector<double>>*>& propertyValues)
+	{
+		// line offsets
+		std::vector<uint64_t> lineOffsets(lines.size() + 1, 0);
+		for (size_t id = 0; id < lines.size(); id++)
+		{
+			lineOffsets[id + 1] = lineOffsets[id] + lines[id].size();
+		}
+		const uint64_t numVertices = lineOffsets.back();
+
+		// block layout
+		LineSetHeader header = {};
+		std::memcpy(header.magic, LINESET_MAGIC, sizeof(LINESET_MAGIC));
+		header.version = LINESET_VERSION;
+		header.numProperties = (uint32_t)propertyNames.size();
+		header.numLines = lines.size();
+		header.numVertices = numVertices;
+		header.lineOffsetsOffset = AlignOffset(sizeof(LineSetHeader) + propertyNames.size() * sizeof(LineSetProperty));
+		header.positionsOffset = AlignOffset(header.lineOffsetsOffset + lineOffsets.size() * sizeof(uint64_t));
+
+		std::vector<LineSetProperty> properties(propertyNames.size());
+		uint64_t offset = AlignOffset(header.positionsOffset + numVertices * 3 * sizeof(float));
+		for (size_t p = 0; p < properties.size(); p++)
+		{
+			std::memset(&properties[p], 0, sizeof(LineSetProperty));
+			std::strncpy(properties[p].name, propertyNames[p].c_str(), sizeof(properties[p].name) - 1);
+			properties[p].valuesOffset = offset;
+			offset = AlignOffset(offset + numVertices * sizeof(float));
+		}
+
+		// flatten positions and values
+		std::vector<float> positions(numVertices * 3);
+		std::vector<std::vector<float>> values(propertyValues.size(), std::vector<float>(numVertices));
+		#ifndef _DEBUG
+		#pragma omp parallel for
+		#endif
+		for (int64_t id = 0; id < (int64_t)lines.size(); id++)
+		{
+			for (size_t point = 0; point < lines[id].size(); point++)
+			{
+				const uint64_t vertex = lineOffsets[id] + point;
+				positions[vertex * 3 + 0] = (float)lines[id][point][0];
+				positions[vertex * 3 + 1] = (float)lines[id][point][1];
+				positions[vertex * 3 + 2] = (float)lines[id][point][2];
+				for (size_t p = 0; p < propertyValues.size(); p++)
+				{
+					values[p][vertex] = (float)(*propertyValues[p])[id][point];
+				}
+			}
+		}
+		for (size_t p = 0; p < properties.size(); p++)
+		{
+			auto range = std::minmax_element(values[p].begin(), values[p].end());
+			properties[p].min = range.first != values[p].end() ? *range.first : 0.0f;
+			properties[p].max = range.second != values[p].end() ? *range.second : 0.0f;
+		}
+
+		std::ofstream file(filename, std::ios::out | std::ios::binary);
+		if (!file.is_open()) return false;
+		auto writeAt = [&file](const uint64_t position, const void* data, const uint64_t size)
+		{
+			static const char padding[lineSetAlignment] = {};
+			const uint64_t current = (uint64_t)file.tellp();
+			file.write(padding, position - current);
+			file.write((const char*)data, size);
+		};
+		writeAt(0, &header, sizeof(header));
+		writeAt(sizeof(header), properties.data(), properties.size() * sizeof(LineSetProperty));
+		writeAt(header.lineOffsetsOffset, lineOffsets.data(), lineOffsets.size() * sizeof(uint64_t));
+		writeAt(header.positionsOffset, positions.data(), positions.size() * sizeof(float));
+		for (size_t p = 0; p < properties.size(); p++)
+		{
+			writeAt(properties[p].valuesOffset, values[p].data(), values[p].size() * sizeof(float));
+		}
+		return file.good();
+	}
+
+	Lines5d LineSetReader::ReadLineSet(const std::string& path, const std::string& importance, const std::string& scalarColor)
+	{
+		Lines5d lines;
+		LineSetView view;
+		if (!view.Open(path.c_str()) || view.GetNumProperties() == 0)
+		{
+			return lines;
+		}
+
+		const float* importances = view.FindProperty(importance);
+		if (!importances)
+		{
+			importances = view.FindProperty(view.GetProperty(0).name);
+		}
+		const float* scalarColors = view.FindProperty(scalarColor);
+		if (!scalarColors)
+		{
+			scalarColors = importances;
+		}
+
+		const uint64_t* lineOffsets = view.GetLineOffsets();
+		const float* positions = view.GetPositions();
+		lines.resize(view.GetNumLines());
+		#ifndef _DEBUG
+		#pragma omp parallel for
+		#endif
+		for (int64_t id = 0; id < (int64_t)lines.size(); id++)
+		{
+			Line5d& line = lines[id];
+			line.resize(lineOffsets[id + 1] - lineOffsets[id]);
+			for (size_t point = 0; point < line.size(); point++)
+			{
+				const uint64_t vertex = lineOffsets[id] + point;
+				line[point] = Eigen::Vector<double, 5>(positions[vertex * 3 + 0], positions[vertex * 3 + 1], positions[vertex * 3 + 2], importances[vertex], scalarColors[vertex]);
+			}
+		}
+		return lines;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <Eigen/Eigen>
+#include "ObjectReader.hpp"
+#include "linesetformat.hpp"
+
+typedef std::vector<Eigen::Vector3d> Line;
+
+class MappedFile;
+
+namespace vispro
+{
+	// Read-only view onto a memory mapped line set.
+	class LineSetView
+	{
+	public:
+		bool Open(const char* path);
+
+		uint64_t GetNumLines() const { return mHeader->numLines; }
+		uint64_t GetNumVertices() const { return mHeader->numVertices; }
+		const uint64_t* GetLineOffsets() const { return mLineOffsets; }
+		const float* GetPositions() const { return mPositions; }
+
+		uint32_t GetNumProperties() const { return mHeader->numProperties; }
+		const LineSetProperty& GetProperty(const uint32_t index) const { return mProperties[index]; }
+		// Values of a property, nullptr if the line set does not contain it.
+		const float* FindProperty(const std::string& name) const;
+
+	private:
+		std::shared_ptr<MappedFile> mFile;
+		const LineSetHeader* mHeader = nullptr;
+		const LineSetProperty* mProperties = nullptr;
+		const uint64_t* mLineOffsets = nullptr;
+		const float* mPositions = nullptr;
+	};
+
+	class LineSetWriter
+	{
+	public:
+		// Writes the lines and one value block per property. Every property holds one value per vertex.
+		static bool WriteLineSet(const char* filename, const std::vector<Line>& lines, const std::vector<std::string>& propertyNames, const std::vector<const std::vector<std::vector<double>>*>& propertyValues);
+	};
+
+	class LineSetReader
+	{
+	public:
+		// Reads the lines with two properties in the layout of ObjectReader::ReadObject.
+		// An empty or unknown importance falls back to the first property, a missing scalarColor to the importance.
+		static Lines5d ReadLineSet(const std::string& path, const std::string& importance, const std::string& scalarColor);
+	};
+}
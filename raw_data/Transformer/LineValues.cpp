@@ -3,18 +3,18 @@
 namespace vispro
 {
 
-	LineValue LineProperties::CalculateLineProperty(const LineProperty property, const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField = NULL, const float stepSize = 0.f)
+	LineValue LineProperties::CalculateLineProperty(const LineProperty property, const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize, const JacobianFields* jacobianFields)
 	{
 		switch (property)
 		{
 		case lineLength:
 			return LineProperties::CalculateLineLength(lines);
 		case curvature:
-			return LineProperties::CalculateCurvature(lines, velocityField, stepSize);
+			return LineProperties::CalculateCurvature(lines, velocityField, stepSize, jacobianFields ? jacobianFields->acceleration : NULL);
 		case velocity:
 			return LineProperties::CalculateVelocity(lines, velocityField);
 		case vorticity:
-			return LineProperties::CalculateVorticity(lines, velocityField);
+			return LineProperties::CalculateVorticity(lines, velocityField, jacobianFields ? jacobianFields->vorticity : NULL);
 		default:
 			return LineValue ({}, 0.f, 0.f);
 		}
@@ -62,42 +62,60 @@ namespace vispro
 	
 	// vector field = first derivative
 	// acceleration field = second derivative
-	LineValue LineProperties::CalculateCurvature(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize)
+	// without a precomputed acceleration field the acceleration is evaluated at the vertices -> all threads share the cache of the touched nodes
+	LineValue LineProperties::CalculateCurvature(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize, vtkSmartPointer<vtkImageData> accelerationField)
 	{
-		const vtkSmartPointer<vtkImageData>& accelerationField = Acceleration::Compute(velocityField);
+		const FieldSampler velocitySampler(velocityField, "velocity");
+		std::unique_ptr<FieldSampler> accelerationSampler;
+		std::unique_ptr<DerivativeSampler> derivatives;
+		if (accelerationField)
+		{
+			accelerationSampler.reset(new FieldSampler(accelerationField, "acceleration"));
+		}
+		else
+		{
+			derivatives.reset(new DerivativeSampler(velocitySampler, DerivativeQuantity::Acceleration));
+		}
 		double maxValue = -DBL_MAX;
 		double minValue = DBL_MAX;
 		std::vector<std::vector<double>> values(lines.size());
 		#ifndef _DEBUG
-		#pragma omp parallel for
+		#pragma omp parallel
 		#endif
-		for (long id = 0; id < lines.size(); id++)
 		{
-			std::vector<double> lineValue(lines[id].size());
-			for (unsigned point = 0; point < lines[id].size(); point++)
+			DerivativeSampler::Cursor cursor;
+			#ifndef _DEBUG
+			#pragma omp for
+			#endif
+			for (long id = 0; id < lines.size(); id++)
 			{
-				Eigen::Vector3d firstDerivative = Sampling::LinearSample3(lines[id][point], velocityField);
-				Eigen::Vector3d secondDerivative = Sampling::LinearSample3(lines[id][point], accelerationField);
-
-				double numerator = (firstDerivative.cross(secondDerivative)).norm();
-				double denominator = pow(firstDerivative.norm(), 3.0);
-				double curvature = 0;
-				if (denominator != 0)
+				std::vector<double> lineValue(lines[id].size());
+				for (unsigned point = 0; point < lines[id].size(); point++)
 				{
-					curvature = numerator / denominator;
+					Eigen::Vector3d firstDerivative = velocitySampler.Sample3(lines[id][point]);
+					Eigen::Vector3d secondDerivative = accelerationSampler ? accelerationSampler->Sample3(lines[id][point]) : derivatives->SampleAcceleration(lines[id][point], cursor);
+
+					double numerator = (firstDerivative.cross(secondDerivative)).norm();
+					double denominator = pow(firstDerivative.norm(), 3.0);
+					double curvature = 0;
+					if (denominator != 0)
+					{
+						curvature = numerator / denominator;
+					}
+				
+					lineValue[point] = curvature;
+					maxValue = std::max(maxValue, curvature);
+					minValue = std::min(minValue, curvature);
 				}
-			
-				lineValue[point] = curvature;
-				maxValue = std::max(maxValue, curvature);
-				minValue = std::min(minValue, curvature);
+				values[id] = lineValue;
 			}
-			values[id] = lineValue;
 		}
 		return LineValue(values, maxValue, minValue);
 	}
 
 	LineValue LineProperties::CalculateVelocity(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField)
 	{
+		const FieldSampler velocitySampler(velocityField, "velocity");
 		double maxVelocity = -DBL_MAX;
 		double minVelocity = DBL_MAX;
 		std::vector<std::vector<double>> velocity(lines.size());
@@ -109,7 +127,7 @@ namespace vispro
 			std::vector<double> lineVelocity(lines[id].size());
 			for (unsigned point = 0; point < lines[id].size(); point++)
 			{
-				Eigen::Vector3d sample = Sampling::LinearSample3(lines[id][point], velocityField.GetPointer());
+				Eigen::Vector3d sample = velocitySampler.Sample3(lines[id][point]);
 				double magnitute = sample.norm();
 				maxVelocity = std::max(maxVelocity, magnitute);
 				minVelocity = std::min(minVelocity, magnitute);
@@ -120,27 +138,43 @@ namespace vispro
 		return LineValue(velocity, maxVelocity, minVelocity);
 	}
 
-	LineValue LineProperties::CalculateVorticity(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField)
+	LineValue LineProperties::CalculateVorticity(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, vtkSmartPointer<vtkImageData> vorticityField)
 	{
-		vtkSmartPointer<vtkImageData> vorticityField = Vorticity::Compute(velocityField);
+		const FieldSampler velocitySampler(velocityField, "velocity");
+		std::unique_ptr<FieldSampler> vorticitySampler;
+		std::unique_ptr<DerivativeSampler> derivatives;
+		if (vorticityField)
+		{
+			vorticitySampler.reset(new FieldSampler(vorticityField, "vorticity"));
+		}
+		else
+		{
+			derivatives.reset(new DerivativeSampler(velocitySampler, DerivativeQuantity::Vorticity));
+		}
 
 		double maxValue = -DBL_MAX;
 		double minValue = DBL_MAX;
 		std::vector<std::vector<double>> values(lines.size());
 		#ifndef _DEBUG
-		#pragma omp parallel for
+		#pragma omp parallel
 		#endif
-		for (long id = 0; id < lines.size(); id++)
 		{
-			std::vector<double> lineValue(lines[id].size());
-			for (unsigned point = 0; point < lines[id].size(); point++)
+			DerivativeSampler::Cursor cursor;
+			#ifndef _DEBUG
+			#pragma omp for
+			#endif
+			for (long id = 0; id < lines.size(); id++)
 			{
-				double sample = Sampling::LinearSample1(lines[id][point], vorticityField.GetPointer());
-				maxValue = std::max(maxValue, sample);
-				minValue = std::min(minValue, sample);
-				lineValue[point] = sample;
+				std::vector<double> lineValue(lines[id].size());
+				for (unsigned point = 0; point < lines[id].size(); point++)
+				{
+					double sample = vorticitySampler ? vorticitySampler->Sample1(lines[id][point]) : derivatives->SampleVorticity(lines[id][point], cursor);
+					maxValue = std::max(maxValue, sample);
+					minValue = std::min(minValue, sample);
+					lineValue[point] = sample;
+				}
+				values[id] = lineValue;
 			}
-			values[id] = lineValue;
 		}
 		return LineValue(values, maxValue, minValue);
 	}
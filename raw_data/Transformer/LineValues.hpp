@@ -13,6 +13,8 @@
 #include "LineValues.hpp"
 #include "Vorticity.hpp"
 #include "Acceleration.hpp"
+#include "Jacobian.hpp"
+#include "DerivativeSampler.hpp"
 
 class vtkImageData;
 class vtkFloatArray;
@@ -47,11 +49,12 @@ namespace vispro
 	class LineProperties
 	{
 	public:
-		static LineValue CalculateLineProperty(const LineProperty property, const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize);
+		// jacobianFields: vorticity and acceleration computed beforehand -> nullptr evaluates them at the line vertices
+		static LineValue CalculateLineProperty(const LineProperty property, const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize, const JacobianFields* jacobianFields = nullptr);
 		static LineValue CalculateLineLength(const std::vector<Line>& lines);
-		static LineValue CalculateCurvature(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize);
+		static LineValue CalculateCurvature(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const float stepSize, vtkSmartPointer<vtkImageData> accelerationField = NULL);
 		static LineValue CalculateVelocity(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField);
-		static LineValue CalculateVorticity(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField);
+		static LineValue CalculateVorticity(const std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, vtkSmartPointer<vtkImageData> vorticityField = NULL);
 		static void NormalizeValues(LineValue& lineValue);
 		static void RobustScalar(LineValue& lineValue);
 		static void ClampValues(LineValue& lineValue);
@@ -1,4 +1,5 @@
 #include "Normalize.hpp"
+#include "Sampling.hpp"
 
 
 namespace vispro
@@ -22,12 +23,12 @@ namespace vispro
 	// returns the magnitude of the longest vector
 	double Normalize::InverseMaximumMagnitude(const vtkSmartPointer<vtkImageData>& velocityField)
 	{
-		vtkFloatArray* velocityArray = dynamic_cast<vtkFloatArray*>(velocityField->GetPointData()->GetArray("velocity"));
-		int64_t numPoints = (int64_t)velocityField->GetDimensions()[0] * velocityField->GetDimensions()[1] * velocityField->GetDimensions()[2];
+		const FieldSampler velocityArray(velocityField, "velocity");
+		int64_t numPoints = velocityArray.GetNumPoints();
 		double maxValue = -DBL_MAX;
-		for (int idx = 0; idx < numPoints; ++idx)
+		for (int64_t idx = 0; idx < numPoints; ++idx)
 		{
-			Eigen::Vector3d velocity(velocityArray->GetTuple3(idx));
+			Eigen::Vector3d velocity(velocityArray.Value3(idx));
 			double magnitude = velocity.norm();
 			maxValue = std::max(magnitude, maxValue);
 		}
@@ -5,6 +5,8 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdint>
+#include "objectformat.hpp"
 
 
 typedef std::vector<Eigen::Vector<double, 5>> Line5d;
@@ -19,10 +21,15 @@ struct Range {
 
 namespace vispro
 {
+	// All lines of an OBJ file in one contiguous store, the vertices of line i are lineOffsets[i] .. lineOffsets[i + 1] - 1
+	typedef ObjectLines ObjectData;
+
 	class ObjectReader
 	{
 	public:
 		static Lines5d ReadObject(const std::string& path);
+		// Maps the file and parses v / vt / l records of independent chunks in parallel (format/objectformat.hpp, shared with the viewer).
+		static bool ReadObjectData(const std::string& path, ObjectData& object);
 	private:
 	};
-}
\ No newline at end of file
+}
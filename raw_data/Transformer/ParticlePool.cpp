@@ -0,0 +1,118 @@
+#include "ParticlePool.hpp"
+#include <omp.h>
+#include <algorithm>
+
+namespace vispro
+{
+	// particles per compaction chunk -> every chunk is counted and scattered by one thread
+	static const int64_t chunkSize = 4096;
+
+	void ParticlePool::Seed(const std::vector<Eigen::Vector3d>& positions, const std::vector<unsigned>& ids)
+	{
+		const int64_t numParticles = (int64_t)positions.size();
+		mX.resize(numParticles);
+		mY.resize(numParticles);
+		mZ.resize(numParticles);
+		mId.resize(numParticles);
+		mPathLength.assign(numParticles, 0.0);
+		mAlive.assign(numParticles, 1);
+		for (Array<double>& state : mIntegratorState)
+		{
+			state.clear();
+		}
+		for (int64_t i = 0; i < numParticles; i++)
+		{
+			mX[i] = positions[i].x();
+			mY[i] = positions[i].y();
+			mZ[i] = positions[i].z();
+			mId[i] = ids[i];
+		}
+	}
+
+	void ParticlePool::EnableIntegratorState(const double initialStepSize)
+	{
+		const int64_t numParticles = Size();
+		for (Array<double>& state : mIntegratorState)
+		{
+			state.assign(numParticles, 0.0);
+		}
+		mIntegratorState[StateX] = mX;
+		mIntegratorState[StateY] = mY;
+		mIntegratorState[StateZ] = mZ;
+		mIntegratorState[StepSize].assign(numParticles, initialStepSize);
+	}
+
+	int64_t ParticlePool::Compact()
+	{
+		const int64_t numParticles = Size();
+		const int64_t numChunks = (numParticles + chunkSize - 1) / chunkSize;
+
+		// count the alive particles of every chunk
+		mChunkOffsets.assign(numChunks + 1, 0);
+		#ifndef _DEBUG
+		#pragma omp parallel for
+		#endif
+		for (int64_t chunk = 0; chunk < numChunks; chunk++)
+		{
+			const int64_t begin = chunk * chunkSize;
+			const int64_t end = std::min(begin + chunkSize, numParticles);
+			int64_t numAlive = 0;
+			for (int64_t i = begin; i < end; i++)
+			{
+				numAlive += mAlive[i] != 0;
+			}
+			mChunkOffsets[chunk + 1] = numAlive;
+		}
+
+		// exclusive prefix sum -> first output slot of every chunk
+		for (int64_t chunk = 0; chunk < numChunks; chunk++)
+		{
+			mChunkOffsets[chunk + 1] += mChunkOffsets[chunk];
+		}
+		const int64_t numAlive = mChunkOffsets[numChunks];
+		if (numAlive == numParticles)
+		{
+			return numParticles;
+		}
+
+		Scatter(mX, mScratchDouble, mChunkOffsets, numAlive);
+		Scatter(mY, mScratchDouble, mChunkOffsets, numAlive);
+		Scatter(mZ, mScratchDouble, mChunkOffsets, numAlive);
+		Scatter(mPathLength, mScratchDouble, mChunkOffsets, numAlive);
+		Scatter(mId, mScratchUnsigned, mChunkOffsets, numAlive);
+		for (Array<double>& state : mIntegratorState)
+		{
+			if (!state.empty())
+			{
+				Scatter(state, mScratchDouble, mChunkOffsets, numAlive);
+			}
+		}
+		mAlive.assign(numAlive, 1);
+		return numAlive;
+	}
+
+	template <typename T>
+	void ParticlePool::Scatter(Array<T>& source, Array<T>& destination, const std::vector<int64_t>& offsets, const int64_t numAlive)
+	{
+		const int64_t numParticles = (int64_t)source.size();
+		const int64_t numChunks = (int64_t)offsets.size() - 1;
+		destination.resize(numAlive);
+		#ifndef _DEBUG
+		#pragma omp parallel for
+		#endif
+		for (int64_t chunk = 0; chunk < numChunks; chunk++)
+		{
+			const int64_t begin = chunk * chunkSize;
+			const int64_t end = std::min(begin + chunkSize, numParticles);
+			int64_t out = offsets[chunk];
+			for (int64_t i = begin; i < end; i++)
+			{
+				if (mAlive[i])
+				{
+					destination[out++] = source[i];
+				}
+			}
+		}
+		source.swap(destination);	// the old attribute array becomes the scratch memory of the next attribute
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <Eigen/Eigen>
+
+namespace vispro
+{
+	// Contiguous range of particle positions handed to the integrator.
+	struct ParticleSpan
+	{
+		double* x;
+		double* y;
+		double* z;
+		int64_t count;
+	};
+
+	// Particle state of the tracer in structure-of-arrays layout.
+	// Every attribute lives in its own aligned array, so the integrator can stream over the positions
+	// and dead particles are removed by a parallel, order preserving stream compaction.
+	class ParticlePool
+	{
+	public:
+		template <typename T>
+		using Array = std::vector<T, Eigen::aligned_allocator<T>>;
+
+		// Additional per particle state of the adaptive integrator.
+		// The positions of the pool are the vertices written to the lines, the integrator state runs ahead of them.
+		enum IntegratorState
+		{
+			StateX, StateY, StateZ,								// position at Time
+			DerivativeX, DerivativeY, DerivativeZ,				// velocity at the state position -> first stage of the next step
+			Time,												// integration time of the state
+			StepSize,											// proposed size of the next step
+			IntervalBegin, IntervalLength,						// time interval of the last accepted step -> 0 length = particle does not move
+			DenseCoefficients,									// 5 * xyz coefficients of the dense output polynomial
+			NumIntegratorStates = DenseCoefficients + 15,
+		};
+
+		// Fills the pool with the seed positions. All particles start alive with an empty path.
+		void Seed(const std::vector<Eigen::Vector3d>& positions, const std::vector<unsigned>& ids);
+
+		// Removes all particles whose alive flag is 0. The relative order of the survivors is kept.
+		// Returns the number of remaining particles.
+		int64_t Compact();
+
+		// Allocates the integrator state and starts it at the current positions.
+		void EnableIntegratorState(const double initialStepSize);
+		inline double* State(const int attribute) { return mIntegratorState[attribute].data(); }
+
+		inline int64_t Size() const { return (int64_t)mX.size(); }
+
+		inline Eigen::Vector3d Position(const int64_t i) const { return Eigen::Vector3d(mX[i], mY[i], mZ[i]); }
+
+		// Positions [begin, begin + count).
+		inline ParticleSpan Span(const int64_t begin, const int64_t count) { return { mX.data() + begin, mY.data() + begin, mZ.data() + begin, count }; }
+		inline ParticleSpan Span() { return Span(0, Size()); }
+
+		Array<double>& X() { return mX; }
+		Array<double>& Y() { return mY; }
+		Array<double>& Z() { return mZ; }
+		Array<unsigned>& Id() { return mId; }
+		Array<double>& PathLength() { return mPathLength; }
+		Array<uint8_t>& Alive() { return mAlive; }
+
+	private:
+		// Moves the alive entries of source to destination. offsets holds the exclusive prefix sum of the alive counts per chunk.
+		template <typename T>
+		void Scatter(Array<T>& source, Array<T>& destination, const std::vector<int64_t>& offsets, const int64_t numAlive);
+
+		Array<double> mX;
+		Array<double> mY;
+		Array<double> mZ;
+		Array<unsigned> mId;
+		Array<double> mPathLength;
+		Array<uint8_t> mAlive;
+		Array<double> mIntegratorState[NumIntegratorStates];	// empty unless enabled
+
+		// scratch memory of the compaction -> swapped with the attribute arrays
+		Array<double> mScratchDouble;
+		Array<unsigned> mScratchUnsigned;
+		std::vector<int64_t> mChunkOffsets;
+	};
+}
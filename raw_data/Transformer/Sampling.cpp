@@ -5,47 +5,45 @@
 
 namespace vispro
 {
+	FieldSampler::FieldSampler(vtkImageData* field, const char* arrayName)
+	{
+		vtkFloatArray* values = dynamic_cast<vtkFloatArray*>(field->GetPointData()->GetArray(arrayName));
+		*this = FieldSampler(values->GetPointer(0), values->GetNumberOfComponents(), Eigen::Vector3i(field->GetDimensions()), Eigen::Vector3d(field->GetOrigin()), Eigen::Vector3d(field->GetSpacing()));
+	}
+
+	FieldSampler::FieldSampler(const float* data, const int numComponents, const Eigen::Vector3i& dimensions, const Eigen::Vector3d& origin, const Eigen::Vector3d& spacing)
+	{
+		mData = data;
+		mNumComponents = numComponents;
+		mDimensions = dimensions;
+		mMaxIndex = mDimensions - Eigen::Vector3i(1, 1, 1);
+		mStrideY = mDimensions.x();
+		mStrideZ = (int64_t)mDimensions.x() * mDimensions.y();
+		mOrigin = origin;
+		mSpacing = spacing;
+		mInverseSpacing = mSpacing.cwiseInverse();
+	}
+
+	GridView FieldSampler::GetGridView() const
+	{
+		GridView grid;
+		grid.data = mData;
+		grid.strideY = mStrideY;
+		grid.strideZ = mStrideZ;
+		for (int d = 0; d < 3; d++)
+		{
+			grid.maxIndex[d] = mMaxIndex[d];
+			grid.origin[d] = mOrigin[d];
+			grid.spacing[d] = mSpacing[d];
+		}
+		return grid;
+	}
+
 	double Sampling::LinearSample1(const Eigen::Vector3d& position, vtkImageData* field) {
-		Eigen::Vector3d origin(field->GetOrigin());
-		Eigen::Vector3d spacing(field->GetSpacing());
-		Eigen::Vector3i dimensions(field->GetDimensions());
-		Eigen::Vector3d relative = (position - origin).cwiseQuotient(spacing);
-		Eigen::Vector3i sample0 = relative.cast<int>();
-		Eigen::Vector3i sample1 = sample0 + Eigen::Vector3i(1, 1, 1);
-		sample0 = sample0.cwiseMax(Eigen::Vector3i(0, 0, 0)).cwiseMin(dimensions - Eigen::Vector3i(1, 1, 1));
-		sample1 = sample1.cwiseMax(Eigen::Vector3i(0, 0, 0)).cwiseMin(dimensions - Eigen::Vector3i(1, 1, 1));
-		Eigen::Vector3d interp = relative - sample0.cast<double>();
-		vtkFloatArray* vectors = dynamic_cast<vtkFloatArray*>(field->GetPointData()->GetAbstractArray(0));
-		return
-			(1 - interp.z()) * (1 - interp.y()) * (1 - interp.x()) * vectors->GetTuple1(((int64_t)sample0.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample0.x())
-			+ (1 - interp.z()) * (1 - interp.y()) * (interp.x()) * vectors->GetTuple1(((int64_t)sample0.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample1.x())
-			+ (1 - interp.z()) * (interp.y()) * (1 - interp.x()) * vectors->GetTuple1(((int64_t)sample0.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample0.x())
-			+ (1 - interp.z()) * (interp.y()) * (interp.x()) * vectors->GetTuple1(((int64_t)sample0.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample1.x())
-			+ (interp.z()) * (1 - interp.y()) * (1 - interp.x()) * vectors->GetTuple1(((int64_t)sample1.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample0.x())
-			+ (interp.z()) * (1 - interp.y()) * (interp.x()) * vectors->GetTuple1(((int64_t)sample1.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample1.x())
-			+ (interp.z()) * (interp.y()) * (1 - interp.x()) * vectors->GetTuple1(((int64_t)sample1.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample0.x())
-			+ (interp.z()) * (interp.y()) * (interp.x()) * vectors->GetTuple1(((int64_t)sample1.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample1.x());
+		return FieldSampler(field, field->GetPointData()->GetAbstractArray(0)->GetName()).Sample1(position);
 	}
 
 	Eigen::Vector3d Sampling::LinearSample3(const Eigen::Vector3d& position, vtkImageData* field) {
-		Eigen::Vector3d origin(field->GetOrigin());
-		Eigen::Vector3d spacing(field->GetSpacing());
-		Eigen::Vector3i dimensions(field->GetDimensions());
-		Eigen::Vector3d relative = (position - origin).cwiseQuotient(spacing);
-		Eigen::Vector3i sample0 = relative.cast<int>();
-		Eigen::Vector3i sample1 = sample0 + Eigen::Vector3i(1, 1, 1);
-		sample0 = sample0.cwiseMax(Eigen::Vector3i(0, 0, 0)).cwiseMin(dimensions - Eigen::Vector3i(1, 1, 1));
-		sample1 = sample1.cwiseMax(Eigen::Vector3i(0, 0, 0)).cwiseMin(dimensions - Eigen::Vector3i(1, 1, 1));
-		Eigen::Vector3d interp = relative - sample0.cast<double>();
-		vtkFloatArray* vectors = dynamic_cast<vtkFloatArray*>(field->GetPointData()->GetAbstractArray(0));
-		return
-			(1 - interp.z()) * (1 - interp.y()) * (1 - interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample0.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample0.x()))
-			+ (1 - interp.z()) * (1 - interp.y()) * (interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample0.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample1.x()))
-			+ (1 - interp.z()) * (interp.y()) * (1 - interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample0.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample0.x()))
-			+ (1 - interp.z()) * (interp.y()) * (interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample0.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample1.x()))
-			+ (interp.z()) * (1 - interp.y()) * (1 - interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample1.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample0.x()))
-			+ (interp.z()) * (1 - interp.y()) * (interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample1.z() * dimensions.y() + sample0.y()) * dimensions.x() + sample1.x()))
-			+ (interp.z()) * (interp.y()) * (1 - interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample1.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample0.x()))
-			+ (interp.z()) * (interp.y()) * (interp.x()) * Eigen::Vector3d(vectors->GetTuple3(((int64_t)sample1.z() * dimensions.y() + sample1.y()) * dimensions.x() + sample1.x()));
+		return FieldSampler(field, field->GetPointData()->GetAbstractArray(0)->GetName()).Sample3(position);
 	}
-}
\ No newline at end of file
+}
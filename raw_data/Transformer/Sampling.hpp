@@ -1,11 +1,127 @@
 #pragma once
 
 #include "Eigen/Eigen"
+#include "SamplingBatch.hpp"
 
 class vtkImageData;
 
 namespace vispro
 {
+	// Raw view onto a float array of a uniform grid. Caches everything the trilinear lookup needs so that
+	// no virtual vtk call happens per sample. Build it once per field and keep the field alive while the view is used.
+	class FieldSampler
+	{
+	public:
+		// View onto the point data array with the given name, e.g. "velocity".
+		FieldSampler(vtkImageData* field, const char* arrayName);
+		// View onto raw interleaved float values, e.g. the data section of a mapped amira file.
+		FieldSampler(const float* data, const int numComponents, const Eigen::Vector3i& dimensions, const Eigen::Vector3d& origin, const Eigen::Vector3d& spacing);
+
+		// Linearly samples a 3D scalar field at a given domain location.
+		inline double Sample1(const Eigen::Vector3d& position) const
+		{
+			int64_t corners[8];
+			Eigen::Vector3d interp;
+			CellCorners(position, corners, interp);
+			return
+				(1 - interp.z()) * (1 - interp.y()) * (1 - interp.x()) * Value1(corners[0])
+				+ (1 - interp.z()) * (1 - interp.y()) * (interp.x()) * Value1(corners[1])
+				+ (1 - interp.z()) * (interp.y()) * (1 - interp.x()) * Value1(corners[2])
+				+ (1 - interp.z()) * (interp.y()) * (interp.x()) * Value1(corners[3])
+				+ (interp.z()) * (1 - interp.y()) * (1 - interp.x()) * Value1(corners[4])
+				+ (interp.z()) * (1 - interp.y()) * (interp.x()) * Value1(corners[5])
+				+ (interp.z()) * (interp.y()) * (1 - interp.x()) * Value1(corners[6])
+				+ (interp.z()) * (interp.y()) * (interp.x()) * Value1(corners[7]);
+		}
+
+		// Linearly samples a 3D vector field at a given domain location.
+		inline Eigen::Vector3d Sample3(const Eigen::Vector3d& position) const
+		{
+			int64_t corners[8];
+			Eigen::Vector3d interp;
+			CellCorners(position, corners, interp);
+			return
+				(1 - interp.z()) * (1 - interp.y()) * (1 - interp.x()) * Value3(corners[0])
+				+ (1 - interp.z()) * (1 - interp.y()) * (interp.x()) * Value3(corners[1])
+				+ (1 - interp.z()) * (interp.y()) * (1 - interp.x()) * Value3(corners[2])
+				+ (1 - interp.z()) * (interp.y()) * (interp.x()) * Value3(corners[3])
+				+ (interp.z()) * (1 - interp.y()) * (1 - interp.x()) * Value3(corners[4])
+				+ (interp.z()) * (1 - interp.y()) * (interp.x()) * Value3(corners[5])
+				+ (interp.z()) * (interp.y()) * (1 - interp.x()) * Value3(corners[6])
+				+ (interp.z()) * (interp.y()) * (interp.x()) * Value3(corners[7]);
+		}
+
+		// Reads the scalar stored at a linear grid index.
+		inline double Value1(const int64_t index) const
+		{
+			return mData[index * mNumComponents];
+		}
+
+		// Reads the vector stored at a linear grid index.
+		inline Eigen::Vector3d Value3(const int64_t index) const
+		{
+			const float* value = mData + index * mNumComponents;
+			return Eigen::Vector3d(value[0], value[1], value[2]);
+		}
+
+		inline int64_t LinearIndex(const int ix, const int iy, const int iz) const
+		{
+			return iz * mStrideZ + iy * mStrideY + ix;
+		}
+
+		// Grid coordinates of the cell containing the position (clamped to the grid) and the interpolation weights inside the cell.
+		inline void CellCoordinates(const Eigen::Vector3d& position, Eigen::Vector3i& sample0, Eigen::Vector3i& sample1, Eigen::Vector3d& interp) const
+		{
+			Eigen::Vector3d relative = (position - mOrigin).cwiseQuotient(mSpacing);
+			sample0 = relative.cast<int>();
+			sample1 = sample0 + Eigen::Vector3i(1, 1, 1);
+			sample0 = sample0.cwiseMax(Eigen::Vector3i(0, 0, 0)).cwiseMin(mMaxIndex);
+			sample1 = sample1.cwiseMax(Eigen::Vector3i(0, 0, 0)).cwiseMin(mMaxIndex);
+			interp = relative - sample0.cast<double>();
+		}
+
+		// Plain description of the grid for SamplingBatch. Requires an interleaved float[3] field.
+		GridView GetGridView() const;
+
+		const float* GetData() const { return mData; }
+		int GetNumComponents() const { return mNumComponents; }
+		const Eigen::Vector3i& GetDimensions() const { return mDimensions; }
+		const Eigen::Vector3d& GetOrigin() const { return mOrigin; }
+		const Eigen::Vector3d& GetSpacing() const { return mSpacing; }
+		const Eigen::Vector3d& GetInverseSpacing() const { return mInverseSpacing; }
+		int64_t GetNumPoints() const { return mStrideZ * mDimensions.z(); }
+
+	private:
+		// Computes the linear grid indices of the eight cell corners and the interpolation weights.
+		// The clamping and the division by the spacing match the old vtk based sampler bit by bit.
+		inline void CellCorners(const Eigen::Vector3d& position, int64_t corners[8], Eigen::Vector3d& interp) const
+		{
+			Eigen::Vector3i sample0, sample1;
+			CellCoordinates(position, sample0, sample1, interp);
+
+			const int64_t z0 = sample0.z() * mStrideZ, z1 = sample1.z() * mStrideZ;
+			const int64_t y0 = sample0.y() * mStrideY, y1 = sample1.y() * mStrideY;
+			corners[0] = z0 + y0 + sample0.x();
+			corners[1] = z0 + y0 + sample1.x();
+			corners[2] = z0 + y1 + sample0.x();
+			corners[3] = z0 + y1 + sample1.x();
+			corners[4] = z1 + y0 + sample0.x();
+			corners[5] = z1 + y0 + sample1.x();
+			corners[6] = z1 + y1 + sample0.x();
+			corners[7] = z1 + y1 + sample1.x();
+		}
+
+		const float* mData;
+		int mNumComponents;
+		Eigen::Vector3i mDimensions;
+		Eigen::Vector3i mMaxIndex;		// dimensions - 1 -> clamp range of the cell corners
+		int64_t mStrideY;
+		int64_t mStrideZ;
+		Eigen::Vector3d mOrigin;
+		Eigen::Vector3d mSpacing;
+		Eigen::Vector3d mInverseSpacing;
+	};
+
 	// Helper for the trilinear sampling of scalar fields and vector fields.
 	class Sampling
 	{
@@ -15,4 +131,4 @@ namespace vispro
 		// Linearly samples a 3D vector field at a given domain location.
 		static Eigen::Vector3d LinearSample3(const Eigen::Vector3d& position, vtkImageData* field);
 	};
-}
\ No newline at end of file
+}
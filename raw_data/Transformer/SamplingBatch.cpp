@@ -0,0 +1,268 @@
+#include "SamplingBatch.hpp"
+#include <algorithm>
+
+#if defined(VISPRO_X86_SIMD)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace vispro
+{
+	// samples a single position -> same operation order as FieldSampler::Sample3
+	static inline void SamplePoint(const GridView& grid, const double px, const double py, const double pz, double& u, double& v, double& w)
+	{
+		const double rx = (px - grid.origin[0]) / grid.spacing[0];
+		const double ry = (py - grid.origin[1]) / grid.spacing[1];
+		const double rz = (pz - grid.origin[2]) / grid.spacing[2];
+		int x0 = (int)rx, y0 = (int)ry, z0 = (int)rz;
+		int x1 = x0 + 1, y1 = y0 + 1, z1 = z0 + 1;
+		x0 = std::min(std::max(x0, 0), grid.maxIndex[0]);
+		y0 = std::min(std::max(y0, 0), grid.maxIndex[1]);
+		z0 = std::min(std::max(z0, 0), grid.maxIndex[2]);
+		x1 = std::min(std::max(x1, 0), grid.maxIndex[0]);
+		y1 = std::min(std::max(y1, 0), grid.maxIndex[1]);
+		z1 = std::min(std::max(z1, 0), grid.maxIndex[2]);
+		const double ix = rx - (double)x0;
+		const double iy = ry - (double)y0;
+		const double iz = rz - (double)z0;
+
+		const double weights[8] = {
+			(1 - iz) * (1 - iy) * (1 - ix),
+			(1 - iz) * (1 - iy) * (ix),
+			(1 - iz) * (iy) * (1 - ix),
+			(1 - iz) * (iy) * (ix),
+			(iz) * (1 - iy) * (1 - ix),
+			(iz) * (1 - iy) * (ix),
+			(iz) * (iy) * (1 - ix),
+			(iz) * (iy) * (ix),
+		};
+		int64_t xo0 = x0, xo1 = x1;
+		int64_t yo0 = y0 * grid.strideY, yo1 = y1 * grid.strideY;
+		int64_t zo0 = z0 * grid.strideZ, zo1 = z1 * grid.strideZ;
+		if (grid.offsets[0])
+		{
+			xo0 = grid.offsets[0][x0], xo1 = grid.offsets[0][x1];
+			yo0 = grid.offsets[1][y0], yo1 = grid.offsets[1][y1];
+			zo0 = grid.offsets[2][z0], zo1 = grid.offsets[2][z1];
+		}
+		const int64_t corners[8] = {
+			zo0 + yo0 + xo0, zo0 + yo0 + xo1, zo0 + yo1 + xo0, zo0 + yo1 + xo1,
+			zo1 + yo0 + xo0, zo1 + yo0 + xo1, zo1 + yo1 + xo0, zo1 + yo1 + xo1,
+		};
+
+		const float* value = grid.data + corners[0] * 3;
+		u = weights[0] * (double)value[0];
+		v = weights[0] * (double)value[1];
+		w = weights[0] * (double)value[2];
+		for (int c = 1; c < 8; c++)
+		{
+			value = grid.data + corners[c] * 3;
+			u = u + weights[c] * (double)value[0];
+			v = v + weights[c] * (double)value[1];
+			w = w + weights[c] * (double)value[2];
+		}
+	}
+
+	void SamplingBatch::Sample3Scalar(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count)
+	{
+		for (int64_t i = 0; i < count; i++)
+		{
+			SamplePoint(grid, x[i], y[i], z[i], u[i], v[i], w[i]);
+		}
+	}
+
+	void SamplingBatch::Sample3(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count)
+	{
+		static const SimdLevel level = GetSimdLevel();
+		Sample3(grid, x, y, z, u, v, w, count, level);
+	}
+
+	void SamplingBatch::Sample3(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count, const SimdLevel level)
+	{
+		if (!IsSupported(level))
+		{
+			Sample3Scalar(grid, x, y, z, u, v, w, count);
+			return;
+		}
+
+		switch (level)
+		{
+#if defined(VISPRO_X86_SIMD)
+		case SimdLevel::SSE2:
+			Sample3SSE2(grid, x, y, z, u, v, w, count);
+			break;
+		case SimdLevel::AVX2:
+			Sample3AVX2(grid, x, y, z, u, v, w, count);
+			break;
+		case SimdLevel::AVX512:
+			Sample3AVX512(grid, x, y, z, u, v, w, count);
+			break;
+#endif
+		default:
+			Sample3Scalar(grid, x, y, z, u, v, w, count);
+			break;
+		}
+	}
+
+	const char* SamplingBatch::ToString(const SimdLevel level)
+	{
+		switch (level)
+		{
+		case SimdLevel::Scalar:
+			return "Scalar";
+		case SimdLevel::SSE2:
+			return "SSE2";
+		case SimdLevel::AVX2:
+			return "AVX2";
+		case SimdLevel::AVX512:
+			return "AVX512";
+		default:
+			return "Not Implemented";
+		}
+	}
+
+#if defined(VISPRO_X86_SIMD)
+	// the os has to save the wider registers on context switches -> check xcr0 as well as the cpuid flags
+	static bool CpuSupports(const SimdLevel level)
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (level == SimdLevel::SSE2)
+		{
+			return (info[3] & (1 << 26)) != 0;
+		}
+		if (!osxsave || !avx || maxLeaf < 7)
+		{
+			return false;
+		}
+		const unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		if (level == SimdLevel::AVX2)
+		{
+			return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+		}
+		if (level == SimdLevel::AVX512)
+		{
+			return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+		}
+		return false;
+#else
+		__builtin_cpu_init();
+		switch (level)
+		{
+		case SimdLevel::SSE2:
+			return __builtin_cpu_supports("sse2");
+		case SimdLevel::AVX2:
+			return __builtin_cpu_supports("avx2");
+		case SimdLevel::AVX512:
+			return __builtin_cpu_supports("avx512f");
+		default:
+			return false;
+		}
+#endif
+	}
+#endif
+
+	bool SamplingBatch::IsSupported(const SimdLevel level)
+	{
+		if (level == SimdLevel::Scalar)
+		{
+			return true;
+		}
+#if defined(VISPRO_X86_SIMD)
+		return CpuSupports(level);
+#else
+		return false;
+#endif
+	}
+
+	SimdLevel SamplingBatch::GetSimdLevel()
+	{
+		static const SimdLevel level = []()
+		{
+			for (SimdLevel candidate : { SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSE2 })
+			{
+				if (IsSupported(candidate))
+				{
+					return candidate;
+				}
+			}
+			return SimdLevel::Scalar;
+		}();
+		return level;
+	}
+
+#if defined(VISPRO_X86_SIMD)
+	// two positions per iteration -> sse2 has no gather, so the corner values are loaded individually
+	void SamplingBatch::Sample3SSE2(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count)
+	{
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d origin[3] = { _mm_set1_pd(grid.origin[0]), _mm_set1_pd(grid.origin[1]), _mm_set1_pd(grid.origin[2]) };
+		const __m128d spacing[3] = { _mm_set1_pd(grid.spacing[0]), _mm_set1_pd(grid.spacing[1]), _mm_set1_pd(grid.spacing[2]) };
+
+		int64_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m128d position[3] = { _mm_loadu_pd(x + i), _mm_loadu_pd(y + i), _mm_loadu_pd(z + i) };
+			__m128d interp[3];
+			int64_t offset0[3][2], offset1[3][2];
+			for (int d = 0; d < 3; d++)
+			{
+				const __m128d relative = _mm_div_pd(_mm_sub_pd(position[d], origin[d]), spacing[d]);
+				alignas(16) int truncated[4];
+				_mm_store_si128((__m128i*)truncated, _mm_cvttpd_epi32(relative));
+				const int64_t stride = d == 0 ? 1 : (d == 1 ? grid.strideY : grid.strideZ);
+				const int64_t* table = grid.offsets[d];
+				int sample0[2];
+				for (int lane = 0; lane < 2; lane++)
+				{
+					sample0[lane] = std::min(std::max(truncated[lane], 0), grid.maxIndex[d]);
+					const int sample1 = std::min(std::max(truncated[lane] + 1, 0), grid.maxIndex[d]);
+					offset0[d][lane] = table ? table[sample0[lane]] : sample0[lane] * stride;
+					offset1[d][lane] = table ? table[sample1] : sample1 * stride;
+				}
+				interp[d] = _mm_sub_pd(relative, _mm_set_pd((double)sample0[1], (double)sample0[0]));
+			}
+
+			const __m128d ix = interp[0], iy = interp[1], iz = interp[2];
+			const __m128d mx = _mm_sub_pd(one, ix), my = _mm_sub_pd(one, iy), mz = _mm_sub_pd(one, iz);
+			const __m128d weights[8] = {
+				_mm_mul_pd(_mm_mul_pd(mz, my), mx),
+				_mm_mul_pd(_mm_mul_pd(mz, my), ix),
+				_mm_mul_pd(_mm_mul_pd(mz, iy), mx),
+				_mm_mul_pd(_mm_mul_pd(mz, iy), ix),
+				_mm_mul_pd(_mm_mul_pd(iz, my), mx),
+				_mm_mul_pd(_mm_mul_pd(iz, my), ix),
+				_mm_mul_pd(_mm_mul_pd(iz, iy), mx),
+				_mm_mul_pd(_mm_mul_pd(iz, iy), ix),
+			};
+
+			__m128d result[3];
+			for (int c = 0; c < 8; c++)
+			{
+				const int64_t(&ox)[2] = (c & 1) ? offset1[0] : offset0[0];
+				const int64_t(&oy)[2] = (c & 2) ? offset1[1] : offset0[1];
+				const int64_t(&oz)[2] = (c & 4) ? offset1[2] : offset0[2];
+				const float* value0 = grid.data + (oz[0] + oy[0] + ox[0]) * 3;
+				const float* value1 = grid.data + (oz[1] + oy[1] + ox[1]) * 3;
+				for (int k = 0; k < 3; k++)
+				{
+					const __m128d term = _mm_mul_pd(weights[c], _mm_set_pd((double)value1[k], (double)value0[k]));
+					result[k] = c == 0 ? term : _mm_add_pd(result[k], term);
+				}
+			}
+			_mm_storeu_pd(u + i, result[0]);
+			_mm_storeu_pd(v + i, result[1]);
+			_mm_storeu_pd(w + i, result[2]);
+		}
+		Sample3Scalar(grid, x + i, y + i, z + i, u + i, v + i, w + i, count - i);
+	}
+#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// This header is also included by the translation units that are compiled with AVX2 / AVX-512 code generation.
+// Keep it free of Eigen, vtk and the standard library so that no inline function gets instantiated with wider instructions.
+
+namespace vispro
+{
+	// Plain description of a uniform grid with an interleaved float[3] payload.
+	// The node (ix, iy, iz) is stored at iz * strideZ + iy * strideY + ix, or at offsets[2][iz] + offsets[1][iy] + offsets[0][ix]
+	// if the grid has a separable layout (see BrickedField).
+	struct GridView
+	{
+		const float* data;
+		int64_t strideY;		// dimensions.x
+		int64_t strideZ;		// dimensions.x * dimensions.y
+		const int64_t* offsets[3] = { nullptr, nullptr, nullptr };	// per dimension node offsets, nullptr -> linear layout
+		int maxIndex[3];		// dimensions - 1
+		double origin[3];
+		double spacing[3];
+	};
+
+	enum class SimdLevel
+	{
+		Scalar,
+		SSE2,
+		AVX2,
+		AVX512,
+	};
+
+	// Trilinear sampling of a vector field at many positions at once.
+	// Positions and results are stored in structure-of-arrays layout (x[], y[], z[]).
+	// All code paths compute the same expression as FieldSampler::Sample3 in the same order.
+	class SamplingBatch
+	{
+	public:
+		// Samples with the widest instruction set supported by the running cpu.
+		static void Sample3(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count);
+		// Samples with a specific instruction set. Falls back to the scalar path if the level is not available.
+		static void Sample3(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count, const SimdLevel level);
+		// Reference implementation.
+		static void Sample3Scalar(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count);
+
+		// Widest instruction set that is compiled in and supported by the cpu. Evaluated once.
+		static SimdLevel GetSimdLevel();
+		static bool IsSupported(const SimdLevel level);
+		static const char* ToString(const SimdLevel level);
+
+	private:
+		static void Sample3SSE2(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count);
+		static void Sample3AVX2(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count);
+		static void Sample3AVX512(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count);
+	};
+}
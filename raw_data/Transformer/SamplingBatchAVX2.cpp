@@ -0,0 +1,90 @@
+#include "SamplingBatch.hpp"
+
+// This translation unit is compiled with AVX2 code generation (see CMakeLists.txt).
+// It is only entered after SamplingBatch::IsSupported(SimdLevel::AVX2) returned true.
+#if defined(VISPRO_X86_SIMD)
+#include <immintrin.h>
+
+namespace vispro
+{
+	// four positions per iteration
+	// the corner values are fetched with 64 bit index gathers, so grids beyond 2^31 values are fine
+	void SamplingBatch::Sample3AVX2(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d origin[3] = { _mm256_set1_pd(grid.origin[0]), _mm256_set1_pd(grid.origin[1]), _mm256_set1_pd(grid.origin[2]) };
+		const __m256d spacing[3] = { _mm256_set1_pd(grid.spacing[0]), _mm256_set1_pd(grid.spacing[1]), _mm256_set1_pd(grid.spacing[2]) };
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i oneInt = _mm_set1_epi32(1);
+		const __m128i maxIndex[3] = { _mm_set1_epi32(grid.maxIndex[0]), _mm_set1_epi32(grid.maxIndex[1]), _mm_set1_epi32(grid.maxIndex[2]) };
+		const __m256i strideY = _mm256_set1_epi64x(grid.strideY);
+		const __m256i strideZ = _mm256_set1_epi64x(grid.strideZ);
+		const bool separable = grid.offsets[0] != nullptr;
+
+		int64_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256d position[3] = { _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), _mm256_loadu_pd(z + i) };
+			__m256d interp[3];
+			__m256i offset0[3], offset1[3];
+			for (int d = 0; d < 3; d++)
+			{
+				const __m256d relative = _mm256_div_pd(_mm256_sub_pd(position[d], origin[d]), spacing[d]);
+				const __m128i truncated = _mm256_cvttpd_epi32(relative);
+				const __m128i sample0 = _mm_min_epi32(_mm_max_epi32(truncated, zero), maxIndex[d]);
+				const __m128i sample1 = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(truncated, oneInt), zero), maxIndex[d]);
+				interp[d] = _mm256_sub_pd(relative, _mm256_cvtepi32_pd(sample0));
+				if (separable)
+				{
+					// node offsets of the bricked / morton layout are read from the tables of the grid
+					offset0[d] = _mm256_i32gather_epi64((const long long*)grid.offsets[d], sample0, 8);
+					offset1[d] = _mm256_i32gather_epi64((const long long*)grid.offsets[d], sample1, 8);
+				}
+				else
+				{
+					offset0[d] = _mm256_cvtepi32_epi64(sample0);
+					offset1[d] = _mm256_cvtepi32_epi64(sample1);
+				}
+			}
+			if (!separable)
+			{
+				// the samples are non negative and the strides stay below 2^32 -> an unsigned 32x32 bit multiply is exact
+				offset0[1] = _mm256_mul_epu32(offset0[1], strideY);
+				offset1[1] = _mm256_mul_epu32(offset1[1], strideY);
+				offset0[2] = _mm256_mul_epu32(offset0[2], strideZ);
+				offset1[2] = _mm256_mul_epu32(offset1[2], strideZ);
+			}
+
+			const __m256d ix = interp[0], iy = interp[1], iz = interp[2];
+			const __m256d mx = _mm256_sub_pd(one, ix), my = _mm256_sub_pd(one, iy), mz = _mm256_sub_pd(one, iz);
+			const __m256d weights[8] = {
+				_mm256_mul_pd(_mm256_mul_pd(mz, my), mx),
+				_mm256_mul_pd(_mm256_mul_pd(mz, my), ix),
+				_mm256_mul_pd(_mm256_mul_pd(mz, iy), mx),
+				_mm256_mul_pd(_mm256_mul_pd(mz, iy), ix),
+				_mm256_mul_pd(_mm256_mul_pd(iz, my), mx),
+				_mm256_mul_pd(_mm256_mul_pd(iz, my), ix),
+				_mm256_mul_pd(_mm256_mul_pd(iz, iy), mx),
+				_mm256_mul_pd(_mm256_mul_pd(iz, iy), ix),
+			};
+
+			__m256d result[3];
+			for (int c = 0; c < 8; c++)
+			{
+				const __m256i linear = _mm256_add_epi64(_mm256_add_epi64((c & 4) ? offset1[2] : offset0[2], (c & 2) ? offset1[1] : offset0[1]), (c & 1) ? offset1[0] : offset0[0]);
+				const __m256i index = _mm256_add_epi64(_mm256_slli_epi64(linear, 1), linear);	// three floats per vector
+				for (int k = 0; k < 3; k++)
+				{
+					const __m256d value = _mm256_cvtps_pd(_mm256_i64gather_ps(grid.data + k, index, 4));
+					const __m256d term = _mm256_mul_pd(weights[c], value);
+					result[k] = c == 0 ? term : _mm256_add_pd(result[k], term);
+				}
+			}
+			_mm256_storeu_pd(u + i, result[0]);
+			_mm256_storeu_pd(v + i, result[1]);
+			_mm256_storeu_pd(w + i, result[2]);
+		}
+		Sample3Scalar(grid, x + i, y + i, z + i, u + i, v + i, w + i, count - i);
+	}
+}
+#endif
@@ -0,0 +1,90 @@
+#include "SamplingBatch.hpp"
+
+// This translation unit is compiled with AVX-512 code generation (see CMakeLists.txt).
+// It is only entered after SamplingBatch::IsSupported(SimdLevel::AVX512) returned true.
+#if defined(VISPRO_X86_SIMD)
+#include <immintrin.h>
+
+namespace vispro
+{
+	// eight positions per iteration
+	// the corner values are fetched with 64 bit index gathers, so grids beyond 2^31 values are fine
+	void SamplingBatch::Sample3AVX512(const GridView& grid, const double* x, const double* y, const double* z, double* u, double* v, double* w, const int64_t count)
+	{
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d origin[3] = { _mm512_set1_pd(grid.origin[0]), _mm512_set1_pd(grid.origin[1]), _mm512_set1_pd(grid.origin[2]) };
+		const __m512d spacing[3] = { _mm512_set1_pd(grid.spacing[0]), _mm512_set1_pd(grid.spacing[1]), _mm512_set1_pd(grid.spacing[2]) };
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i oneInt = _mm256_set1_epi32(1);
+		const __m256i maxIndex[3] = { _mm256_set1_epi32(grid.maxIndex[0]), _mm256_set1_epi32(grid.maxIndex[1]), _mm256_set1_epi32(grid.maxIndex[2]) };
+		const __m512i strideY = _mm512_set1_epi64(grid.strideY);
+		const __m512i strideZ = _mm512_set1_epi64(grid.strideZ);
+		const bool separable = grid.offsets[0] != nullptr;
+
+		int64_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m512d position[3] = { _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), _mm512_loadu_pd(z + i) };
+			__m512d interp[3];
+			__m512i offset0[3], offset1[3];
+			for (int d = 0; d < 3; d++)
+			{
+				const __m512d relative = _mm512_div_pd(_mm512_sub_pd(position[d], origin[d]), spacing[d]);
+				const __m256i truncated = _mm512_cvttpd_epi32(relative);
+				const __m256i sample0 = _mm256_min_epi32(_mm256_max_epi32(truncated, zero), maxIndex[d]);
+				const __m256i sample1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(truncated, oneInt), zero), maxIndex[d]);
+				interp[d] = _mm512_sub_pd(relative, _mm512_cvtepi32_pd(sample0));
+				if (separable)
+				{
+					// node offsets of the bricked / morton layout are read from the tables of the grid
+					offset0[d] = _mm512_i32gather_epi64(sample0, grid.offsets[d], 8);
+					offset1[d] = _mm512_i32gather_epi64(sample1, grid.offsets[d], 8);
+				}
+				else
+				{
+					offset0[d] = _mm512_cvtepi32_epi64(sample0);
+					offset1[d] = _mm512_cvtepi32_epi64(sample1);
+				}
+			}
+			if (!separable)
+			{
+				// the samples are non negative and the strides stay below 2^32 -> an unsigned 32x32 bit multiply is exact
+				offset0[1] = _mm512_mul_epu32(offset0[1], strideY);
+				offset1[1] = _mm512_mul_epu32(offset1[1], strideY);
+				offset0[2] = _mm512_mul_epu32(offset0[2], strideZ);
+				offset1[2] = _mm512_mul_epu32(offset1[2], strideZ);
+			}
+
+			const __m512d ix = interp[0], iy = interp[1], iz = interp[2];
+			const __m512d mx = _mm512_sub_pd(one, ix), my = _mm512_sub_pd(one, iy), mz = _mm512_sub_pd(one, iz);
+			const __m512d weights[8] = {
+				_mm512_mul_pd(_mm512_mul_pd(mz, my), mx),
+				_mm512_mul_pd(_mm512_mul_pd(mz, my), ix),
+				_mm512_mul_pd(_mm512_mul_pd(mz, iy), mx),
+				_mm512_mul_pd(_mm512_mul_pd(mz, iy), ix),
+				_mm512_mul_pd(_mm512_mul_pd(iz, my), mx),
+				_mm512_mul_pd(_mm512_mul_pd(iz, my), ix),
+				_mm512_mul_pd(_mm512_mul_pd(iz, iy), mx),
+				_mm512_mul_pd(_mm512_mul_pd(iz, iy), ix),
+			};
+
+			__m512d result[3];
+			for (int c = 0; c < 8; c++)
+			{
+				const __m512i linear = _mm512_add_epi64(_mm512_add_epi64((c & 4) ? offset1[2] : offset0[2], (c & 2) ? offset1[1] : offset0[1]), (c & 1) ? offset1[0] : offset0[0]);
+				const __m512i index = _mm512_add_epi64(_mm512_slli_epi64(linear, 1), linear);	// three floats per vector
+				for (int k = 0; k < 3; k++)
+				{
+					const __m512d value = _mm512_cvtps_pd(_mm512_i64gather_ps(index, grid.data + k, 4));
+					const __m512d term = _mm512_mul_pd(weights[c], value);
+					result[k] = c == 0 ? term : _mm512_add_pd(result[k], term);
+				}
+			}
+			_mm512_storeu_pd(u + i, result[0]);
+			_mm512_storeu_pd(v + i, result[1]);
+			_mm512_storeu_pd(w + i, result[2]);
+		}
+		Sample3Scalar(grid, x + i, y + i, z + i, u + i, v + i, w + i, count - i);
+	}
+}
+#endif
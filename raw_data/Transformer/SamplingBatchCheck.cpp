@@ -0,0 +1,139 @@
+#include "SamplingBatch.hpp"
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <random>
+#include <algorithm>
+#include <iostream>
+
+// Self-contained check of the batch sampler: every simd level has to reproduce the scalar trilinear interpolation
+// on a synthetic field, in the linear and in a separable node layout. Returns non-zero if a level differs.
+
+using namespace vispro;
+
+static const double SAMPLING_TOLERANCE = FLT_EPSILON;
+static const int SAMPLING_CHECK_SAMPLES = 100003;	// not a multiple of the vector widths -> the scalar tail is covered as well
+
+// smooth vector field with values in [-2, 2]
+static void FillField(const int dimensions[3], const double origin[3], const double spacing[3], const int64_t* const offsets[3], std::vector<float>& data)
+{
+	data.resize((size_t)dimensions[0] * dimensions[1] * dimensions[2] * 3);
+	for (int iz = 0; iz < dimensions[2]; iz++)
+	{
+		for (int iy = 0; iy < dimensions[1]; iy++)
+		{
+			for (int ix = 0; ix < dimensions[0]; ix++)
+			{
+				const double x = origin[0] + ix * spacing[0], y = origin[1] + iy * spacing[1], z = origin[2] + iz * spacing[2];
+				const int64_t node = offsets[0][ix] + offsets[1][iy] + offsets[2][iz];
+				data[node * 3 + 0] = (float)(std::sin(x) + std::cos(y * z));
+				data[node * 3 + 1] = (float)(std::cos(x + y) - std::sin(z));
+				data[node * 3 + 2] = (float)(std::sin(x * y) + std::cos(z));
+			}
+		}
+	}
+}
+
+// compares all supported levels against Sample3Scalar, true if all of them match
+static bool CheckGrid(const GridView& grid, const double lower[3], const double upper[3], const char* name)
+{
+	// sample slightly outside of the domain as well to cover the clamping
+	std::mt19937 random(7);
+	std::vector<double> position[3];
+	for (int d = 0; d < 3; d++)
+	{
+		const double margin = 0.05 * (upper[d] - lower[d]);
+		std::uniform_real_distribution<double> distribution(lower[d] - margin, upper[d] + margin);
+		position[d].resize(SAMPLING_CHECK_SAMPLES);
+		for (double& value : position[d])
+		{
+			value = distribution(random);
+		}
+	}
+
+	std::vector<double> u0(SAMPLING_CHECK_SAMPLES), v0(SAMPLING_CHECK_SAMPLES), w0(SAMPLING_CHECK_SAMPLES);
+	SamplingBatch::Sample3Scalar(grid, position[0].data(), position[1].data(), position[2].data(), u0.data(), v0.data(), w0.data(), SAMPLING_CHECK_SAMPLES);
+
+	bool ok = true;
+	for (SimdLevel level : { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 })
+	{
+		if (!SamplingBatch::IsSupported(level))
+		{
+			std::cout << name << ", " << SamplingBatch::ToString(level) << ": not supported\n";
+			continue;
+		}
+		std::vector<double> u(SAMPLING_CHECK_SAMPLES), v(SAMPLING_CHECK_SAMPLES), w(SAMPLING_CHECK_SAMPLES);
+		SamplingBatch::Sample3(grid, position[0].data(), position[1].data(), position[2].data(), u.data(), v.data(), w.data(), SAMPLING_CHECK_SAMPLES, level);
+
+		double maxError = 0.0;
+		for (int i = 0; i < SAMPLING_CHECK_SAMPLES; i++)
+		{
+			maxError = std::max(maxError, std::sqrt((u[i] - u0[i]) * (u[i] - u0[i]) + (v[i] - v0[i]) * (v[i] - v0[i]) + (w[i] - w0[i]) * (w[i] - w0[i])));
+		}
+		const bool match = maxError <= SAMPLING_TOLERANCE;
+		std::cout << name << ", " << SamplingBatch::ToString(level) << ": max error " << maxError << (match ? " (ok)\n" : " (FAILED)\n");
+		ok = ok && match;
+	}
+	return ok;
+}
+
+int main(int, char*[])
+{
+	const int dimensions[3] = { 37, 23, 19 };
+	const double origin[3] = { -1.5, 0.25, 2.0 };
+	const double spacing[3] = { 0.1, 0.2, 0.15 };
+	double upper[3];
+	for (int d = 0; d < 3; d++)
+	{
+		upper[d] = origin[d] + (dimensions[d] - 1) * spacing[d];
+	}
+
+	GridView grid;
+	grid.strideY = dimensions[0];
+	grid.strideZ = (int64_t)dimensions[0] * dimensions[1];
+	for (int d = 0; d < 3; d++)
+	{
+		grid.maxIndex[d] = dimensions[d] - 1;
+		grid.origin[d] = origin[d];
+		grid.spacing[d] = spacing[d];
+	}
+	std::cout << "Selected simd level: " << SamplingBatch::ToString(SamplingBatch::GetSimdLevel()) << "\n";
+
+	// linear layout: x fastest
+	std::vector<int64_t> linear[3];
+	const int64_t strides[3] = { 1, grid.strideY, grid.strideZ };
+	for (int d = 0; d < 3; d++)
+	{
+		for (int i = 0; i < dimensions[d]; i++)
+		{
+			linear[d].push_back(i * strides[d]);
+		}
+	}
+	const int64_t* linearOffsets[3] = { linear[0].data(), linear[1].data(), linear[2].data() };
+	std::vector<float> linearData;
+	FillField(dimensions, origin, spacing, linearOffsets, linearData);
+	grid.data = linearData.data();
+	bool ok = CheckGrid(grid, origin, upper, "linear");
+
+	// separable layout through the offset tables: z fastest, x slowest
+	std::vector<int64_t> transposed[3];
+	const int64_t transposedStrides[3] = { (int64_t)dimensions[1] * dimensions[2], dimensions[2], 1 };
+	for (int d = 0; d < 3; d++)
+	{
+		for (int i = 0; i < dimensions[d]; i++)
+		{
+			transposed[d].push_back(i * transposedStrides[d]);
+		}
+	}
+	const int64_t* transposedOffsets[3] = { transposed[0].data(), transposed[1].data(), transposed[2].data() };
+	std::vector<float> transposedData;
+	FillField(dimensions, origin, spacing, transposedOffsets, transposedData);
+	grid.data = transposedData.data();
+	for (int d = 0; d < 3; d++)
+	{
+		grid.offsets[d] = transposedOffsets[d];
+	}
+	ok = CheckGrid(grid, origin, upper, "separable") && ok;
+
+	return ok ? 0 : 1;
+}
@@ -4,7 +4,10 @@
 #include <vtkFloatArray.h>
 #include "AmiraReader.hpp"
 #include "Sampling.hpp"
+#include "SamplingBatch.hpp"
+#include "ParticlePool.hpp"
 #include <omp.h>
+#include <algorithm>
 
 namespace vispro
 {
@@ -102,7 +105,26 @@ namespace vispro
 		}
 	}
 
-	void SteadyTracer::Streamline(std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const Eigen::AlignedBox3d& bounds, const unsigned numParticles, const unsigned numSteps, const double maxLength, const double stepSize, const double normalizeFactor)
+	std::string SteadyTracer::ToString(const IntegrationMethod method)
+	{
+		switch (method)
+		{
+		case RK4:
+			return "RK4";
+		case DormandPrince:
+			return "DormandPrince";
+		default:
+			return "";
+		}
+	}
+
+	uint64_t SteadyTracer::Streamline(std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const Eigen::AlignedBox3d& bounds, const unsigned numParticles, const unsigned numSteps, const double maxLength, const double stepSize, const double normalizeFactor, const IntegratorSettings& integrator)
+	{
+		FieldSampler sampler(velocityField, "velocity");
+		return Streamline(lines, sampler.GetGridView(), bounds, numParticles, numSteps, maxLength, stepSize, normalizeFactor, integrator);
+	}
+
+	uint64_t SteadyTracer::Streamline(std::vector<Line>& lines, const GridView& velocityField, const Eigen::AlignedBox3d& bounds, const unsigned numParticles, const unsigned numSteps, const double maxLength, const double stepSize, const double normalizeFactor, const IntegratorSettings& integrator)
 	{
 		std::vector<Eigen::Vector3d> seedParticles(numParticles);
 		std::vector<unsigned> seedIds(numParticles);
@@ -115,8 +137,9 @@ namespace vispro
 			numStepsHalf++;
 		}
 
-		std::vector<Line> forwardLine = SteadyTracer::TraceLines(seedParticles, seedIds, velocityField, numStepsHalf, numParticles, bounds, maxLengthHalf, stepSize, normalizeFactor);
-		std::vector<Line> backwardLine = SteadyTracer::TraceLines(seedParticles, seedIds, velocityField, numStepsHalf, numParticles, bounds, maxLengthHalf , -stepSize, normalizeFactor); // negative stepSize -> already flips list vertex order 
+		uint64_t numSamples = 0;
+		std::vector<Line> forwardLine = SteadyTracer::TraceLines(seedParticles, seedIds, velocityField, numStepsHalf, numParticles, bounds, maxLengthHalf, stepSize, normalizeFactor, integrator, numSamples);
+		std::vector<Line> backwardLine = SteadyTracer::TraceLines(seedParticles, seedIds, velocityField, numStepsHalf, numParticles, bounds, maxLengthHalf , -stepSize, normalizeFactor, integrator, numSamples); // negative stepSize -> already flips list vertex order 
 
 		// combine lines
 		lines.resize(numParticles);
@@ -130,147 +153,334 @@ namespace vispro
 				std::memcpy(&lines[i][backwardLine[i].size() - 1],	&forwardLine[i][0],		forwardLine[i].size()			* sizeof(Eigen::Vector3d));
 			}
 		}
+		return numSamples;
 	}
 
 
-	std::vector<Line> SteadyTracer::TraceLines(const std::vector<Eigen::Vector3d>& seedParticles, const std::vector<unsigned>& seedIds, const vtkSmartPointer<vtkImageData>& velocityField, const unsigned numSteps, const unsigned numParticles, const Eigen::AlignedBox3d& bounds, const double maxLength, const double stepSize, const double normalizeFactor)
+	// every particle appends its vertices to its own line -> the predecessor of a particle is always the last vertex of its line
+	// the particles only touch their own line and path length, so the per step update runs in parallel
+	std::vector<Line> SteadyTracer::TraceLines(const std::vector<Eigen::Vector3d>& seedParticles, const std::vector<unsigned>& seedIds, const GridView& velocityField, const unsigned numSteps, const unsigned numParticles, const Eigen::AlignedBox3d& bounds, const double maxLength, const double stepSize, const double normalizeFactor, const IntegratorSettings& integrator, uint64_t& numSamples)
 	{
-		std::vector<Eigen::Vector3d> particles = seedParticles;
-		std::vector<unsigned> particleIDs = seedIds;
-		std::vector<Eigen::Vector3d> particlesHistory;
-		std::vector<unsigned> particleIDsHistory;
-		std::vector<unsigned> deadParticles;
-		std::vector<double> totalPathLengths(numParticles, 0.0);
-		unsigned currentNumParticles = numParticles;
-		for (int step = 0; step < numSteps; step++)
+		ParticlePool particles;
+		particles.Seed(seedParticles, seedIds);
+
+		// the adaptive integrator runs forward in time for both directions -> the direction is part of the velocity
+		const double outputStep = std::abs(stepSize);
+		const double velocityScale = stepSize < 0.0 ? -normalizeFactor : normalizeFactor;
+		if (integrator.method == IntegrationMethod::DormandPrince)
+		{
+			particles.EnableIntegratorState(outputStep);
+
+			// first stage of the first step
+			double* derivative[3] = { particles.State(ParticlePool::DerivativeX), particles.State(ParticlePool::DerivativeY), particles.State(ParticlePool::DerivativeZ) };
+			SamplingBatch::Sample3(velocityField, particles.X().data(), particles.Y().data(), particles.Z().data(), derivative[0], derivative[1], derivative[2], particles.Size());
+			for (int d = 0; d < 3; d++)
+				for (int64_t i = 0; i < particles.Size(); i++)
+					derivative[d][i] *= velocityScale;
+			numSamples += particles.Size();
+		}
+		std::vector<Line> lines(numParticles);
+		int64_t currentNumParticles = particles.Size();
+		for (unsigned step = 0; step < numSteps && currentNumParticles > 0; step++)
 		{
-			// add particles to history
-			for (int i = 0; i < currentNumParticles; i++)
+			const ParticlePool::Array<unsigned>& particleIDs = particles.Id();
+			ParticlePool::Array<double>& totalPathLengths = particles.PathLength();
+			ParticlePool::Array<uint8_t>& alive = particles.Alive();
+			#ifndef _DEBUG
+			#pragma omp parallel for
+			#endif
+			for (int64_t i = 0; i < currentNumParticles; i++)
 			{
+				Line& line = lines[particleIDs[i]];
+				const Eigen::Vector3d position = particles.Position(i);
+
 				// check for dead particles -> particles outside of the domain / particles in a source
 				bool isDead = false;
-				if (!bounds.contains(particles[i]))
+				if (!bounds.contains(position))
 				{
 					isDead = true;
 				}
 
 				// if a particle has not moved much from its last spot then kill it
-				if (!isDead && particlesHistory.size() >= numParticles)
+				if (!isDead && !line.empty())
 				{
-					unsigned predecessorIndex = getPredecessorParticleIndex(particleIDs[i], particleIDsHistory);
-					double diff = (particles[i] - particlesHistory[predecessorIndex]).norm();
-					totalPathLengths[particleIDs[i]] += diff;
+					double diff = (position - line.back()).norm();
+					totalPathLengths[i] += diff;
 
-					if (totalPathLengths[particleIDs[i]] > maxLength || diff < 0.000001 )
+					if (totalPathLengths[i] > maxLength || diff < 0.000001)
 					{
 						isDead = true;
 					}
 				}
 
-				if (isDead)
-				{
-					deadParticles.push_back(particleIDs[i]);
-				}
-				else
+				// append alive particles to their line
+				if (!isDead)
 				{
-					// add advected particles to particle history
-					particlesHistory.push_back(particles[i]);
-					particleIDsHistory.push_back(particleIDs[i]);
+					line.push_back(position);
 				}
+				alive[i] = !isDead;
 			}
 
-			// remove dead particles from vectors -> inplace remove by iterating through vector and skipping elements which need to be deleted
-			if (!deadParticles.empty())
-			{
-				unsigned int deadIndex = 0;
-				for (unsigned i = 0; i < currentNumParticles; i++)
-				{
-					if (deadIndex < deadParticles.size() && deadParticles[deadIndex] == particleIDs[i])
-					{
-						deadIndex++;
-						continue;
-					}
-					else
-					{
-						particles[i - deadIndex] = particles[i];
-						particleIDs[i - deadIndex] = particleIDs[i];
-					}
-				}
-				currentNumParticles = currentNumParticles - deadParticles.size();
-				particles.resize(currentNumParticles);
-				particleIDs.resize(currentNumParticles);
-				deadParticles.clear();
-			}
+			// remove dead particles
+			currentNumParticles = particles.Compact();
 
 			// advect particles
-			Advect(particles, velocityField, stepSize, normalizeFactor);
-		}
-
-		// extract lines from particle history
-		std::vector<Line> lines(numParticles);
-		if (stepSize > 0.0)
-		{
-			for (unsigned i = 0; i < particlesHistory.size(); i++)
+			if (integrator.method == IntegrationMethod::DormandPrince)
 			{
-				lines[particleIDsHistory[i]].push_back(particlesHistory[i]);
+				numSamples += AdvectAdaptive(particles, velocityField, (step + 1) * outputStep, velocityScale, integrator.tolerance, integrator.minStepFactor * outputStep, integrator.maxStepFactor * outputStep);
 			}
-		}
-		else
-		{
-			for (unsigned i = 0; i < particlesHistory.size(); i++)
+			else
 			{
-				lines[particleIDsHistory[i]].insert(lines[particleIDsHistory[i]].begin(), particlesHistory[i]);
+				numSamples += Advect(particles.Span(), velocityField, stepSize, normalizeFactor);
 			}
 		}
 
-		return lines;
-	}
-
-	// find previous particle with the same id
-	unsigned SteadyTracer::getPredecessorParticleIndex(unsigned particleID, std::vector<unsigned>& particleIDsHistory)
-	{
-		for (unsigned j = particleIDsHistory.size() - 1; j >= 0; j--)
+		// backward tracing -> flip vertex order so that every line starts at its end point
+		if (stepSize < 0.0)
 		{
-			if (particleIDsHistory[j] == particleID)
+			for (Line& line : lines)
 			{
-				return j;
+				std::reverse(line.begin(), line.end());
 			}
 		}
-		return 0;
+
+		return lines;
 	}
 
-	void SteadyTracer::Advect(std::vector<Eigen::Vector3d>& particles, const vtkSmartPointer<vtkImageData>& velocityField, const double stepSize, const double normalizeFactor)
+	// particles are advected in blocks -> every runge-kutta stage samples the velocity field for the whole block in one batch
+	uint64_t SteadyTracer::Advect(const ParticleSpan& particles, const GridView& grid, const double stepSize, const double normalizeFactor)
 	{
-		unsigned errors = 0;
-		int64_t numParticles = (int64_t) particles.size();
+		static const int64_t blockSize = 128;
+		const int64_t numParticles = particles.count;
+		const int64_t numBlocks = (numParticles + blockSize - 1) / blockSize;
+		uint64_t numSamples = 0;
 		#ifndef _DEBUG
-		#pragma omp parallel for
+		#pragma omp parallel for reduction(+:numSamples)
 		#endif
-		for (int64_t i = 0; i < numParticles; ++i) 
+		for (int64_t block = 0; block < numBlocks; ++block)
 		{
+			const int64_t begin = block * blockSize;
+			const int64_t count = std::min(blockSize, numParticles - begin);
+			double* pos[3] = { particles.x + begin, particles.y + begin, particles.z + begin };	// particle positions
+			double stage[3][blockSize];		// sample positions of the current stage
+			double k1[3][blockSize], k2[3][blockSize], k3[3][blockSize], k4[3][blockSize];
+
 			// numerical integration step
-			Eigen::Vector3d& pos = particles[i];
-			Eigen::Vector3d k1 = Sampling::LinearSample3(pos, velocityField);
+			SamplingBatch::Sample3(grid, pos[0], pos[1], pos[2], k1[0], k1[1], k1[2], count);
+			numSamples += count;
 #if 1
 			// fourth-order Runge-Kutta
-			Eigen::Vector3d k2 = Sampling::LinearSample3(pos + 0.5 * stepSize * k1, velocityField);
-			Eigen::Vector3d k3 = Sampling::LinearSample3(pos + 0.5 * stepSize * k2, velocityField);
-			Eigen::Vector3d k4 = Sampling::LinearSample3(pos + stepSize * k3,		velocityField);
-			Eigen::Vector3d change = (k1 + 2 * k2 + 2 * k3 + k4) / (6.0);
+			const double halfStep = 0.5 * stepSize;
+			for (int d = 0; d < 3; d++)
+				for (int64_t i = 0; i < count; ++i)
+					stage[d][i] = pos[d][i] + halfStep * k1[d][i];
+			SamplingBatch::Sample3(grid, stage[0], stage[1], stage[2], k2[0], k2[1], k2[2], count);
+
+			for (int d = 0; d < 3; d++)
+				for (int64_t i = 0; i < count; ++i)
+					stage[d][i] = pos[d][i] + halfStep * k2[d][i];
+			SamplingBatch::Sample3(grid, stage[0], stage[1], stage[2], k3[0], k3[1], k3[2], count);
+
+			for (int d = 0; d < 3; d++)
+				for (int64_t i = 0; i < count; ++i)
+					stage[d][i] = pos[d][i] + stepSize * k3[d][i];
+			SamplingBatch::Sample3(grid, stage[0], stage[1], stage[2], k4[0], k4[1], k4[2], count);
+			numSamples += 3 * count;
+
+			double (&change)[3][blockSize] = stage;
+			for (int d = 0; d < 3; d++)
+				for (int64_t i = 0; i < count; ++i)
+					change[d][i] = (k1[d][i] + 2 * k2[d][i] + 2 * k3[d][i] + k4[d][i]) / (6.0);
 #else
 			// explicit euler
-			Eigen::Vector3d change = k1;
+			double (&change)[3][blockSize] = k1;
 #endif
 
-			change = change * normalizeFactor * stepSize;
-			if (std::isnan(change[0]) || std::isnan(change[1]) || std::isnan(change[2]))
+			for (int64_t i = 0; i < count; ++i)
 			{
-				continue;
+				Eigen::Vector3d delta(change[0][i], change[1][i], change[2][i]);
+				delta = delta * normalizeFactor * stepSize;
+				if (std::isnan(delta[0]) || std::isnan(delta[1]) || std::isnan(delta[2]))
+				{
+					continue;
+				}
+				else
+				{
+					for (int d = 0; d < 3; d++)
+					{
+						pos[d][i] += delta[d];
+					}
+				}
 			}
-			else
+		}
+		return numSamples;
+	}
+
+	// Dormand-Prince 5(4) coefficients, see Hairer, Norsett, Wanner: Solving Ordinary Differential Equations I
+	static const double dopriA[7][6] = {
+		{ 0.0 },
+		{ 1.0 / 5.0 },
+		{ 3.0 / 40.0, 9.0 / 40.0 },
+		{ 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 },
+		{ 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 },
+		{ 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 },
+		{ 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 },		// fifth order solution
+	};
+	static const double dopriE[7] = { 71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0, -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0 };	// fifth - fourth order solution
+	static const double dopriD[7] = { -12715105075.0 / 11282082432.0, 0.0, 87487479700.0 / 32700410799.0, -10690763975.0 / 1880347072.0, 701980252875.0 / 199316789632.0, -1453857185.0 / 822651844.0, 69997945.0 / 29380423.0 };	// dense output
+
+	// every particle takes as many adaptive steps as it needs to pass the output time, the new vertex is then read from the dense output
+	// particles of a block that still lag behind the output time are packed into lanes, so that every stage is one batch sample
+	uint64_t SteadyTracer::AdvectAdaptive(ParticlePool& particles, const GridView& grid, const double outputTime, const double velocityScale, const double tolerance, const double minStepSize, const double maxStepSize)
+	{
+		static const int64_t blockSize = 128;
+		const int64_t numParticles = particles.Size();
+		const int64_t numBlocks = (numParticles + blockSize - 1) / blockSize;
+		double* position[3] = { particles.X().data(), particles.Y().data(), particles.Z().data() };
+		double* state[3] = { particles.State(ParticlePool::StateX), particles.State(ParticlePool::StateY), particles.State(ParticlePool::StateZ) };
+		double* derivative[3] = { particles.State(ParticlePool::DerivativeX), particles.State(ParticlePool::DerivativeY), particles.State(ParticlePool::DerivativeZ) };
+		double* time = particles.State(ParticlePool::Time);
+		double* stepSize = particles.State(ParticlePool::StepSize);
+		double* intervalBegin = particles.State(ParticlePool::IntervalBegin);
+		double* intervalLength = particles.State(ParticlePool::IntervalLength);
+		double* dense[5][3];
+		for (int c = 0; c < 5; c++)
+			for (int d = 0; d < 3; d++)
+				dense[c][d] = particles.State(ParticlePool::DenseCoefficients + 3 * c + d);
+
+		uint64_t numSamples = 0;
+		#ifndef _DEBUG
+		#pragma omp parallel for reduction(+:numSamples)
+		#endif
+		for (int64_t block = 0; block < numBlocks; ++block)
+		{
+			const int64_t begin = block * blockSize;
+			const int64_t end = std::min(begin + blockSize, numParticles);
+			int64_t lanes[blockSize];		// particle index of every lane
+			double h[blockSize];
+			double stage[3][blockSize];
+			double k[7][3][blockSize];
+
+			int64_t numLanes = 0;
+			for (int64_t i = begin; i < end; ++i)
 			{
-				pos += change;
+				if (time[i] < outputTime)
+				{
+					lanes[numLanes++] = i;
+				}
+			}
+
+			while (numLanes > 0)
+			{
+				for (int64_t j = 0; j < numLanes; ++j)
+				{
+					h[j] = stepSize[lanes[j]];
+					for (int d = 0; d < 3; d++)
+						k[0][d][j] = derivative[d][lanes[j]];
+				}
+
+				// stages 2 - 6 and the fifth order solution -> its velocity is the first stage of the next step
+				for (int s = 1; s < 7; s++)
+				{
+					for (int d = 0; d < 3; d++)
+					{
+						for (int64_t j = 0; j < numLanes; ++j)
+						{
+							double sum = 0.0;
+							for (int m = 0; m < s; m++)
+								sum += dopriA[s][m] * k[m][d][j];
+							stage[d][j] = state[d][lanes[j]] + h[j] * sum;
+						}
+					}
+					if (s == 6)
+					{
+						break;
+					}
+					SamplingBatch::Sample3(grid, stage[0], stage[1], stage[2], k[s][0], k[s][1], k[s][2], numLanes);
+					for (int d = 0; d < 3; d++)
+						for (int64_t j = 0; j < numLanes; ++j)
+							k[s][d][j] *= velocityScale;
+				}
+				SamplingBatch::Sample3(grid, stage[0], stage[1], stage[2], k[6][0], k[6][1], k[6][2], numLanes);
+				for (int d = 0; d < 3; d++)
+					for (int64_t j = 0; j < numLanes; ++j)
+						k[6][d][j] *= velocityScale;
+				numSamples += 6 * numLanes;
+
+				// error control
+				int64_t numRemaining = 0;
+				for (int64_t j = 0; j < numLanes; ++j)
+				{
+					const int64_t i = lanes[j];
+					double error = 0.0;
+					for (int d = 0; d < 3; d++)
+					{
+						double e = 0.0;
+						for (int s = 0; s < 7; s++)
+							e += dopriE[s] * k[s][d][j];
+						e = h[j] * e / tolerance;
+						error += e * e;
+					}
+					error = std::sqrt(error / 3.0);
+
+					// the field is broken at this location -> freeze the particle, it gets killed by the tracer
+					if (std::isnan(error) || std::isnan(stage[0][j]) || std::isnan(stage[1][j]) || std::isnan(stage[2][j]))
+					{
+						time[i] = outputTime;
+						intervalLength[i] = 0.0;
+						continue;
+					}
+
+					const bool accepted = error <= 1.0 || h[j] <= minStepSize;
+					double factor = error > 0.0 ? 0.9 * std::pow(error, -0.2) : 5.0;
+					factor = std::min(std::max(factor, 0.2), accepted ? 5.0 : 1.0);
+					stepSize[i] = std::min(std::max(h[j] * factor, minStepSize), maxStepSize);
+
+					if (accepted)
+					{
+						for (int d = 0; d < 3; d++)
+						{
+							const double y0 = state[d][i];
+							const double y1 = stage[d][j];
+							double d0 = 0.0;
+							for (int s = 0; s < 7; s++)
+								d0 += dopriD[s] * k[s][d][j];
+							dense[0][d][i] = y0;
+							dense[1][d][i] = y1 - y0;
+							dense[2][d][i] = h[j] * k[0][d][j] - dense[1][d][i];
+							dense[3][d][i] = dense[1][d][i] - h[j] * k[6][d][j] - dense[2][d][i];
+							dense[4][d][i] = h[j] * d0;
+							state[d][i] = y1;
+							derivative[d][i] = k[6][d][j];
+						}
+						intervalBegin[i] = time[i];
+						intervalLength[i] = h[j];
+						time[i] += h[j];
+					}
+
+					if (time[i] < outputTime)
+					{
+						lanes[numRemaining++] = i;
+					}
+				}
+				numLanes = numRemaining;
+			}
+
+			// vertices at the output time
+			for (int64_t i = begin; i < end; ++i)
+			{
+				if (intervalLength[i] <= 0.0)
+				{
+					continue;
+				}
+				const double theta = (outputTime - intervalBegin[i]) / intervalLength[i];
+				const double theta1 = 1.0 - theta;
+				for (int d = 0; d < 3; d++)
+				{
+					position[d][i] = dense[0][d][i] + theta * (dense[1][d][i] + theta1 * (dense[2][d][i] + theta * (dense[3][d][i] + theta1 * dense[4][d][i])));
+				}
 			}
 		}
+		return numSamples;
 	}
 }
\ No newline at end of file
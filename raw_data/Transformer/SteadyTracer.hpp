@@ -1,29 +1,49 @@
 #pragma once
 
 #include <vector>
+#include <string>
+#include <cstdint>
 #include <Eigen/Eigen>
 #include <vtkSmartPointer.h>
 
 class vtkImageData;
 class vtkFloatArray;
 
+namespace vispro { struct GridView; class ParticlePool; struct ParticleSpan; }
+
 typedef std::vector<Eigen::Vector3d> Line;
 
+enum IntegrationMethod {
+	RK4,			// fixed step fourth-order Runge-Kutta
+	DormandPrince,	// adaptive step RK45 with dense output at the fixed step size
+};
+
+struct IntegratorSettings {
+	IntegrationMethod method = IntegrationMethod::RK4;
+	double tolerance = 1e-6;		// maximum local error per step of the adaptive integrator (domain units)
+	double minStepFactor = 0.1;		// step size bounds of the adaptive integrator relative to the fixed step size
+	double maxStepFactor = 50.0;
+};
+
 namespace vispro
 {
 	class SteadyTracer
 	{
 	public:
-		static void Streamline(std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const Eigen::AlignedBox3d& bounds, const unsigned numParticles, const unsigned numSteps, const double maxLength, const double stepSize, const double normalizeFactor);
+		// Traces numParticles streamlines with vertices every stepSize. Returns the number of velocity field samples.
+		static uint64_t Streamline(std::vector<Line>& lines, const vtkSmartPointer<vtkImageData>& velocityField, const Eigen::AlignedBox3d& bounds, const unsigned numParticles, const unsigned numSteps, const double maxLength, const double stepSize, const double normalizeFactor, const IntegratorSettings& integrator = IntegratorSettings());
+		// Traces in a field of any layout, e.g. the grid of a BrickedField.
+		static uint64_t Streamline(std::vector<Line>& lines, const GridView& velocityField, const Eigen::AlignedBox3d& bounds, const unsigned numParticles, const unsigned numSteps, const double maxLength, const double stepSize, const double normalizeFactor, const IntegratorSettings& integrator = IntegratorSettings());
+		static std::string ToString(const IntegrationMethod method);
 		static void FilterLinesSize(std::vector<Line>& lines, const unsigned minSize);
 		static void FilterLinesLength(std::vector<Line>& lines, const double minLength);
 		static void FilterIntraLineDistance(std::vector<Line>& lines, const double minLength);
 
 	private:
-		static std::vector<Line> TraceLines(const std::vector<Eigen::Vector3d>& seedParticles, const std::vector<unsigned>& seedIds, const vtkSmartPointer<vtkImageData>& velocityField, const unsigned numSteps, const unsigned numParticles, const Eigen::AlignedBox3d& bounds, const double maxLength, const double stepSize, const double normalizeFactor);
-		static void Advect(std::vector<Eigen::Vector3d>& particles, const vtkSmartPointer<vtkImageData>& velocityField, const double stepSize, const double normalizeFactor);
+		static std::vector<Line> TraceLines(const std::vector<Eigen::Vector3d>& seedParticles, const std::vector<unsigned>& seedIds, const GridView& velocityField, const unsigned numSteps, const unsigned numParticles, const Eigen::AlignedBox3d& bounds, const double maxLength, const double stepSize, const double normalizeFactor, const IntegratorSettings& integrator, uint64_t& numSamples);
+		static uint64_t Advect(const ParticleSpan& particles, const GridView& grid, const double stepSize, const double normalizeFactor);
+		static uint64_t AdvectAdaptive(ParticlePool& particles, const GridView& grid, const double outputTime, const double velocityScale, const double tolerance, const double minStepSize, const double maxStepSize);
 		static void SeedLines(std::vector<Eigen::Vector3d>& particles, std::vector<unsigned>& particleIDs, const unsigned numParticles, const Eigen::AlignedBox3d& bounds);
-		static unsigned getPredecessorParticleIndex(unsigned particleID, std::vector<unsigned>& particleIDsHistory);
 
 	};
 }
\ No newline at end of file
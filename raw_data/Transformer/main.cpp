@@ -8,15 +8,20 @@
 #include "ObjectWriter.hpp"
 #include "Vorticity.hpp"
 #include "Sampling.hpp"
+#include "SamplingBatch.hpp"
+#include "BrickedField.hpp"
 #include "LineValues.hpp"
 #include "Normalize.hpp"
 #include "ObjectReader.hpp"
+#include "LineSet.hpp"
+#include "DistanceMatrix.hpp"
 #include "LineDistanceMetrics.hpp"
 
 #include "stdafx.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <filesystem>
 #include "dataanalysis.h"
 
 using namespace vispro;
@@ -33,6 +38,8 @@ struct ExtractConfig {
 	double minPointDistance;
 	bool clampProperty;
 	bool smoothProerty;
+	IntegratorSettings integrator;
+	FieldLayout layout = FieldLayout::Linear;	// node order of the velocity field while tracing
 };
 
 struct DistanceConfig {
@@ -41,6 +48,8 @@ struct DistanceConfig {
 	float importanceWeight;
 	float scalarColorWeight;
 	bool normalization;
+	double farDistance = 0.0;	// rMCPD: > 0 -> pairs further apart only store a lower bound (> farDistance)
+	unsigned knn = 0;			// > 0 -> sparse graph of the knn closest lines (*.knn) instead of the matrix
 };
 
 std::string AmiraPath(const std::string& basePath, const std::string& name)
@@ -64,22 +73,73 @@ std::string ObjectPath(const std::string& basePath, const std::string& name, con
 	return output;
 }
 
-std::string DistanceMatrixPath(const std::string& basePath, const std::string& name, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized)
+// one line set holds the lines with all properties
+std::string LineSetPath(const std::string& basePath, const std::string& name)
+{
+	return basePath + "\\" + name + ".lines";
+}
+
+std::string DistanceMatrixPath(const std::string& basePath, const std::string& name, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized, const double farDistance = 0.0)
 {
 	std::string output = basePath + "\\" + name + "---" + metric + "---" + std::to_string(importanceWeight) + "---" + std::to_string(scalarColorWeight);
 	if (normalized)
 	{
 		output += "---Normalized";
 	}
-	output += ".dist";
+	if (farDistance > 0.0)
+	{
+		output += "---Far" + std::to_string(farDistance);
+	}
+	output += ".distb";
 	return output;
 }
 
-void saveDistanceMatrix(const std::string& filename, alglib::real_2d_array& d)
+std::string LineGraphPath(const std::string& basePath, const std::string& name, const std::string& metric, const float importanceWeight, const float scalarColorWeight, const bool normalized, const unsigned k)
 {
-	std::ofstream out(filename, std::ofstream::out);
-	out << d.tostring(6);
-	out.close();
+	std::string output = DistanceMatrixPath(basePath, name, metric, importanceWeight, scalarColorWeight, normalized);
+	output = output.substr(0, output.find_last_of('.'));
+	return output + "---kNN" + std::to_string(k) + ".knn";
+}
+
+// older extractions stored the full matrix as alglib text (*.dist) -> write the condensed binary matrix next to it
+void ConvertDistanceMatrix(const DistanceConfig& config, const std::string& distPath)
+{
+	std::string out = DistanceMatrixPath(distPath, config.name, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization);
+	std::string in = std::filesystem::path(out).replace_extension(".dist").string();
+
+	std::clock_t start = std::clock();
+	alglib::real_2d_array d;
+	std::ifstream text(in);
+	if (!text.is_open())
+	{
+		std::cout << "No text matrix: " << in << '\n';
+		return;
+	}
+	std::string s;
+	text >> s;
+	d = s.c_str();
+	double textDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+
+	Eigen::MatrixXd distance(d.rows(), d.cols());
+	for (alglib::ae_int_t i = 0; i < d.rows(); i++)
+	{
+		for (alglib::ae_int_t j = 0; j < d.cols(); j++)
+		{
+			distance(i, j) = d(i, j);
+		}
+	}
+	DistanceMatrixWriter::WriteDistanceMatrix(out.c_str(), distance, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization, 0.0);
+
+	start = std::clock();
+	DistanceMatrixView view;
+	view.Open(out.c_str());
+	double checksum = 0.0;
+	for (uint64_t i = 0; i < view.GetNumLines() * (view.GetNumLines() - 1) / 2; i++)
+	{
+		checksum += view.GetValues()[i];
+	}
+	double binaryDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+	std::cout << "text " << textDuration << "s (" << std::filesystem::file_size(in) << " bytes), binary " << binaryDuration << "s (" << std::filesystem::file_size(out) << " bytes), checksum " << checksum << '\n';
 }
 
 void ExtractSingleLineData(const ExtractConfig& config, std::string& inputPath, std::string& outputPath, LineProperty importance, LineProperty scalarColor)
@@ -103,7 +163,8 @@ void ExtractSingleLineData(const ExtractConfig& config, std::string& inputPath,
 
 	// calculate lines
 	std::vector<Line> lines;
-	SteadyTracer::Streamline(lines, velocityField, bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor);
+	uint64_t numSamples = SteadyTracer::Streamline(lines, velocityField, bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor, config.integrator);
+	std::cout << "Integrator: " << SteadyTracer::ToString(config.integrator.method) << ", field samples per line: " << (double)numSamples / lines.size() << "\n";
 	SteadyTracer::FilterLinesSize(lines, 3);
 
 	// get importance value for each line vertex
@@ -263,9 +324,18 @@ void ExtractAllLineData(const ExtractConfig& config, std::string& inputPath, std
 		normalizationFactor = Normalize::InverseMaximumMagnitude(velocityField);
 	}
 
-	// calculate lines
+	// calculate lines -> the bricked / morton copy of the field is only used for tracing
 	std::vector<Line> lines;
-	SteadyTracer::Streamline(lines, velocityField, bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor);
+	if (config.layout == FieldLayout::Linear)
+	{
+		SteadyTracer::Streamline(lines, velocityField, bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor, config.integrator);
+	}
+	else
+	{
+		BrickedField layoutField;
+		layoutField.Load(input, FieldSampler(velocityField, "velocity"), config.layout);
+		SteadyTracer::Streamline(lines, layoutField.GetGridView(), bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor, config.integrator);
+	}
 	
 	std::cout << "Properties before filtering:\n";
 	PrintLineProperties(lines);
@@ -277,7 +347,7 @@ void ExtractAllLineData(const ExtractConfig& config, std::string& inputPath, std
 	std::cout << "Properties after filtering:\n";
 	PrintLineProperties(lines);
 
-	// calculate line properties
+	// calculate line properties -> vorticity and acceleration are evaluated at the line vertices, no derived field is allocated
 	std::unordered_map<LineProperty, LineValue> lineValues;
 	for (LineProperty prop : AllProperties)
 	{
@@ -304,14 +374,157 @@ void ExtractAllLineData(const ExtractConfig& config, std::string& inputPath, std
 		lineValues.insert({ prop, lineValue });
 	}
 
-	// save results
-	for (LineProperty importance : AllProperties)
+	// save results -> one line set with every property instead of an obj file per importance / scalarColor combination
+	std::vector<std::string> propertyNames;
+	std::vector<const std::vector<std::vector<double>>*> propertyValues;
+	for (LineProperty prop : AllProperties)
+	{
+		propertyNames.push_back(LineProperties::ToString(prop));
+		propertyValues.push_back(&lineValues[prop].values);
+	}
+	LineSetWriter::WriteLineSet(LineSetPath(outputPath, config.name).c_str(), lines, propertyNames, propertyValues);
+}
+
+// combines the obj files of a dataset that were extracted before the line sets into one line set
+// the geometry is taken from the first file, the property of every file with importance == scalarColor
+void ConvertObjectsToLineSet(const std::string& name, const std::string& objectPath)
+{
+	std::vector<Line> lines;
+	std::vector<std::string> propertyNames;
+	std::vector<std::vector<std::vector<double>>> values;
+	for (LineProperty prop : AllProperties)
+	{
+		std::string propName = LineProperties::ToString(prop);
+		Lines5d lines5d = ObjectReader::ReadObject(ObjectPath(objectPath, name, propName, propName));
+		if (lines5d.empty())
+		{
+			continue;
+		}
+		if (lines.empty())
+		{
+			lines.resize(lines5d.size());
+			for (size_t i = 0; i < lines5d.size(); i++)
+				for (const Eigen::Vector<double, 5>& vertex : lines5d[i])
+					lines[i].push_back(vertex.head<3>());
+		}
+		std::vector<std::vector<double>> propValues(lines5d.size());
+		for (size_t i = 0; i < lines5d.size(); i++)
+			for (const Eigen::Vector<double, 5>& vertex : lines5d[i])
+				propValues[i].push_back(vertex[3]);
+		propertyNames.push_back(propName);
+		values.push_back(propValues);
+	}
+
+	std::vector<const std::vector<std::vector<double>>*> propertyValues;
+	for (const auto& value : values)
+	{
+		propertyValues.push_back(&value);
+	}
+	LineSetWriter::WriteLineSet(LineSetPath(objectPath, name).c_str(), lines, propertyNames, propertyValues);
+}
+
+// traces the same seeds with both integrators and reports the field samples per line and the deviation of the lines
+void CompareIntegrators(const ExtractConfig& config, std::string& inputPath)
+{
+	std::string input = AmiraPath(inputPath, config.name);
+
+	Eigen::AlignedBox3d bounds;
+	Eigen::Vector3i resolution;
+	Eigen::Vector3d spacing;
+	int numComponents;
+	vtkSmartPointer<vtkImageData> velocityField = AmiraReader::ReadField(input.c_str(), "velocity", bounds, resolution, spacing, numComponents);
+
+	double normalizationFactor = 1.0;
+	if (config.normalization == NormalizationMethod::MinMax)
+	{
+		normalizationFactor = Normalize::InverseMaximumMagnitude(velocityField);
+	}
+
+	IntegratorSettings rk4;
+	IntegratorSettings dormandPrince = config.integrator;
+	dormandPrince.method = IntegrationMethod::DormandPrince;
+
+	std::vector<Line> lines[2];
+	IntegratorSettings settings[2] = { rk4, dormandPrince };
+	unsigned int seed = (unsigned int)time(0);
+	for (int i = 0; i < 2; i++)
+	{
+		srand(seed);	// same seeds for both integrators
+		std::clock_t start = std::clock();
+		uint64_t numSamples = SteadyTracer::Streamline(lines[i], velocityField, bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor, settings[i]);
+		double duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+		std::cout << SteadyTracer::ToString(settings[i].method) << ": " << (double)numSamples / lines[i].size() << " field samples per line, " << duration << "s\n";
+	}
+
+	// both integrators write vertices at the same times -> compare the vertices of lines that were stopped at the same step
+	double maxDistance = 0.0;
+	double sumDistance = 0.0;
+	size_t numCompared = 0;
+	for (size_t l = 0; l < lines[0].size(); l++)
+	{
+		if (lines[0][l].size() != lines[1][l].size())
+		{
+			continue;
+		}
+		for (size_t v = 0; v < lines[0][l].size(); v++)
+		{
+			double distance = (lines[0][l][v] - lines[1][l][v]).norm();
+			maxDistance = std::max(maxDistance, distance);
+			sumDistance += distance;
+			numCompared++;
+		}
+	}
+	std::cout << "Vertex distance RK4 - DormandPrince: max " << maxDistance << ", mean " << sumDistance / std::max<size_t>(numCompared, 1) << "\n";
+}
+
+// traces the same seeds in the linear, bricked and morton layout of a field and reports the tracing times
+// the layouts store the same values, so the lines have to be identical
+void CompareFieldLayouts(const ExtractConfig& config, std::string& inputPath)
+{
+	std::string input = AmiraPath(inputPath, config.name);
+
+	Eigen::AlignedBox3d bounds;
+	Eigen::Vector3i resolution;
+	Eigen::Vector3d spacing;
+	int numComponents;
+	vtkSmartPointer<vtkImageData> velocityField = AmiraReader::ReadField(input.c_str(), "velocity", bounds, resolution, spacing, numComponents);
+	FieldSampler sampler(velocityField, "velocity");
+
+	double normalizationFactor = 1.0;
+	if (config.normalization == NormalizationMethod::MinMax)
+	{
+		normalizationFactor = Normalize::InverseMaximumMagnitude(velocityField);
+	}
+
+	std::vector<Line> reference;
+	unsigned int seed = (unsigned int)time(0);
+	for (FieldLayout layout : { FieldLayout::Linear, FieldLayout::Bricked, FieldLayout::ZOrder })
 	{
-		for (LineProperty scalarColor : AllProperties)
+		// the linear layout is traced in the field itself
+		BrickedField layoutField;
+		GridView grid = sampler.GetGridView();
+		std::clock_t start = std::clock();
+		bool cached = layout != FieldLayout::Linear && layoutField.Load(input, sampler, layout);
+		double loadDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+		if (layout != FieldLayout::Linear)
 		{
-			std::string output = ObjectPath(outputPath, config.name, LineProperties::ToString(importance), LineProperties::ToString(scalarColor));
-			ObjectWriter::WriteObjectFast(output.c_str(), lines, lineValues[importance].values, lineValues[scalarColor].values);
+			grid = layoutField.GetGridView();
 		}
+
+		std::vector<Line> lines;
+		srand(seed);	// same seeds for all layouts
+		start = std::clock();
+		SteadyTracer::Streamline(lines, grid, bounds, config.numParticles, config.numSteps, config.maxLength, config.stepSize, normalizationFactor, config.integrator);
+		double duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+
+		if (layout == FieldLayout::Linear)
+		{
+			reference = lines;
+			std::cout << BrickedField::ToString(layout) << ": tracing " << duration << "s\n";
+			continue;
+		}
+		std::cout << BrickedField::ToString(layout) << ": tracing " << duration << "s, " << (cached ? "cache read " : "conversion ") << loadDuration << "s, "
+			<< (double)layoutField.GetNumNodes() / sampler.GetNumPoints() << "x nodes" << (lines == reference ? " (identical)\n" : " (DIFFERENT)\n");
 	}
 }
 
@@ -366,10 +579,12 @@ void ScaleValues(Lines5d& lines, unsigned index, const Range& range)
 	}
 }
 
-void ExtractAllDistaneMetrics(const DistanceConfig& config, const std::string& inputPath, const std::string& outputPath, const std::string& importance = "", const std::string& scalarColor = "")
+// lines with normalized and weighted importance / scalarColor dimensions
+Lines5d ReadDistanceLines(const DistanceConfig& config, const std::string& inputPath, const std::string& importance, const std::string& scalarColor)
 {
-	std::string in = ObjectPath(inputPath, config.name, importance, scalarColor);
-	Lines5d lines = ObjectReader::ReadObject(in);
+	// datasets without a line set (e.g. tornado) are read from their obj file
+	std::string lineSet = LineSetPath(inputPath, config.name);
+	Lines5d lines = std::filesystem::exists(lineSet) ? LineSetReader::ReadLineSet(lineSet, importance, scalarColor) : ObjectReader::ReadObject(ObjectPath(inputPath, config.name, importance, scalarColor));
 
 	if (config.normalization)
 	{
@@ -383,13 +598,99 @@ void ExtractAllDistaneMetrics(const DistanceConfig& config, const std::string& i
 	Range scalarColoreWeight = { 0.0, config.scalarColorWeight };
 	ScaleValues(lines, 3, importanceWeight);
 	ScaleValues(lines, 4, scalarColoreWeight);
+	return lines;
+}
 
-	Eigen::MatrixXd distance = LineDistanceMetrics::Compute_Metric(lines, config.metric);
-	alglib::real_2d_array d;
-	d.attach_to_ptr(lines.size(), lines.size(), distance.data());
+void ExtractAllDistaneMetrics(const DistanceConfig& config, const std::string& inputPath, const std::string& outputPath, const std::string& importance = "", const std::string& scalarColor = "")
+{
+	Lines5d lines = ReadDistanceLines(config, inputPath, importance, scalarColor);
+	if (config.knn > 0)
+	{
+		// the candidates are refined exactly -> a few times k keeps the recall at 1 on our datasets
+		LineGraph graph = LineDistanceMetrics::Compute_KNN(lines, config.metric, config.knn, std::max(64u, 4 * config.knn));
+		std::string out = LineGraphPath(outputPath, config.name, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization, config.knn);
+		LineGraphWriter::WriteLineGraph(out.c_str(), graph, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization);
+		return;
+	}
+	// only rMCPD stores lower bounds beyond farDistance, the other metrics are exact and named without it
+	const double farDistance = config.metric == rMCPD ? config.farDistance : 0.0;
+	Eigen::MatrixXd distance = LineDistanceMetrics::Compute_Metric(lines, config.metric, farDistance);
 
-	std::string out = DistanceMatrixPath(outputPath, config.name, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization);
-	saveDistanceMatrix(out, d);
+	std::string out = DistanceMatrixPath(outputPath, config.name, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization, farDistance);
+	DistanceMatrixWriter::WriteDistanceMatrix(out.c_str(), distance, LineDistanceMetrics::ToString(config.metric), config.importanceWeight, config.scalarColorWeight, config.normalization, farDistance);
+}
+
+// rMCPD with the kd-tree per line against the brute force kernel, used to pick LineDistanceMetrics::rMCPDKdTreeMinLength
+void CompareDistanceKernels(const DistanceConfig& config, const std::string& inputPath)
+{
+	Lines5d lines = ReadDistanceLines(config, inputPath, "", "");
+	size_t totalLength = 0, maxLength = 0;
+	for (const Line5d& line : lines)
+	{
+		totalLength += line.size();
+		maxLength = std::max(maxLength, line.size());
+	}
+	std::cout << lines.size() << " lines, mean length " << totalLength / std::max<size_t>(lines.size(), 1) << ", max length " << maxLength << '\n';
+
+	std::clock_t start = std::clock();
+	Eigen::MatrixXd kdTree = LineDistanceMetrics::Compute_rMCPD_KdTree(lines);
+	double kdTreeDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+	start = std::clock();
+	Eigen::MatrixXd bruteForce = LineDistanceMetrics::Compute_rMCPD(lines, SIZE_MAX);
+	double bruteForceDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+	start = std::clock();
+	Eigen::MatrixXd selected = LineDistanceMetrics::Compute_rMCPD(lines);
+	double selectedDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+
+	// the brute force kernel works in float32
+	double maxError = ((kdTree - bruteForce).cwiseAbs().array() / (kdTree.cwiseAbs().array() + 1e-12)).maxCoeff();
+	std::cout << "kd-tree " << kdTreeDuration << "s, brute force " << bruteForceDuration << "s, selected " << selectedDuration << "s, max relative error " << maxError << '\n';
+
+	// pairs closer than farDistance have to stay exact, the others only need a lower bound beyond farDistance
+	if (config.farDistance > 0.0)
+	{
+		start = std::clock();
+		Eigen::MatrixXd bounded = LineDistanceMetrics::Compute_rMCPD(lines, LineDistanceMetrics::rMCPDKdTreeMinLength, config.farDistance);
+		double boundedDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+		size_t farPairs = 0, wrongPairs = 0;
+		for (Eigen::Index i = 0; i < selected.rows(); i++)
+		{
+			for (Eigen::Index j = i + 1; j < selected.cols(); j++)
+			{
+				if (bounded(i, j) != selected(i, j))
+				{
+					farPairs++;
+					wrongPairs += selected(i, j) <= config.farDistance || bounded(i, j) <= config.farDistance || bounded(i, j) > selected(i, j) + 1e-4 * selected(i, j);
+				}
+			}
+		}
+		std::cout << "far distance " << config.farDistance << ": " << boundedDuration << "s, " << farPairs << " far pairs, " << wrongPairs << " wrong bounds\n";
+	}
+
+	// share of the exact k nearest lines that the centroid candidates of the sparse graph find
+	if (config.knn > 0)
+	{
+		start = std::clock();
+		LineGraph graph = LineDistanceMetrics::Compute_KNN(lines, rMCPD, config.knn, std::max(64u, 4 * config.knn));
+		double graphDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+		size_t found = 0;
+		for (Eigen::Index i = 0; i < selected.rows(); i++)
+		{
+			std::vector<std::pair<double, Eigen::Index>> row;
+			for (Eigen::Index j = 0; j < selected.cols(); j++)
+			{
+				if (j != i) row.emplace_back(selected(i, j), j);
+			}
+			const size_t k = std::min<size_t>(config.knn, row.size());
+			std::partial_sort(row.begin(), row.begin() + k, row.end());
+			for (size_t n = 0; n < k; n++)
+			{
+				const uint32_t* neighbors = graph.neighbors.data() + i * config.knn;
+				found += std::find(neighbors, neighbors + config.knn, (uint32_t)row[n].second) != neighbors + config.knn;
+			}
+		}
+		std::cout << config.knn << " nearest lines: " << graphDuration << "s, recall " << found / (double)(selected.rows() * std::min<size_t>(config.knn, selected.rows() - 1)) << '\n';
+	}
 }
 
 int main(int, char*[])
@@ -404,7 +705,7 @@ int main(int, char*[])
 	// ---------------------------------------------------------------------------------------------------------------------------
 	std::vector<ExtractConfig> Configurations = 
 	{
-		// name,							numPartics,	numSteps,	maxLength,	stepSize,	normalization,			minPointAmount, minLineLength, minPointDistance, clampProperty, smoothProperty
+		// name,							numPartics,	numSteps,	maxLength,	stepSize,	normalization,			minPointAmount, minLineLength, minPointDistance, clampProperty, smoothProperty, integrator (default RK4), layout (default Linear)
 		//{"benzene",						9000000,	5000,		900.0,		10.0,		NormalizationMethod::MinMax,	10,		0.0,	0.01,	false,	false},
 		//{"benzene",						500000,		50000,		50.0,		0.01,		NormalizationMethod::MinMax,	10,		1.0,	0.01,	false,	false},
 		//{"borromean",						2000,		10000,		100.0,		0.1,		NormalizationMethod::MinMax,	10,		4.0,	0.05,	true,	true},
@@ -414,6 +715,7 @@ int main(int, char*[])
 		//{"trefoil140",					8000,		2000,		100.0,		0.1,		NormalizationMethod::MinMax,	10,		2.0,	0.02,	false,	false},
 		//{"UCLA_CTBL_Velocity_T6",			1500,		40000,		1000,		1.0,		NormalizationMethod::MinMax,	10,		2.0,	0.2,	false,	false},
 		{"delta65_high",					8000,		50000,		200.0,		0.001f,		NormalizationMethod::MinMax,	10,		2.0,	0.05,	false,	false},
+		//{"delta65_high",					8000,		50000,		200.0,		0.001f,		NormalizationMethod::MinMax,	10,		2.0,	0.05,	false,	false,	{IntegrationMethod::DormandPrince, 1e-6, 0.1, 50.0}},
 	};
 
 
@@ -456,9 +758,11 @@ int main(int, char*[])
 		//{"borromean", DistanceMetrics::MeanL2, 0.0, 0.0, true},
 		
 		//{"benzene", DistanceMetrics::rMCPD, 1.0, 0.0, true},
+		//{"benzene", DistanceMetrics::rMCPD, 1.0, 0.0, true, 0.0, 16},	// 500k lines -> only the sparse graph fits into memory
 		//{"benzene", DistanceMetrics::MeanL2, 0.0, 0.0, true},
 		
 		//{"ECMWF_3D_Reanalysis_Velocity_T0", DistanceMetrics::rMCPD, 1.0, 0.0, true},
+		//{"ECMWF_3D_Reanalysis_Velocity_T0", DistanceMetrics::rMCPD, 1.0, 0.0, true, 50.0},	// only pairs closer than 50 exact
 		//{"ECMWF_3D_Reanalysis_Velocity_T0", DistanceMetrics::MeanL2, 0.0, 0.0, true},
 		
 		//{"trefoil10", DistanceMetrics::rMCPD, 1.0, 0.0, true},
@@ -489,6 +793,53 @@ int main(int, char*[])
 #endif
 
 
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// line set conversion -------------------------------------------------------------------------------------------------------
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// combine the obj files of older extractions into one line set per dataset and compare the load times
+	// reuseing the distance configuration
+#if 0
+	for (auto config : DistanceConfigurations)
+	{
+		std::cout << "Converting obj files to line set: " << config.name << '\n';
+		ConvertObjectsToLineSet(config.name, objectPath);
+
+		std::string propName = LineProperties::ToString(LineProperty::lineLength);
+		std::clock_t start = std::clock();
+		Lines5d objectLines = ObjectReader::ReadObject(ObjectPath(objectPath, config.name, propName, propName));
+		double objectDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+		start = std::clock();
+		Lines5d lineSetLines = LineSetReader::ReadLineSet(LineSetPath(objectPath, config.name), propName, propName);
+		double lineSetDuration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
+		std::cout << "obj " << objectDuration << "s, line set " << lineSetDuration << "s, " << lineSetLines.size() << " lines\n\n";
+	}
+#endif
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// distance kernel benchmark -------------------------------------------------------------------------------------------------
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// rMCPD with kd-trees and with the brute force kernel
+#if 0
+	for (auto config : DistanceConfigurations)
+	{
+		std::cout << "Comparing distance kernels on: " << config.name << '\n';
+		CompareDistanceKernels(config, objectPath);
+		std::cout << "Finished comparison on: " << config.name << "\n\n";
+	}
+#endif
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// distance matrix conversion ------------------------------------------------------------------------------------------------
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// convert the text matrices of older runs to the condensed binary format and compare the load times
+#if 0
+	for (auto config : DistanceConfigurations)
+	{
+		std::cout << "Converting distance matrix: " << config.name << '\n';
+		ConvertDistanceMatrix(config, distPath);
+	}
+#endif
+
 	// ---------------------------------------------------------------------------------------------------------------------------
 	// print line data -----------------------------------------------------------------------------------------------------------
 	// ---------------------------------------------------------------------------------------------------------------------------
@@ -551,5 +902,33 @@ int main(int, char*[])
 	}
 #endif
 
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// integrator comparison -----------------------------------------------------------------------------------------------------
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// field samples per line of the fixed step and the adaptive integrator
+	// reuseing the extraction configuration -> tolerance and step bounds of the adaptive integrator are taken from the config
+#if 0
+	for (ExtractConfig& config : Configurations)
+	{
+		std::cout << "Comparing integrators on: " << config.name << '\n';
+		CompareIntegrators(config, amiraPath);
+		std::cout << "Finished comparison on: " << config.name << "\n\n";
+	}
+#endif
+
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// field layout benchmark ----------------------------------------------------------------------------------------------------
+	// ---------------------------------------------------------------------------------------------------------------------------
+	// tracing in the linear, bricked and morton ordered field, the converted fields are cached next to the amira files
+	// reuseing the extraction configuration
+#if 0
+	for (ExtractConfig& config : Configurations)
+	{
+		std::cout << "Comparing field layouts on: " << config.name << '\n';
+		CompareFieldLayouts(config, amiraPath);
+		std::cout << "Finished comparison on: " << config.name << "\n\n";
+	}
+#endif
+
 	return 0;
 }
\ No newline at end of file
@@ -384,6 +384,9 @@ void Renderer::Draw(ID3D11DeviceContext* ImmediateContext, D3D* D3D, Lines* Geom
 
 	const D3D11_VIEWPORT& fullViewport = D3D->GetFullViewport();
 
+	// level of detail of the lines for both passes, picked for the full resolution
+	Geometry->UpdateLevelOfDetail(ImmediateContext, Camera->GetParams().Data.mView, Camera->GetParams().Data.mProj, fullViewport.Height, _CbRenderer.Data.StripWidth);
+
 	// switch to smaller viewport resolution
 	D3D11_VIEWPORT smallViewport = fullViewport;
 	smallViewport.Width /= _ResolutionDownScale;
@@ -1,4 +1,5 @@
 #include "scene.hpp"
+#include "lineset.hpp"
 
 
 Scene::Scene(std::string path, std::string distanceMatrixPath, std::string seperator, int linkage): 
@@ -10,6 +11,15 @@ Scene::Scene(std::string path, std::string distanceMatrixPath, std::string seper
     for (const auto& entry : fs::directory_iterator(mDatasetPath))
 	{
 		const fs::path path = entry.path();
+		if (path.extension() == ".lines")
+		{
+			for (const DataDescription& desc : ParseLineSetProperties(path))
+			{
+				mDatasets.push_back(desc);
+				mDatasetNames.insert(desc.name);
+			}
+			continue;
+		}
 		const DataDescription desc = ParseDatasetName(path);
 		mDatasets.push_back(desc);
 		mDatasetNames.insert(desc.name);
@@ -28,6 +38,16 @@ Scene::Scene(std::string path, std::string distanceMatrixPath, std::string seper
 		for (const auto& entry : fs::directory_iterator(mDistanceMatrixPath))
 		{
 			const fs::path path = entry.path();
+			// only matrices and line graphs, the folder also holds the cached dendrograms
+			if (!entry.is_regular_file() || (path.extension() != ".dist" && path.extension() != ".distb" && path.extension() != ".knn"))
+			{
+				continue;
+			}
+			// a converted text matrix is listed once through its binary version
+			if (path.extension() == ".dist" && fs::exists(fs::path(path).replace_extension(".distb")))
+			{
+				continue;
+			}
 			const DistanceMatrixDescription desc = ParseDistanceMatrixName(path);
 			mDistanceMatrices.push_back(desc);
 		}
@@ -59,11 +79,37 @@ DataDescription Scene::ParseDatasetName(const fs::path& path)
 	return desc;
 }
 
+// example path = "benzene.lines" -> one description per importance / scalarColor combination of the stored properties
+std::vector<DataDescription> Scene::ParseLineSetProperties(const fs::path& path)
+{
+	std::vector<DataDescription> result;
+	LineSetFile file;
+	if (!file.Open(path.string()))
+	{
+		return result;
+	}
+
+	DataDescription desc;
+	desc.name = path.stem().string();
+	desc.extension = ".lines";
+	for (uint32_t i = 0; i < file.GetNumProperties(); i++)
+	{
+		for (uint32_t s = 0; s < file.GetNumProperties(); s++)
+		{
+			desc.importance = file.GetProperty(i).name;
+			desc.scalarColor = file.GetProperty(s).name;
+			result.push_back(desc);
+		}
+	}
+	return result;
+}
+
 // example path = "benzene_metric_somestuff.dist"
 DistanceMatrixDescription Scene::ParseDistanceMatrixName(const fs::path& path)
 {
 	std::vector<std::string> parsed = Scene::SplitString(path.filename().string(), mSeperator);
 	DistanceMatrixDescription desc;
+	desc.extension = path.extension().string();
 	
 	if (parsed.empty())
 	{
@@ -175,6 +221,19 @@ DistanceMatrixDescription Scene::GetFirstMatchingDistanceMatrix(std::string& nam
 	return DistanceMatrixDescription();
 }
 
+// the matrices of one dataset can have different formats (.dist, .distb, .knn) -> the extension belongs to the metric
+DistanceMatrixDescription Scene::GetFirstMatchingDistanceMatrix(std::string& name, std::string& metric)
+{
+	for (unsigned i = 0; i < mDistanceMatrices.size(); i++)
+	{
+		if (mDistanceMatrices[i].name == name && mDistanceMatrices[i].metric == metric)
+		{
+			return mDistanceMatrices[i];
+		}
+	}
+	return DistanceMatrixDescription();
+}
+
 // generalize these two maybe
 void Scene::RefreshCurrentDatasetImportance()
 {
@@ -215,6 +274,10 @@ void Scene::RefreshCurrentDistanceMatrixMetrics()
 std::string Scene::ConstructDatasetPath(DataDescription& data)
 {
 	std::string path = mDatasetPath + "\\" + data.name;
+	if (data.extension == ".lines")
+	{
+		return path + data.extension;
+	}
 	
 	if (data.importance != "Unknown")
 	{
@@ -236,6 +299,6 @@ std::string Scene::ConstructDistanceMatrixPath(DistanceMatrixDescription& data)
 	{
 		path += mSeperator + data.metric;
 	}
-	path += ".dist";
+	path += data.extension;
 	return path;
 }
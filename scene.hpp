@@ -14,15 +14,17 @@ struct DataDescription {
 	std::string name;
 	std::string importance;
 	std::string scalarColor;
-	DataDescription() : name("Unknown"), importance("Unknown"), scalarColor("Unknown")
+	std::string extension;		// ".obj" -> one file per importance / scalarColor, ".lines" -> one line set with all properties
+	DataDescription() : name("Unknown"), importance("Unknown"), scalarColor("Unknown"), extension(".obj")
 	{};
 };
 
 struct DistanceMatrixDescription {
 	std::string name;
 	std::string metric;
+	std::string extension;		// ".distb" -> condensed binary matrix, ".dist" -> alglib text matrix of older runs
 
-	DistanceMatrixDescription() : name("Unknown"), metric("Unknown")
+	DistanceMatrixDescription() : name("Unknown"), metric("Unknown"), extension(".dist")
 	{};
 };
 
@@ -43,6 +45,7 @@ public:
 	DistanceMatrixDescription& GetCurrentDistanceMatrix() { return mCurrentDistanceMatrix; }
 	void SetCurrentDistanceMatrix(DistanceMatrixDescription value) { mCurrentDistanceMatrix = value; }
 	DistanceMatrixDescription Scene::GetFirstMatchingDistanceMatrix(std::string& name);
+	DistanceMatrixDescription GetFirstMatchingDistanceMatrix(std::string& name, std::string& metric);
 
 
 	std::set<std::string>& GetDatasetNames() { return mDatasetNames; }
@@ -59,6 +62,7 @@ public:
 
 private:
 	DataDescription ParseDatasetName(const fs::path& path);
+	std::vector<DataDescription> ParseLineSetProperties(const fs::path& path);
 	DistanceMatrixDescription Scene::ParseDistanceMatrixName(const fs::path& path);
 
 	std::vector<std::string> SplitString(const std::string& str, const std::string& delimiter);